@@ -78,6 +78,8 @@ std::vector<uint8_t> generateCheckerboardImage( float checkerPercentage )
 
 Overlay_3D::Overlay_3D()
 	: active_view_( 0 )
+	, active_window_( 0 )
+	, frame_index_( 0 )
 	, overlay_texture_( -1 )
 	, HUD_color_texture_( -1 )
 	, HUD_FBO_( -1 )
@@ -257,10 +259,14 @@ void Overlay_3D::shutdown()
 }
 	
 void Overlay_3D::update(float frame_delta_time, void *param, unsigned int buffer_size_in_bytes )
-{ }
+{
+	++frame_index_;
+}
 
 void Overlay_3D::setActiveWindow( int window_id, int window_extents[2] )
-{ }
+{
+	active_window_ = window_id;
+}
 
 void Overlay_3D::setActiveView( int view_id, int viewport[4] )
 {
@@ -272,49 +278,49 @@ void Overlay_3D::setActiveView( int view_id, int viewport[4] )
 
 /*!
  * IMPLEMENTATION
- * Does the actual drawing to the screen. Some light openGL setup is done here.
+ * Does the actual drawing to the screen. Some light openGL setup is done here. Only the state
+ * changed here is restored afterwards; only the framebuffer binding is read back every frame.
 **/
 void Overlay_3D::draw()
 {
-	glPushAttrib( GL_ALL_ATTRIB_BITS );
-	glPushClientAttrib( GL_CLIENT_ALL_ATTRIB_BITS );
+	gl_state_.Begin( frame_index_, active_window_, active_view_ );
+	gl_state_.SeedViewport( viewport_ );
 
 	// set HUD FBO
-	GLint fbo = -1;
-	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &fbo );
-	glBindFramebuffer( GL_FRAMEBUFFER, HUD_FBO_ );
+	const GLuint scene_fbo = gl_state_.GetFramebuffer();
+	gl_state_.BindFramebuffer( HUD_FBO_ );
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// BEGIN draw to HUD FBO
 	// this is where the code to draw the HUD's content goes
 	// this is a simple example that draws a checkerboard pattern to the HUD FBO
 
-	glUseProgram(0);
+	gl_state_.UseProgram( 0 );
 
 	glPushMatrix(); // save scene matrices
 
 	// use ortho-matrix to draw to FOB like a 2D overlay on screen 
-	glMatrixMode(GL_PROJECTION);
+	gl_state_.MatrixMode( GL_PROJECTION );
 	glLoadIdentity();
 	glOrtho(0.0, HUD_pixel_width_, 0.0, HUD_pixel_height_, -1.0, 1.0);
-	glMatrixMode(GL_MODELVIEW);
+	gl_state_.MatrixMode( GL_MODELVIEW );
 	glLoadIdentity();
 
-	glDisable( GL_DEPTH_TEST );
-	glDepthMask( GL_FALSE );
-	glDisable( GL_LIGHTING );
-	glDisable( GL_ALPHA_TEST );
-	glDisable( GL_FOG );
-	glDisable( GL_CULL_FACE );
-	glDisable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
-	glDisable( GL_BLEND );
+	gl_state_.Disable( GL_DEPTH_TEST );
+	gl_state_.DepthMask( GL_FALSE );
+	gl_state_.Disable( GL_LIGHTING );
+	gl_state_.Disable( GL_ALPHA_TEST );
+	gl_state_.Disable( GL_FOG );
+	gl_state_.Disable( GL_CULL_FACE );
+	gl_state_.Disable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
+	gl_state_.Disable( GL_BLEND );
 
-	glEnable( GL_TEXTURE_2D );
-	glViewport( 0, 0, HUD_pixel_width_, HUD_pixel_height_ );
+	gl_state_.Enable( GL_TEXTURE_2D );
+	gl_state_.Viewport( 0, 0, HUD_pixel_width_, HUD_pixel_height_ );
 
-	glBindTexture( GL_TEXTURE_2D, overlay_texture_ );
+	gl_state_.BindTexture2D( overlay_texture_ );
 
-	glColor4f( 1.0f, 1.0f, 1.0f, 1.0f );
+	gl_state_.Color4f( 1.0f, 1.0f, 1.0f, 1.0f );
 	glBegin( GL_QUADS );
 	{
 		glTexCoord2f(0.0f, 0.0f); glVertex2f(0.0f, 0.0f); // Bottom-left
@@ -330,29 +336,30 @@ void Overlay_3D::draw()
 	/////////////////////////////////////////////////////////////////////////////////////
 
 	// unbind HUD FBO
-	glBindFramebuffer( GL_FRAMEBUFFER, fbo );
+	gl_state_.BindFramebuffer( scene_fbo );
 
 	// draw HUD texture to scene
 	// make sure, view matrix is in cockpit view
-	glUseProgram(0);
+	// the cache drops the state changes already made for the HUD pass
+	gl_state_.UseProgram( 0 );
 
-	glDisable( GL_DEPTH_TEST );
-	glDisable( GL_LIGHTING );
-	glDisable( GL_ALPHA_TEST );
-	glDisable( GL_FOG );
-	glDisable( GL_CULL_FACE );
-	glDisable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
+	gl_state_.Disable( GL_DEPTH_TEST );
+	gl_state_.Disable( GL_LIGHTING );
+	gl_state_.Disable( GL_ALPHA_TEST );
+	gl_state_.Disable( GL_FOG );
+	gl_state_.Disable( GL_CULL_FACE );
+	gl_state_.Disable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
 
-	glEnable( GL_TEXTURE_2D );
+	gl_state_.Enable( GL_TEXTURE_2D );
 
-	glEnable( GL_BLEND );
-	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
-	glDepthMask( GL_FALSE );
+	gl_state_.Enable( GL_BLEND );
+	gl_state_.BlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
+	gl_state_.DepthMask( GL_FALSE );
 
-	glViewport( viewport_[0], viewport_[1], viewport_[2], viewport_[3] );
+	gl_state_.Viewport( viewport_[0], viewport_[1], viewport_[2], viewport_[3] );
 
-	glBindTexture( GL_TEXTURE_2D, HUD_color_texture_ );
-	glColor4f( 1.0f, 1.0f, 1.0f, HUD_transparency_ );
+	gl_state_.BindTexture2D( HUD_color_texture_ );
+	gl_state_.Color4f( 1.0f, 1.0f, 1.0f, HUD_transparency_ );
 
 	//// DEBUG: get current matrix from GL
 	//GLfloat mm[16];
@@ -378,10 +385,7 @@ void Overlay_3D::draw()
 	}
 	glEnd();
 
-	glBindTexture( GL_TEXTURE_2D, 0 );
-
-	glPopClientAttrib();
-	glPopAttrib();
+	gl_state_.Restore();
 }
 
 void Overlay_3D::PostFrameDraw()
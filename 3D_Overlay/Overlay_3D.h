@@ -13,6 +13,8 @@
 
 #include <gig/GenesisIG_UserDefined_Overlay200.h>
 
+#include "GlStateCache.h"
+
 #include <memory>
 
 #ifndef LINUX_PORT
@@ -112,6 +114,8 @@ public:
 private:
 	int				viewport_[4];							/* Viewport: left, right, width, height */
 	int				active_view_;							/* Id of the active view */
+	int				active_window_;							/* Id of the active window */
+	unsigned int	frame_index_;							/* Frames seen by update, the state cache's frame boundary */
 	unsigned int	overlay_texture_;
 	unsigned int	HUD_FBO_;
 	unsigned int	HUD_color_texture_;
@@ -122,6 +126,7 @@ private:
 	float			HUD_tr_[3]; // top-right corner of HUD
 	float			HUD_bl_[3]; // bottom-left corner of HUD
 	float			HUD_br_[3]; // bottom-right corner of HUD
+	GlStateCache	gl_state_;	// state draw() changes, restored without an attribute push
 };
 
 #ifdef __cplusplus
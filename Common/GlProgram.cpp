@@ -0,0 +1,138 @@
+//==============================================================================
+// File:GlProgram.cpp
+//==============================================================================
+
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	GLuint CompileShader( const char* name, GLenum type, const char* source )
+	{
+		GLuint shader = glCreateShader( type );
+		glShaderSource( shader, 1, &source, nullptr );
+		glCompileShader( shader );
+
+		GLint compiled = GL_FALSE;
+		glGetShaderiv( shader, GL_COMPILE_STATUS, &compiled );
+		if ( GL_TRUE != compiled )
+		{
+			GLint length = 0;
+			glGetShaderiv( shader, GL_INFO_LOG_LENGTH, &length );
+			std::vector<char> log( length + 1, 0 );
+			glGetShaderInfoLog( shader, length, nullptr, &log[0] );
+			std::cout << "FATAL ERROR: " << name << ( GL_VERTEX_SHADER == type ? " vertex" : GL_COMPUTE_SHADER == type ? " compute" : " fragment" )
+				<< " shader failed to compile:\n" << &log[0] << std::endl;
+			glDeleteShader( shader );
+			return 0;
+		}
+		return shader;
+	}
+
+	/*! Links and then deletes the shaders. **/
+	GLuint LinkShaders( const char* name, const GLuint* shaders, int count, bool retrievable )
+	{
+		GLuint program = glCreateProgram();
+		if ( retrievable )
+			glProgramParameteri( program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE );
+		for ( int i = 0; i < count; ++i )
+			glAttachShader( program, shaders[i] );
+		glLinkProgram( program );
+		for ( int i = 0; i < count; ++i )
+		{
+			glDetachShader( program, shaders[i] );
+			glDeleteShader( shaders[i] );
+		}
+
+		GLint linked = GL_FALSE;
+		glGetProgramiv( program, GL_LINK_STATUS, &linked );
+		if ( GL_TRUE != linked )
+		{
+			GLint length = 0;
+			glGetProgramiv( program, GL_INFO_LOG_LENGTH, &length );
+			std::vector<char> log( length + 1, 0 );
+			glGetProgramInfoLog( program, length, nullptr, &log[0] );
+			std::cout << "FATAL ERROR: " << name << " program failed to link:\n" << &log[0] << std::endl;
+			glDeleteProgram( program );
+			return 0;
+		}
+		return program;
+	}
+}
+
+GlProgram::GlProgram()
+	: program_( 0 )
+{
+}
+
+GlProgram::~GlProgram()
+{
+	// no context guaranteed here, Release() is the owner's job
+}
+
+bool GlProgram::Build( const char* name, const char* vertex_source, const char* fragment_source )
+{
+	Release();
+	program_ = Link( name, vertex_source, fragment_source, false );
+	return IsValid();
+}
+
+void GlProgram::Request( GlProgramCache& cache, const char* name, const char* vertex_source, const char* fragment_source )
+{
+	Release();
+	request_ = cache.Request( name, vertex_source, fragment_source );
+	TakeReady();
+}
+
+void GlProgram::RequestCompute( GlProgramCache& cache, const char* name, const char* compute_source )
+{
+	Release();
+	request_ = cache.RequestCompute( name, compute_source );
+	TakeReady();
+}
+
+bool GlProgram::TakeReady()
+{
+	if ( !request_ )
+		return false;
+
+	GLuint program = 0;
+	if ( !GlProgramCache::Take( *request_, program ) )
+		return false;
+
+	request_.reset();
+	program_ = program;
+	return IsValid();
+}
+
+void GlProgram::Release()
+{
+	if ( request_ )
+		GlProgramCache::Abandon( *request_ );
+	request_.reset();
+
+	if ( program_ )
+		glDeleteProgram( program_ );
+	program_ = 0;
+}
+
+GLuint GlProgram::Link( const char* name, const char* vertex_source, const char* fragment_source, bool retrievable )
+{
+	GLuint shaders[2] = { CompileShader( name, GL_VERTEX_SHADER, vertex_source ), CompileShader( name, GL_FRAGMENT_SHADER, fragment_source ) };
+	if ( 0 == shaders[0] || 0 == shaders[1] )
+	{
+		if ( shaders[0] ) glDeleteShader( shaders[0] );
+		if ( shaders[1] ) glDeleteShader( shaders[1] );
+		return 0;
+	}
+	return LinkShaders( name, shaders, 2, retrievable );
+}
+
+GLuint GlProgram::LinkCompute( const char* name, const char* compute_source, bool retrievable )
+{
+	GLuint compute_shader = CompileShader( name, GL_COMPUTE_SHADER, compute_source );
+	return compute_shader ? LinkShaders( name, &compute_shader, 1, retrievable ) : 0;
+}
@@ -0,0 +1,94 @@
+//==============================================================================
+// File:GlProgram.h
+//==============================================================================
+//
+// Description: Compiles and links a GLSL program from source strings and logs
+//				compiler and linker errors with the plugin's name. Programs can
+//				also be requested through a GlProgramCache, which loads them as
+//				binaries or compiles them in the background.
+//
+//==============================================================================
+
+#ifndef DVC_GL_PROGRAM_H
+#define DVC_GL_PROGRAM_H
+
+#include "GL/glew.h"
+
+#include <memory>
+
+class GlProgramCache;
+struct GlProgramRequest;
+
+enum GlProgramKind
+{
+	PROGRAM_GRAPHICS,	/* vertex and fragment shader */
+	PROGRAM_COMPUTE
+};
+
+class GlProgram
+{
+public:
+	GlProgram();
+	~GlProgram();
+
+	/*!
+	 * Builds the program, replacing a previous one. Needs a current context.
+	 *
+	 * @param[in] name : used in error messages
+	 *
+	 * @return
+	 *  false if compiling or linking failed, the program is empty then.
+	**/
+	bool Build( const char* name, const char* vertex_source, const char* fragment_source );
+
+	/*!
+	 * Requests the program from a cache, replacing a previous one. It becomes valid in a later
+	 * TakeReady(), or right away when the cache has a current binary.
+	**/
+	void Request( GlProgramCache& cache, const char* name, const char* vertex_source, const char* fragment_source );
+
+	/*!
+	 * Requests a compute program from a cache, see Request. Needs GL 4.3 or ARB_compute_shader.
+	**/
+	void RequestCompute( GlProgramCache& cache, const char* name, const char* compute_source );
+
+	/*!
+	 * Takes over a requested program once it is complete. Needs a current context.
+	 *
+	 * @return
+	 *  true once, in the call the program became valid: look the uniforms up then.
+	**/
+	bool TakeReady();
+
+	/*!
+	 * Deletes the program, or abandons a pending request. Needs a current context.
+	**/
+	void Release();
+
+	GLuint GetId() const { return program_; }
+	bool IsValid() const { return 0 != program_; }
+	bool IsPending() const { return nullptr != request_; }
+
+	/*! Looks a uniform up, cache the result: this is a driver round-trip. **/
+	GLint GetUniform( const char* name ) const { return glGetUniformLocation( program_, name ); }
+
+	/*!
+	 * Compiles and links a program, with the binary retrievable if asked.
+	 *
+	 * @return
+	 *  0 if compiling or linking failed, the errors are logged.
+	**/
+	static GLuint Link( const char* name, const char* vertex_source, const char* fragment_source, bool retrievable );
+
+	/*! Link for a compute program. **/
+	static GLuint LinkCompute( const char* name, const char* compute_source, bool retrievable );
+
+private:
+	GlProgram( const GlProgram& );
+	GlProgram& operator=( const GlProgram& );
+
+	GLuint program_;
+	std::shared_ptr<GlProgramRequest> request_;	/* pending in a GlProgramCache */
+};
+
+#endif // DVC_GL_PROGRAM_H
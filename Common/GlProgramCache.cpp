@@ -0,0 +1,365 @@
+//==============================================================================
+// File:GlProgramCache.cpp
+//==============================================================================
+
+#include "GlProgramCache.h"
+#include "GlProgram.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined( _WIN32 )
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <sys/stat.h>
+#endif
+
+namespace
+{
+	const char kMagic[4] = { 'D', 'V', 'P', 'B' };
+	const GLuint kVersion = 1;
+
+	struct BinaryHeader
+	{
+		char magic[4];
+		GLuint version;
+		GLenum format;
+		GLint length;			/* of the binary, after the identity */
+		GLuint identity_length;	/* of the driver identity, right after the header */
+	};
+
+	// FNV-1a, over the driver identity and both sources
+	unsigned long long Hash( unsigned long long hash, const char* text, size_t length )
+	{
+		for ( size_t i = 0; i < length; ++i )
+		{
+			hash ^= (unsigned char)text[i];
+			hash *= 0x100000001b3ULL;
+		}
+		return hash;
+	}
+
+	std::string GetString( GLenum name )
+	{
+		const GLubyte* value = glGetString( name );
+		return value ? (const char*)value : "";
+	}
+
+	void CreateDirectories( const std::string& directory )
+	{
+		for ( size_t slash = directory.find_first_of( "\\/", 1 ); ; slash = directory.find_first_of( "\\/", slash + 1 ) )
+		{
+			const std::string parent = directory.substr( 0, slash );
+#if defined( _WIN32 )
+			CreateDirectoryA( parent.c_str(), nullptr );
+#else
+			mkdir( parent.c_str(), 0755 );
+#endif
+			if ( std::string::npos == slash )
+				break;
+		}
+	}
+
+	bool IsSignaled( GLsync fence )
+	{
+		const GLenum result = glClientWaitSync( fence, 0, 0 );
+		return GL_ALREADY_SIGNALED == result || GL_CONDITION_SATISFIED == result;
+	}
+}
+
+GlProgramCache::GlProgramCache()
+	: dc_( nullptr )
+	, worker_context_( nullptr )
+	, stopping_( false )
+{
+}
+
+GlProgramCache::~GlProgramCache()
+{
+	// no context guaranteed here, Stop() is the owner's job
+}
+
+bool GlProgramCache::Start( const std::string& directory, bool background )
+{
+	Stop();
+
+	GLint formats = 0;
+	glGetIntegerv( GL_NUM_PROGRAM_BINARY_FORMATS, &formats );
+	identity_ = GetString( GL_VENDOR ) + "|" + GetString( GL_RENDERER ) + "|" + GetString( GL_VERSION ) + "|" + GetString( GL_SHADING_LANGUAGE_VERSION );
+	directory_ = formats > 0 ? directory : std::string();
+	if ( 0 == formats )
+		std::cout << "Warning: the driver offers no program binary formats, programs are compiled on every start." << std::endl;
+	else if ( !directory_.empty() )
+	{
+		CreateDirectories( directory_ );
+		std::cout << "Info: program binaries are cached in " << directory_ << std::endl;
+	}
+
+#if defined( _WIN32 )
+	if ( background )
+	{
+		// a fresh context, so sharing with the caller's is always allowed
+		HDC dc = wglGetCurrentDC();
+		HGLRC context = wglGetCurrentContext();
+		HGLRC worker_context = dc && context ? wglCreateContext( dc ) : nullptr;
+		if ( nullptr == worker_context || !wglShareLists( context, worker_context ) )
+		{
+			std::cout << "Warning: could not create a shared GL context, programs are compiled in place." << std::endl;
+			if ( worker_context )
+				wglDeleteContext( worker_context );
+		}
+		else
+		{
+			dc_ = dc;
+			worker_context_ = worker_context;
+			stopping_ = false;
+			thread_ = std::thread( &GlProgramCache::Run, this );
+		}
+	}
+#else
+	(void)background;
+#endif
+	return !directory_.empty();
+}
+
+void GlProgramCache::Stop()
+{
+	if ( thread_.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex_ );
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		thread_.join();
+	}
+	queue_.clear();
+
+#if defined( _WIN32 )
+	if ( worker_context_ )
+		wglDeleteContext( (HGLRC)worker_context_ );
+#endif
+	dc_ = nullptr;
+	worker_context_ = nullptr;
+}
+
+std::shared_ptr<GlProgramRequest> GlProgramCache::Request( const char* name, const char* vertex_source, const char* fragment_source )
+{
+	std::shared_ptr<GlProgramRequest> request( new GlProgramRequest );
+	request->name = name;
+	request->kind = PROGRAM_GRAPHICS;
+	request->vertex_source = vertex_source;
+	request->fragment_source = fragment_source;
+	return Submit( request );
+}
+
+std::shared_ptr<GlProgramRequest> GlProgramCache::RequestCompute( const char* name, const char* compute_source )
+{
+	std::shared_ptr<GlProgramRequest> request( new GlProgramRequest );
+	request->name = name;
+	request->kind = PROGRAM_COMPUTE;
+	request->compute_source = compute_source;
+	return Submit( request );
+}
+
+std::shared_ptr<GlProgramRequest> GlProgramCache::Submit( const std::shared_ptr<GlProgramRequest>& request )
+{
+	request->path = GetPath( *request );
+	request->done = false;
+	request->abandoned = false;
+	request->program = 0;
+	request->fence = 0;
+
+	// a current binary loads quickly enough to do it here
+	request->program = LoadBinary( *request );
+	if ( request->program || nullptr == worker_context_ )
+	{
+		if ( 0 == request->program )
+			request->program = Build( *request );
+		request->done = true;
+		return request;
+	}
+
+	std::cout << "Info: compiling " << request->name << " in the background, there is no current program binary." << std::endl;
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		queue_.push_back( request );
+	}
+	wake_.notify_one();
+	return request;
+}
+
+bool GlProgramCache::Take( GlProgramRequest& request, GLuint& program )
+{
+	std::lock_guard<std::mutex> lock( request.mutex );
+	if ( !request.done || ( request.fence && !IsSignaled( request.fence ) ) )
+		return false;
+
+	if ( request.fence )
+		glDeleteSync( request.fence );
+	request.fence = 0;
+	program = request.program;
+	request.program = 0;
+	return true;
+}
+
+void GlProgramCache::Abandon( GlProgramRequest& request )
+{
+	std::lock_guard<std::mutex> lock( request.mutex );
+	request.abandoned = true;
+	if ( !request.done )
+		return;
+
+	if ( request.fence )
+		glDeleteSync( request.fence );
+	if ( request.program )
+		glDeleteProgram( request.program );
+	request.fence = 0;
+	request.program = 0;
+}
+
+std::string GlProgramCache::GetPath( const GlProgramRequest& request ) const
+{
+	if ( directory_.empty() )
+		return std::string();
+
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	hash = Hash( hash, identity_.c_str(), identity_.size() + 1 );
+	hash = Hash( hash, (const char*)&request.kind, sizeof( request.kind ) );
+	hash = Hash( hash, request.vertex_source.c_str(), request.vertex_source.size() + 1 );
+	hash = Hash( hash, request.fragment_source.c_str(), request.fragment_source.size() + 1 );
+	hash = Hash( hash, request.compute_source.c_str(), request.compute_source.size() + 1 );
+
+	char file[32] = { 0 };
+	snprintf( file, sizeof( file ), "%016llx.bin", hash );
+	return directory_ + "/" + file;
+}
+
+GLuint GlProgramCache::LoadBinary( const GlProgramRequest& request ) const
+{
+	if ( request.path.empty() )
+		return 0;
+
+	std::ifstream file( request.path.c_str(), std::ios::binary );
+	BinaryHeader header;
+	if ( !file.read( (char*)&header, sizeof( header ) ) || 0 != memcmp( header.magic, kMagic, sizeof( kMagic ) )
+		|| kVersion != header.version || header.length <= 0 || header.identity_length != identity_.size() )
+		return 0;
+
+	std::vector<char> identity( header.identity_length );
+	std::vector<char> binary( header.length );
+	if ( !file.read( &identity[0], identity.size() ) || 0 != identity_.compare( 0, identity.size(), &identity[0], identity.size() )
+		|| !file.read( &binary[0], binary.size() ) )
+		return 0;
+
+	// the driver may still reject it, e.g. after an update that kept the version string
+	GLuint program = glCreateProgram();
+	glProgramBinary( program, header.format, &binary[0], header.length );
+	GLint linked = GL_FALSE;
+	glGetProgramiv( program, GL_LINK_STATUS, &linked );
+	if ( GL_TRUE != linked )
+	{
+		glDeleteProgram( program );
+		return 0;
+	}
+	return program;
+}
+
+void GlProgramCache::StoreBinary( const GlProgramRequest& request, GLuint program ) const
+{
+	GLint length = 0;
+	glGetProgramiv( program, GL_PROGRAM_BINARY_LENGTH, &length );
+	if ( length <= 0 )
+		return;
+
+	BinaryHeader header;
+	memcpy( header.magic, kMagic, sizeof( kMagic ) );
+	header.version = kVersion;
+	header.identity_length = (GLuint)identity_.size();
+	std::vector<char> binary( length );
+	glGetProgramBinary( program, length, &header.length, &header.format, &binary[0] );
+
+	// written aside and renamed, so a concurrent reader never sees half a file
+	const std::string temporary = request.path + ".tmp";
+	{
+		std::ofstream file( temporary.c_str(), std::ios::binary | std::ios::trunc );
+		file.write( (const char*)&header, sizeof( header ) );
+		file.write( identity_.c_str(), identity_.size() );
+		file.write( &binary[0], header.length );
+		if ( !file )
+		{
+			std::cout << "Warning: could not write the program binary " << temporary << std::endl;
+			return;
+		}
+	}
+	remove( request.path.c_str() );
+	if ( 0 != rename( temporary.c_str(), request.path.c_str() ) )
+		remove( temporary.c_str() );
+}
+
+GLuint GlProgramCache::Build( const GlProgramRequest& request ) const
+{
+	GLuint program = PROGRAM_COMPUTE == request.kind
+		? GlProgram::LinkCompute( request.name.c_str(), request.compute_source.c_str(), !request.path.empty() )
+		: GlProgram::Link( request.name.c_str(), request.vertex_source.c_str(), request.fragment_source.c_str(), !request.path.empty() );
+	if ( program && !request.path.empty() )
+		StoreBinary( request, program );
+	return program;
+}
+
+void GlProgramCache::Run()
+{
+#if defined( _WIN32 )
+	if ( !wglMakeCurrent( (HDC)dc_, (HGLRC)worker_context_ ) )
+	{
+		std::cout << "Warning: could not activate the shared GL context, background compiles are off." << std::endl;
+		return;
+	}
+#endif
+
+	for ( ;; )
+	{
+		std::shared_ptr<GlProgramRequest> request;
+		{
+			std::unique_lock<std::mutex> lock( mutex_ );
+			wake_.wait( lock, [this]() { return stopping_ || !queue_.empty(); } );
+			if ( stopping_ )
+				break;
+			request = queue_.front();
+			queue_.pop_front();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock( request->mutex );
+			if ( request->abandoned )
+				continue;
+		}
+
+		// an earlier request for the same sources may have stored the binary meanwhile
+		GLuint program = LoadBinary( *request );
+		if ( 0 == program )
+			program = Build( *request );
+		GLsync fence = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+		glFlush();
+
+		std::lock_guard<std::mutex> lock( request->mutex );
+		if ( request->abandoned )
+		{
+			glDeleteSync( fence );
+			if ( program )
+				glDeleteProgram( program );
+			continue;
+		}
+		request->program = program;
+		request->fence = fence;
+		request->done = true;
+	}
+
+#if defined( _WIN32 )
+	wglMakeCurrent( nullptr, nullptr );
+#endif
+}
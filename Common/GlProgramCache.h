@@ -0,0 +1,116 @@
+//==============================================================================
+// File:GlProgramCache.h
+//==============================================================================
+//
+// Description: Keeps linked programs on disk as glGetProgramBinary blobs, keyed
+//				by the driver (vendor, renderer, version) and the program's
+//				sources, so later starts skip the compiler. Programs without a
+//				current binary are compiled on a thread with its own context
+//				sharing objects with the caller's, and picked up once the GPU
+//				has them. Without that context they are compiled in place.
+//
+//==============================================================================
+
+#ifndef DVC_GL_PROGRAM_CACHE_H
+#define DVC_GL_PROGRAM_CACHE_H
+
+#include "GL/glew.h"
+#include "GlProgram.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/*!
+ * A program on its way, shared between the requesting GlProgram and the compile thread.
+**/
+struct GlProgramRequest
+{
+	std::string name;
+	GlProgramKind kind;
+	std::string vertex_source;		/* of a PROGRAM_GRAPHICS */
+	std::string fragment_source;
+	std::string compute_source;		/* of a PROGRAM_COMPUTE */
+	std::string path;		/* binary on disk, empty if binaries are not cached */
+
+	std::mutex mutex;		/* guards the members below */
+	bool done;
+	bool abandoned;			/* the requester has let go, the program is deleted when done */
+	GLuint program;			/* 0 if building failed */
+	GLsync fence;			/* set when built on the compile thread's context */
+};
+
+class GlProgramCache
+{
+public:
+	GlProgramCache();
+	~GlProgramCache();
+
+	/*!
+	 * Reads the driver's identity and, with background set, starts the compile thread with a
+	 * context sharing objects with the current one. Needs a current context.
+	 *
+	 * @param[in] directory : where binaries are kept, created if missing. Empty disables the disk cache.
+	 *
+	 * @return
+	 *  false if binaries are not cached, programs are compiled on every start then.
+	**/
+	bool Start( const std::string& directory, bool background );
+
+	/*!
+	 * Stops the compile thread, requests still queued never complete. Needs the context Start had.
+	**/
+	void Stop();
+
+	/*!
+	 * Loads the program from a current binary if there is one, otherwise compiles it, on the
+	 * compile thread when it runs. Needs a current context.
+	**/
+	std::shared_ptr<GlProgramRequest> Request( const char* name, const char* vertex_source, const char* fragment_source );
+
+	/*!
+	 * Request for a compute program.
+	**/
+	std::shared_ptr<GlProgramRequest> RequestCompute( const char* name, const char* compute_source );
+
+	/*!
+	 * Hands over a finished program. Needs a current context.
+	 *
+	 * @return
+	 *  false while the request is still running. program is 0 if it failed.
+	**/
+	static bool Take( GlProgramRequest& request, GLuint& program );
+
+	/*!
+	 * Lets go of a request, its program is deleted whenever it is done.
+	**/
+	static void Abandon( GlProgramRequest& request );
+
+private:
+	GlProgramCache( const GlProgramCache& );
+	GlProgramCache& operator=( const GlProgramCache& );
+
+	std::shared_ptr<GlProgramRequest> Submit( const std::shared_ptr<GlProgramRequest>& request );
+	std::string GetPath( const GlProgramRequest& request ) const;
+	GLuint LoadBinary( const GlProgramRequest& request ) const;
+	void StoreBinary( const GlProgramRequest& request, GLuint program ) const;
+	GLuint Build( const GlProgramRequest& request ) const;
+	void Run();
+
+	std::string directory_;
+	std::string identity_;		/* vendor, renderer and version of the driver */
+
+	void* dc_;					/* HDC and HGLRC of the compile thread, Windows only */
+	void* worker_context_;
+	std::thread thread_;
+
+	std::mutex mutex_;			/* guards queue_ and stopping_ */
+	std::condition_variable wake_;
+	std::deque<std::shared_ptr<GlProgramRequest> > queue_;
+	bool stopping_;
+};
+
+#endif // DVC_GL_PROGRAM_CACHE_H
@@ -0,0 +1,403 @@
+//==============================================================================
+// File:GlStateCache.cpp
+//==============================================================================
+
+#include "GlStateCache.h"
+
+#include <cstring>
+
+namespace
+{
+	// groups, indexed by slot
+	const unsigned int kSlotGroups[] =
+	{
+		GlStateCache::GROUP_FRAMEBUFFER,
+		GlStateCache::GROUP_VIEWPORT,
+		GlStateCache::GROUP_RASTER,
+		GlStateCache::GROUP_PROGRAM,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_TEXTURE,
+		GlStateCache::GROUP_VERTEX_ARRAY,
+		GlStateCache::GROUP_VERTEX_ARRAY,
+		GlStateCache::GROUP_BUFFER,
+		GlStateCache::GROUP_BUFFER,
+		GlStateCache::GROUP_BLEND,
+		GlStateCache::GROUP_DEPTH,
+		GlStateCache::GROUP_FIXED_FUNCTION,
+		GlStateCache::GROUP_FIXED_FUNCTION,
+		GlStateCache::GROUP_FRAMEBUFFER,
+		GlStateCache::GROUP_BLEND,
+		GlStateCache::GROUP_DEPTH,
+		GlStateCache::GROUP_RASTER,
+		GlStateCache::GROUP_RASTER,
+		GlStateCache::GROUP_RASTER,
+		GlStateCache::GROUP_FIXED_FUNCTION,
+		GlStateCache::GROUP_FIXED_FUNCTION,
+		GlStateCache::GROUP_FIXED_FUNCTION,
+		GlStateCache::GROUP_RASTER,
+	};
+
+	// capabilities, indexed from the first capability slot (SLOT_BLEND)
+	const GLenum kCaps[] =
+	{
+		GL_BLEND,
+		GL_DEPTH_TEST,
+		GL_CULL_FACE,
+		GL_ALPHA_TEST,
+		GL_SAMPLE_ALPHA_TO_COVERAGE_ARB,
+		GL_LIGHTING,
+		GL_FOG,
+		GL_TEXTURE_2D,
+		GL_SCISSOR_TEST
+	};
+}
+
+GlStateCache::GlStateCache()
+	: begun_( false )
+	, frame_index_( 0 )
+	, window_id_( 0 )
+	, view_id_( 0 )
+{
+	Invalidate();
+}
+
+void GlStateCache::Invalidate( unsigned int groups )
+{
+	for ( int slot = 0; slot < SLOT_COUNT; ++slot )
+	{
+		if ( !( kSlotGroups[slot] & groups ) )
+			continue;
+		states_[slot].known = false;
+		states_[slot].valid = false;
+		states_[slot].changed = false;
+	}
+}
+
+void GlStateCache::SeedViewport( const int viewport[4] )
+{
+	State& state = states_[SLOT_VIEWPORT];
+	for ( int i = 0; i < 4; ++i )
+		state.original.i[i] = viewport[i];
+	state.current = state.original;
+	state.known = true;
+	state.valid = true;
+	state.changed = false;
+}
+
+void GlStateCache::SeedFramebuffer( GLuint framebuffer )
+{
+	State& state = states_[SLOT_FRAMEBUFFER];
+	state.original.i[0] = state.current.i[0] = (GLint)framebuffer;
+	state.known = true;
+	state.valid = true;
+	state.changed = false;
+}
+
+void GlStateCache::Begin( unsigned int frame_index, int window_id, int view_id )
+{
+	// between callbacks the IG puts back its own state, only the framebuffer and viewport move on
+	if ( !begun_ || frame_index != frame_index_ || window_id != window_id_ || view_id != view_id_ )
+		Invalidate( GROUP_FRAMEBUFFER | GROUP_VIEWPORT );
+	begun_ = true;
+	frame_index_ = frame_index;
+	window_id_ = window_id;
+	view_id_ = view_id;
+
+	for ( int slot = 0; slot < SLOT_COUNT; ++slot )
+	{
+		State& state = states_[slot];
+		if ( !state.known )
+			continue;
+		state.current = state.original;
+		state.valid = true;
+		state.changed = false;
+	}
+}
+
+void GlStateCache::Restore()
+{
+	for ( int slot = 0; slot < SLOT_COUNT; ++slot )
+	{
+		State& state = states_[slot];
+		if ( !state.changed )
+			continue;
+		if ( !state.valid || 0 != memcmp( &state.current, &state.original, ValueCount( (Slot)slot ) * sizeof( GLint ) ) )
+			Apply( (Slot)slot, state.original );
+		state.current = state.original;
+		state.valid = true;
+		state.changed = false;
+	}
+}
+
+void GlStateCache::Touch( unsigned int groups )
+{
+	for ( int slot = 0; slot < SLOT_COUNT; ++slot )
+	{
+		if ( !( kSlotGroups[slot] & groups ) )
+			continue;
+		Load( (Slot)slot );
+		states_[slot].valid = false;
+		states_[slot].changed = true;
+	}
+}
+
+GLuint GlStateCache::GetFramebuffer()
+{
+	Load( SLOT_FRAMEBUFFER );
+	return (GLuint)states_[SLOT_FRAMEBUFFER].original.i[0];
+}
+
+void GlStateCache::Enable( GLenum cap )
+{
+	Set( CapSlot( cap ), 1 );
+}
+
+void GlStateCache::Disable( GLenum cap )
+{
+	Set( CapSlot( cap ), 0 );
+}
+
+void GlStateCache::BindFramebuffer( GLuint framebuffer )
+{
+	Set( SLOT_FRAMEBUFFER, (GLint)framebuffer );
+}
+
+void GlStateCache::Viewport( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+	const Values values = { { x, y, width, height } };
+	Set( SLOT_VIEWPORT, values );
+}
+
+void GlStateCache::Scissor( GLint x, GLint y, GLsizei width, GLsizei height )
+{
+	const Values values = { { x, y, width, height } };
+	Set( SLOT_SCISSOR, values );
+}
+
+void GlStateCache::UseProgram( GLuint program )
+{
+	Set( SLOT_PROGRAM, (GLint)program );
+}
+
+void GlStateCache::BindTexture2D( GLuint texture )
+{
+	Set( SLOT_TEXTURE_2D, (GLint)texture );
+}
+
+void GlStateCache::BindMultiTexture2D( GLuint unit, GLuint texture )
+{
+	if ( unit < 1 || unit > 6 || 4 == unit )
+		return;
+	Set( (Slot)( unit < 4 ? SLOT_TEXTURE_2D_UNIT1 + unit - 1 : SLOT_TEXTURE_2D_UNIT5 + unit - 5 ), (GLint)texture );
+}
+
+void GlStateCache::BindMultiTextureCube( GLuint texture )
+{
+	Set( SLOT_TEXTURE_CUBE_UNIT4, (GLint)texture );
+}
+
+void GlStateCache::BindMultiTexture2DArray( GLuint texture )
+{
+	Set( SLOT_TEXTURE_2D_ARRAY_UNIT1, (GLint)texture );
+}
+
+void GlStateCache::BindVertexArray( GLuint vertex_array )
+{
+	Set( SLOT_VERTEX_ARRAY, (GLint)vertex_array );
+}
+
+void GlStateCache::BindStorageBufferRange( GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size )
+{
+	// an indexed binding is not tracked, but it replaces the generic one, which Restore puts back
+	Load( SLOT_SHADER_STORAGE_BUFFER );
+	if ( 0 == size )
+		glBindBufferBase( GL_SHADER_STORAGE_BUFFER, index, buffer );
+	else
+		glBindBufferRange( GL_SHADER_STORAGE_BUFFER, index, buffer, offset, size );
+
+	State& state = states_[SLOT_SHADER_STORAGE_BUFFER];
+	state.current.i[0] = (GLint)buffer;
+	state.valid = true;
+	state.changed = true;
+}
+
+void GlStateCache::BindPixelPackBuffer( GLuint buffer )
+{
+	Set( SLOT_PIXEL_PACK_BUFFER, (GLint)buffer );
+}
+
+void GlStateCache::BlendFunc( GLenum sfactor, GLenum dfactor )
+{
+	const Values values = { { (GLint)sfactor, (GLint)dfactor, (GLint)sfactor, (GLint)dfactor } };
+	Set( SLOT_BLEND_FUNC, values );
+}
+
+void GlStateCache::DepthMask( GLboolean flag )
+{
+	Set( SLOT_DEPTH_MASK, flag ? 1 : 0 );
+}
+
+void GlStateCache::MatrixMode( GLenum mode )
+{
+	Set( SLOT_MATRIX_MODE, (GLint)mode );
+}
+
+void GlStateCache::Color4f( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha )
+{
+	Values values;
+	values.f[0] = red;
+	values.f[1] = green;
+	values.f[2] = blue;
+	values.f[3] = alpha;
+	Set( SLOT_COLOR, values );
+}
+
+void GlStateCache::ClearColor( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha )
+{
+	Values values;
+	values.f[0] = red;
+	values.f[1] = green;
+	values.f[2] = blue;
+	values.f[3] = alpha;
+	Set( SLOT_CLEAR_COLOR, values );
+}
+
+int GlStateCache::ValueCount( Slot slot )
+{
+	return SLOT_VIEWPORT == slot || SLOT_SCISSOR == slot || SLOT_BLEND_FUNC == slot || SLOT_COLOR == slot || SLOT_CLEAR_COLOR == slot ? 4 : 1;
+}
+
+GlStateCache::Slot GlStateCache::CapSlot( GLenum cap )
+{
+	for ( int i = 0; i < (int)( sizeof( kCaps ) / sizeof( kCaps[0] ) ); ++i )
+	{
+		if ( kCaps[i] == cap )
+			return (Slot)( SLOT_BLEND + i );
+	}
+	return SLOT_COUNT;
+}
+
+void GlStateCache::Load( Slot slot )
+{
+	State& state = states_[slot];
+	if ( state.known )
+		return;
+
+	GLint* values = state.original.i;
+	values[0] = values[1] = values[2] = values[3] = 0;
+	switch ( slot )
+	{
+	case SLOT_FRAMEBUFFER:		glGetIntegerv( GL_FRAMEBUFFER_BINDING, values );		break;
+	case SLOT_VIEWPORT:			glGetIntegerv( GL_VIEWPORT, values );					break;
+	case SLOT_SCISSOR:			glGetIntegerv( GL_SCISSOR_BOX, values );				break;
+	case SLOT_PROGRAM:			glGetIntegerv( GL_CURRENT_PROGRAM, values );			break;
+	case SLOT_ACTIVE_TEXTURE:	glGetIntegerv( GL_ACTIVE_TEXTURE, values );				break;
+	case SLOT_TEXTURE_2D:		glGetIntegerv( GL_TEXTURE_BINDING_2D, values );			break;
+	case SLOT_TEXTURE_2D_UNIT1:
+	case SLOT_TEXTURE_2D_UNIT2:
+	case SLOT_TEXTURE_2D_UNIT3:
+		glGetIntegerIndexedvEXT( GL_TEXTURE_BINDING_2D, slot - SLOT_TEXTURE_2D_UNIT1 + 1, values );
+		break;
+	case SLOT_TEXTURE_CUBE_UNIT4:	glGetIntegerIndexedvEXT( GL_TEXTURE_BINDING_CUBE_MAP, 4, values );	break;
+	case SLOT_TEXTURE_2D_UNIT5:
+	case SLOT_TEXTURE_2D_UNIT6:
+		glGetIntegerIndexedvEXT( GL_TEXTURE_BINDING_2D, slot - SLOT_TEXTURE_2D_UNIT5 + 5, values );
+		break;
+	case SLOT_TEXTURE_2D_ARRAY_UNIT1:	glGetIntegerIndexedvEXT( GL_TEXTURE_BINDING_2D_ARRAY, 1, values );	break;
+	case SLOT_VERTEX_ARRAY:		glGetIntegerv( GL_VERTEX_ARRAY_BINDING, values );		break;
+	case SLOT_ARRAY_BUFFER:		glGetIntegerv( GL_ARRAY_BUFFER_BINDING, values );		break;
+	case SLOT_SHADER_STORAGE_BUFFER:	glGetIntegerv( GL_SHADER_STORAGE_BUFFER_BINDING, values );	break;
+	case SLOT_PIXEL_PACK_BUFFER:		glGetIntegerv( GL_PIXEL_PACK_BUFFER_BINDING, values );		break;
+	case SLOT_DEPTH_MASK:		glGetIntegerv( GL_DEPTH_WRITEMASK, values );			break;
+	case SLOT_MATRIX_MODE:		glGetIntegerv( GL_MATRIX_MODE, values );				break;
+	case SLOT_BLEND_FUNC:
+		glGetIntegerv( GL_BLEND_SRC_RGB, &values[0] );
+		glGetIntegerv( GL_BLEND_DST_RGB, &values[1] );
+		glGetIntegerv( GL_BLEND_SRC_ALPHA, &values[2] );
+		glGetIntegerv( GL_BLEND_DST_ALPHA, &values[3] );
+		break;
+	case SLOT_COLOR:
+		glGetFloatv( GL_CURRENT_COLOR, state.original.f );
+		break;
+	case SLOT_CLEAR_COLOR:
+		glGetFloatv( GL_COLOR_CLEAR_VALUE, state.original.f );
+		break;
+	default:
+		values[0] = glIsEnabled( kCaps[slot - SLOT_BLEND] ) ? 1 : 0;
+		break;
+	}
+
+	state.current = state.original;
+	state.known = true;
+	state.valid = true;
+	state.changed = false;
+}
+
+void GlStateCache::Set( Slot slot, GLint value )
+{
+	const Values values = { { value, 0, 0, 0 } };
+	Set( slot, values );
+}
+
+void GlStateCache::Set( Slot slot, const Values& values )
+{
+	if ( SLOT_COUNT == slot )
+		return;
+
+	Load( slot );
+	State& state = states_[slot];
+	const size_t size = ValueCount( slot ) * sizeof( GLint );
+	if ( state.valid && 0 == memcmp( &state.current, &values, size ) )
+		return;
+
+	Apply( slot, values );
+	state.current = values;
+	state.valid = true;
+	state.changed = true;
+}
+
+void GlStateCache::Apply( Slot slot, const Values& values ) const
+{
+	switch ( slot )
+	{
+	case SLOT_FRAMEBUFFER:		glBindFramebuffer( GL_FRAMEBUFFER, (GLuint)values.i[0] );	break;
+	case SLOT_VIEWPORT:			glViewport( values.i[0], values.i[1], values.i[2], values.i[3] );	break;
+	case SLOT_SCISSOR:			glScissor( values.i[0], values.i[1], values.i[2], values.i[3] );	break;
+	case SLOT_PROGRAM:			glUseProgram( (GLuint)values.i[0] );						break;
+	case SLOT_ACTIVE_TEXTURE:	glActiveTexture( (GLenum)values.i[0] );					break;
+	case SLOT_TEXTURE_2D:		glBindTexture( GL_TEXTURE_2D, (GLuint)values.i[0] );		break;
+	case SLOT_TEXTURE_2D_UNIT1:
+	case SLOT_TEXTURE_2D_UNIT2:
+	case SLOT_TEXTURE_2D_UNIT3:
+		glBindMultiTextureEXT( GL_TEXTURE1 + slot - SLOT_TEXTURE_2D_UNIT1, GL_TEXTURE_2D, (GLuint)values.i[0] );
+		break;
+	case SLOT_TEXTURE_CUBE_UNIT4:	glBindMultiTextureEXT( GL_TEXTURE4, GL_TEXTURE_CUBE_MAP, (GLuint)values.i[0] );	break;
+	case SLOT_TEXTURE_2D_UNIT5:
+	case SLOT_TEXTURE_2D_UNIT6:
+		glBindMultiTextureEXT( GL_TEXTURE5 + slot - SLOT_TEXTURE_2D_UNIT5, GL_TEXTURE_2D, (GLuint)values.i[0] );
+		break;
+	case SLOT_TEXTURE_2D_ARRAY_UNIT1:	glBindMultiTextureEXT( GL_TEXTURE1, GL_TEXTURE_2D_ARRAY, (GLuint)values.i[0] );	break;
+	case SLOT_VERTEX_ARRAY:		glBindVertexArray( (GLuint)values.i[0] );					break;
+	case SLOT_ARRAY_BUFFER:		glBindBuffer( GL_ARRAY_BUFFER, (GLuint)values.i[0] );		break;
+	case SLOT_SHADER_STORAGE_BUFFER:	glBindBuffer( GL_SHADER_STORAGE_BUFFER, (GLuint)values.i[0] );	break;
+	case SLOT_PIXEL_PACK_BUFFER:		glBindBuffer( GL_PIXEL_PACK_BUFFER, (GLuint)values.i[0] );		break;
+	case SLOT_BLEND_FUNC:		glBlendFuncSeparate( (GLenum)values.i[0], (GLenum)values.i[1], (GLenum)values.i[2], (GLenum)values.i[3] );	break;
+	case SLOT_DEPTH_MASK:		glDepthMask( 0 != values.i[0] ? GL_TRUE : GL_FALSE );	break;
+	case SLOT_MATRIX_MODE:		glMatrixMode( (GLenum)values.i[0] );						break;
+	case SLOT_COLOR:			glColor4fv( values.f );									break;
+	case SLOT_CLEAR_COLOR:		glClearColor( values.f[0], values.f[1], values.f[2], values.f[3] );	break;
+	default:
+		if ( 0 != values.i[0] )
+			glEnable( kCaps[slot - SLOT_BLEND] );
+		else
+			glDisable( kCaps[slot - SLOT_BLEND] );
+		break;
+	}
+}
@@ -0,0 +1,164 @@
+//==============================================================================
+// File:GlStateCache.h
+//==============================================================================
+//
+// Description: Shadow copy of the GL state a plugin touches while it runs inside
+//				an IG callback. State is read from the driver at most once until
+//				it is invalidated, redundant changes are dropped, and only what
+//				the plugin actually changed is put back afterwards. This replaces
+//				glPushAttrib( GL_ALL_ATTRIB_BITS ) and synchronous glGet* calls.
+//
+//==============================================================================
+
+#ifndef DVC_GL_STATE_CACHE_H
+#define DVC_GL_STATE_CACHE_H
+
+#include "GL/glew.h"
+
+class GlStateCache
+{
+public:
+	/*!
+	 * Groups of state, used to invalidate state the IG is known to change and to declare state
+	 * changed behind the cache's back (e.g. by a library).
+	**/
+	enum Group
+	{
+		GROUP_FRAMEBUFFER		= 1 << 0,	// framebuffer binding and clear color
+		GROUP_VIEWPORT			= 1 << 1,
+		GROUP_PROGRAM			= 1 << 2,
+		GROUP_TEXTURE			= 1 << 3,	// active texture unit and its 2D binding, 2D bindings of units 1 to 3, 5 and 6, cube map of unit 4
+		GROUP_VERTEX_ARRAY		= 1 << 4,	// vertex array object and array buffer binding
+		GROUP_BLEND				= 1 << 5,	// GL_BLEND and the blend function
+		GROUP_DEPTH				= 1 << 6,	// GL_DEPTH_TEST and the depth mask
+		GROUP_RASTER			= 1 << 7,	// culling, alpha test, alpha to coverage, scissor
+		GROUP_FIXED_FUNCTION	= 1 << 8,	// lighting, fog, GL_TEXTURE_2D, current color, matrix mode
+		GROUP_BUFFER			= 1 << 9,	// generic shader storage and pixel pack buffer bindings
+		GROUP_ALL				= ( 1 << 10 ) - 1
+	};
+
+	GlStateCache();
+
+	/*!
+	 * Forgets the captured state of the given groups, so it is read from the driver again the
+	 * next time it is touched. Begin does this for the framebuffer and viewport at the IG's
+	 * frame, window and view boundaries, call it directly when code outside the cache (e.g. a child plugin) has changed state.
+	**/
+	void Invalidate( unsigned int groups = GROUP_ALL );
+
+	/*!
+	 * Sets a value the IG reported through a callback, so it never has to be read back.
+	**/
+	void SeedViewport( const int viewport[4] );
+	void SeedFramebuffer( GLuint framebuffer );
+
+	/*!
+	 * Starts a plugin callback. The state is assumed to be what was captured before, state the
+	 * previous callback changed is expected to have been restored. A new frame, window or view
+	 * forgets the framebuffer and viewport the IG renders into.
+	**/
+	void Begin( unsigned int frame_index, int window_id, int view_id );
+
+	/*!
+	 * Puts back everything changed since Begin, in a fixed order.
+	**/
+	void Restore();
+
+	/*!
+	 * Declares that code outside the cache is about to change the given groups. Their current
+	 * values are captured now and Restore() applies them unconditionally.
+	**/
+	void Touch( unsigned int groups );
+
+	/*! The framebuffer the IG had bound when the callback began. **/
+	GLuint GetFramebuffer();
+
+	// only the capabilities listed with the groups above are tracked
+	void Enable( GLenum cap );
+	void Disable( GLenum cap );
+	void BindFramebuffer( GLuint framebuffer );
+	void Viewport( GLint x, GLint y, GLsizei width, GLsizei height );
+	void Scissor( GLint x, GLint y, GLsizei width, GLsizei height );
+	void UseProgram( GLuint program );
+	void BindTexture2D( GLuint texture );
+	void BindMultiTexture2D( GLuint unit, GLuint texture );	// units 1 to 3, 5 and 6, leaves the active unit alone
+	void BindMultiTextureCube( GLuint texture );			// unit 4, leaves the active unit alone
+	void BindMultiTexture2DArray( GLuint texture );			// unit 1, leaves the active unit alone
+	void BindVertexArray( GLuint vertex_array );
+	void BindStorageBufferRange( GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size );	// size 0 binds the whole buffer, the generic binding follows
+	void BindPixelPackBuffer( GLuint buffer );
+	void BlendFunc( GLenum sfactor, GLenum dfactor );
+	void DepthMask( GLboolean flag );
+	void MatrixMode( GLenum mode );
+	void Color4f( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
+	void ClearColor( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
+
+private:
+	// restored in this order: the texture unit before its binding, the VAO before the buffer
+	enum Slot
+	{
+		SLOT_FRAMEBUFFER = 0,
+		SLOT_VIEWPORT,
+		SLOT_SCISSOR,
+		SLOT_PROGRAM,
+		SLOT_ACTIVE_TEXTURE,
+		SLOT_TEXTURE_2D,
+		SLOT_TEXTURE_2D_UNIT1,
+		SLOT_TEXTURE_2D_UNIT2,
+		SLOT_TEXTURE_2D_UNIT3,
+		SLOT_TEXTURE_CUBE_UNIT4,
+		SLOT_TEXTURE_2D_UNIT5,
+		SLOT_TEXTURE_2D_UNIT6,
+		SLOT_TEXTURE_2D_ARRAY_UNIT1,
+		SLOT_VERTEX_ARRAY,
+		SLOT_ARRAY_BUFFER,
+		SLOT_SHADER_STORAGE_BUFFER,
+		SLOT_PIXEL_PACK_BUFFER,
+		SLOT_BLEND_FUNC,
+		SLOT_DEPTH_MASK,
+		SLOT_MATRIX_MODE,
+		SLOT_COLOR,
+		SLOT_CLEAR_COLOR,
+		SLOT_BLEND,
+		SLOT_DEPTH_TEST,
+		SLOT_CULL_FACE,
+		SLOT_ALPHA_TEST,
+		SLOT_SAMPLE_ALPHA_TO_COVERAGE,
+		SLOT_LIGHTING,
+		SLOT_FOG,
+		SLOT_TEXTURE_2D_ENABLE,
+		SLOT_SCISSOR_TEST,
+		SLOT_COUNT
+	};
+
+	union Values
+	{
+		GLint	i[4];	// names, enums, flags and rectangles
+		GLfloat	f[4];	// the current and the clear color
+	};
+
+	struct State
+	{
+		Values	original;	// value when the callback began
+		Values	current;	// value the driver has now, if valid
+		bool	known;		// original holds captured state
+		bool	valid;		// current is trustworthy, false after Touch
+		bool	changed;	// has to be restored
+	};
+
+	static int ValueCount( Slot slot );
+	static Slot CapSlot( GLenum cap );
+
+	void Load( Slot slot );
+	void Set( Slot slot, GLint value );
+	void Set( Slot slot, const Values& values );
+	void Apply( Slot slot, const Values& values ) const;
+
+	State			states_[SLOT_COUNT];
+	bool			begun_;			// frame_index_, window_id_ and view_id_ are set
+	unsigned int	frame_index_;	// of the last Begin
+	int				window_id_;
+	int				view_id_;
+};
+
+#endif // DVC_GL_STATE_CACHE_H
@@ -0,0 +1,91 @@
+//==============================================================================
+// File:CalibrationProfiles.cpp
+//==============================================================================
+
+#include "CalibrationProfiles.h"
+
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#include <Windows.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+CalibrationProfiles::CalibrationProfiles()
+	: active_( 0 )
+	, requested_( 0 )
+{
+	const Profile first = { "default", std::string(), 0, false };
+	profiles_.push_back( first );
+}
+
+void CalibrationProfiles::SetDefault( const std::string& ini_path )
+{
+	profiles_.front().ini_path = ini_path;
+}
+
+void CalibrationProfiles::Add( const std::string& name, const std::string& ini_path, const std::string& key )
+{
+	const Profile profile = { name.empty() ? ini_path : name, ini_path, ParseKey( key ), false };
+	if ( !key.empty() && 0 == profile.virtual_key )
+		std::cout << "Warning: unknown key \"" << key << "\" for calibration profile " << profile.name << "." << std::endl;
+	profiles_.push_back( profile );
+}
+
+int CalibrationProfiles::ParseKey( const std::string& key )
+{
+	// function keys, letters and digits by name, anything else as a virtual-key code
+	if ( key.size() >= 2 && ( 'F' == key[0] || 'f' == key[0] ) && isdigit( (unsigned char)key[1] ) )
+	{
+		const int number = atoi( key.c_str() + 1 );
+		return number >= 1 && number <= 24 ? VK_F1 + number - 1 : 0;
+	}
+	if ( 1 == key.size() && isalnum( (unsigned char)key[0] ) )
+		return toupper( (unsigned char)key[0] );
+	if ( key.size() > 2 && '0' == key[0] && ( 'x' == key[1] || 'X' == key[1] ) )
+		return (int)strtol( key.c_str(), nullptr, 16 );
+	return 0;
+}
+
+bool CalibrationProfiles::ReadMessage( const void* param, unsigned int size )
+{
+	if ( nullptr == param || size < sizeof( ProfileMsg ) )
+		return false;
+
+	ProfileMsg message;
+	std::memcpy( &message, param, sizeof( message ) );
+	if ( kProfileMsg != message.msg )
+		return false;
+
+	if ( message.profile < 0 || (size_t)message.profile >= profiles_.size() )
+		std::cout << "Warning: there is no calibration profile " << message.profile << "." << std::endl;
+	else
+		requested_ = (size_t)message.profile;
+	return true;
+}
+
+void CalibrationProfiles::Poll()
+{
+	for ( size_t i = 0; i < profiles_.size(); ++i )
+	{
+		Profile& profile = profiles_[i];
+		if ( 0 == profile.virtual_key )
+			continue;
+		const bool down = 0 != ( GetAsyncKeyState( profile.virtual_key ) & 0x8000 );
+		if ( down && !profile.key_down )
+			requested_ = i;
+		profile.key_down = down;
+	}
+}
+
+bool CalibrationProfiles::TakeSwitch( size_t& profile )
+{
+	if ( requested_ == active_ )
+		return false;
+
+	active_ = requested_;
+	profile = active_;
+	return true;
+}
@@ -0,0 +1,93 @@
+//==============================================================================
+// File:CalibrationProfiles.h
+//==============================================================================
+//
+// Description: Alternative calibrations of the same windows, e.g. day and night
+//				blends or the pilot's and the copilot's eye point. Every window
+//				loads the warpers and warp resources of all profiles when it is
+//				created, so a switch only selects other ones at the next frame.
+//				A host requests a profile with update() as a ProfileMsg, e.g.
+//				forwarded from a CIGI user-defined packet, or an operator with a
+//				key bound to it.
+//
+//==============================================================================
+
+#ifndef DVC_CALIBRATION_PROFILES_H
+#define DVC_CALIBRATION_PROFILES_H
+
+#include <string>
+#include <vector>
+
+/*! Tells a ProfileMsg from the IgInterface messages, which share the update() param. **/
+const int kProfileMsg = 0x666F7250;	/* "Prof" */
+
+/*!
+ * update() param selecting a calibration profile.
+**/
+struct ProfileMsg
+{
+	int msg;						/* kProfileMsg */
+	int profile;					/* 0 is the <path ini> calibration, then the <profile> elements in order */
+};
+
+class CalibrationProfiles
+{
+public:
+	CalibrationProfiles();
+
+	/*!
+	 * Sets the ini of profile 0, "default".
+	**/
+	void SetDefault( const std::string& ini_path );
+
+	/*!
+	 * Adds a profile after the previous ones.
+	 *
+	 * @param[in] key : e.g. "F6", "N" or "0x75", selects the profile while pressed. Empty for none.
+	**/
+	void Add( const std::string& name, const std::string& ini_path, const std::string& key );
+
+	size_t GetCount() const { return profiles_.size(); }
+	const std::string& GetName( size_t profile ) const { return profiles_[profile].name; }
+	const std::string& GetIniPath( size_t profile ) const { return profiles_[profile].ini_path; }
+
+	/*!
+	 * Takes the request of a ProfileMsg.
+	 *
+	 * @return
+	 *  false if param is not a ProfileMsg
+	**/
+	bool ReadMessage( const void* param, unsigned int size );
+
+	/*!
+	 * Looks for keys pressed since the last frame.
+	**/
+	void Poll();
+
+	/*!
+	 * @param[out] profile : the requested profile, the active one from now on
+	 *
+	 * @return
+	 *  true once for each request of another profile than the active one
+	**/
+	bool TakeSwitch( size_t& profile );
+
+	size_t GetActive() const { return active_; }
+
+private:
+	struct Profile
+	{
+		std::string name;
+		std::string ini_path;
+		int virtual_key;			/* 0 for none */
+		bool key_down;				/* a held key selects once */
+	};
+
+	static int ParseKey( const std::string& key );
+
+	std::vector<Profile> profiles_;
+	size_t active_;
+	size_t requested_;
+};
+
+#endif // DVC_CALIBRATION_PROFILES_H
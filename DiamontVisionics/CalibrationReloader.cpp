@@ -0,0 +1,381 @@
+//==============================================================================
+// File:CalibrationReloader.cpp
+//==============================================================================
+
+#include "CalibrationReloader.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	unsigned long long GetWriteTime( const std::string& path )
+	{
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if ( !GetFileAttributesExA( path.c_str(), GetFileExInfoStandard, &data ) )
+			return 0;
+		return ( (unsigned long long)data.ftLastWriteTime.dwHighDateTime << 32 ) | data.ftLastWriteTime.dwLowDateTime;
+	}
+
+	std::string GetDirectory( const std::string& path )
+	{
+		const size_t slash = path.find_last_of( "\\/" );
+		return std::string::npos == slash ? std::string( "." ) : path.substr( 0, slash );
+	}
+
+	bool IsAbsolute( const std::string& path )
+	{
+		return ( path.size() > 1 && ':' == path[1] ) || ( !path.empty() && ( '\\' == path[0] || '/' == path[0] ) );
+	}
+
+	std::string ChannelName( int window_id )
+	{
+		std::ostringstream s;
+		s << "WIN" << window_id;
+		return s.str();
+	}
+
+	bool IsSignaled( GLsync fence )
+	{
+		const GLenum result = glClientWaitSync( fence, 0, 0 );
+		return GL_ALREADY_SIGNALED == result || GL_CONDITION_SATISFIED == result;
+	}
+
+	// one notification per directory, after the stop and watch events at index 0 and 1
+	void OpenNotifications( const std::vector<std::string>& directories, std::vector<HANDLE>& handles )
+	{
+		for ( size_t i = 2; i < handles.size(); ++i )
+			FindCloseChangeNotification( handles[i] );
+		handles.resize( 2 );
+
+		for ( size_t i = 0; i < directories.size(); ++i )
+		{
+			HANDLE change = FindFirstChangeNotificationA( directories[i].c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME );
+			if ( INVALID_HANDLE_VALUE == change )
+				std::cout << "Warning: cannot watch " << directories[i] << " for calibration changes." << std::endl;
+			else
+				handles.push_back( change );
+		}
+	}
+}
+
+CalibrationReloader::CalibrationReloader()
+	: debounce_ms_( 250 )
+	, dc_( nullptr )
+	, worker_context_( nullptr )
+	, stop_event_( nullptr )
+	, watch_event_( nullptr )
+{
+}
+
+CalibrationReloader::~CalibrationReloader()
+{
+}
+
+bool CalibrationReloader::Start( const std::string& ini_path, const std::string& log_path, unsigned int debounce_ms )
+{
+	// GetPrivateProfileString looks in the Windows directory for relative names
+	char full_path[MAX_PATH] = { 0 };
+	ini_path_ = GetFullPathNameA( ini_path.c_str(), MAX_PATH, full_path, nullptr ) ? full_path : ini_path;
+	log_path_ = log_path;
+	debounce_ms_ = debounce_ms;
+
+	dc_ = wglGetCurrentDC();
+	HGLRC ig_context = wglGetCurrentContext();
+	if ( nullptr == dc_ || nullptr == ig_context )
+	{
+		std::cout << "Warning: no current GL context, calibration hot reload is off." << std::endl;
+		return false;
+	}
+
+	// a fresh context, so sharing with the IG's is always allowed
+	worker_context_ = wglCreateContext( dc_ );
+	if ( nullptr == worker_context_ || !wglShareLists( ig_context, worker_context_ ) )
+	{
+		std::cout << "Warning: could not create a shared GL context, calibration hot reload is off." << std::endl;
+		if ( worker_context_ )
+			wglDeleteContext( worker_context_ );
+		worker_context_ = nullptr;
+		return false;
+	}
+
+	stop_event_ = CreateEventA( nullptr, TRUE, FALSE, nullptr );
+	watch_event_ = CreateEventA( nullptr, FALSE, FALSE, nullptr );
+	thread_ = std::thread( &CalibrationReloader::Run, this );
+
+	std::cout << "Info: watching " << ini_path_ << " for calibration changes." << std::endl;
+	return true;
+}
+
+void CalibrationReloader::Stop()
+{
+	if ( !IsRunning() )
+		return;
+
+	SetEvent( stop_event_ );
+	if ( thread_.joinable() )
+		thread_.join();
+
+	for ( size_t i = 0; i < ready_.size(); ++i )
+		Destroy( ready_[i] );
+	ready_.clear();
+
+	// the IG is shutting down, no need to wait for the GPU
+	glFinish();
+	for ( size_t i = 0; i < retired_.size(); ++i )
+		Destroy( retired_[i] );
+	retired_.clear();
+
+	wglDeleteContext( worker_context_ );
+	worker_context_ = nullptr;
+	CloseHandle( stop_event_ );
+	CloseHandle( watch_event_ );
+}
+
+void CalibrationReloader::Watch( int window_id, const WarpSettings& settings )
+{
+	if ( !IsRunning() )
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		for ( size_t i = 0; i < watched_.size(); ++i )
+		{
+			if ( watched_[i].window_id == window_id )
+				return;
+		}
+		const Watched watched = { window_id, settings };
+		watched_.push_back( watched );
+	}
+	SetEvent( watch_event_ );
+}
+
+bool CalibrationReloader::TakeReady( int& window_id, ExternalFbo::Profile& profile )
+{
+	std::lock_guard<std::mutex> lock( mutex_ );
+	for ( std::vector<Built>::iterator it = ready_.begin(); it != ready_.end(); ++it )
+	{
+		if ( !IsSignaled( it->fence ) )
+			continue;
+
+		glDeleteSync( it->fence );
+		window_id = it->window_id;
+		profile = it->profile;
+		ready_.erase( it );
+		return true;
+	}
+	return false;
+}
+
+void CalibrationReloader::Retire( const ExternalFbo::Profile& profile )
+{
+	if ( nullptr == profile.warper )
+		return;
+
+	Built retired = { -1, profile, glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) };
+	retired_.push_back( retired );
+}
+
+void CalibrationReloader::Update()
+{
+	for ( std::vector<Built>::iterator it = retired_.begin(); it != retired_.end(); )
+	{
+		if ( IsSignaled( it->fence ) )
+		{
+			Destroy( *it );
+			it = retired_.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void CalibrationReloader::Destroy( Built& built )
+{
+	glDeleteSync( built.fence );
+	ExternalFbo::ReleaseResources( built.profile );
+	VWB_Destroy( built.profile.warper );
+}
+
+void CalibrationReloader::CollectFiles( std::vector<WatchedFile>& files )
+{
+	std::vector<int> window_ids;
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		for ( size_t i = 0; i < watched_.size(); ++i )
+			window_ids.push_back( watched_[i].window_id );
+	}
+
+	files.clear();
+	WatchedFile ini = { ini_path_, -1, GetWriteTime( ini_path_ ) };
+	files.push_back( ini );
+
+	for ( size_t i = 0; i < window_ids.size(); ++i )
+	{
+		// the channel section overrides [default]
+		char default_file[MAX_PATH] = { 0 };
+		char calib_file[MAX_PATH] = { 0 };
+		GetPrivateProfileStringA( "default", "calibFile", "", default_file, MAX_PATH, ini_path_.c_str() );
+		GetPrivateProfileStringA( ChannelName( window_ids[i] ).c_str(), "calibFile", default_file, calib_file, MAX_PATH, ini_path_.c_str() );
+		if ( 0 == calib_file[0] )
+			continue;
+
+		std::string path = calib_file;
+		if ( !IsAbsolute( path ) )
+			path = GetDirectory( ini_path_ ) + "\\" + path;
+		WatchedFile calibration = { path, window_ids[i], GetWriteTime( path ) };
+		files.push_back( calibration );
+	}
+}
+
+void CalibrationReloader::Rebuild( const std::vector<int>& window_ids )
+{
+	for ( size_t i = 0; i < window_ids.size(); ++i )
+	{
+		const int window_id = window_ids[i];
+		VWB_Warper* warper = nullptr;
+		VWB_ERROR err = VWB_Create( nullptr, ini_path_.c_str(), ChannelName( window_id ).c_str(), &warper, 2, log_path_.c_str() );
+		if ( VWB_ERROR_NONE == err )
+		{
+			err = VWB_Init( warper );
+			if ( VWB_ERROR_NONE != err )
+				VWB_Destroy( warper );
+		}
+		if ( VWB_ERROR_NONE != err )
+		{
+			std::cout << "Warning: could not rebuild the warper for window_id " << window_id << ", keeping the current calibration. Error code " << (int)err << std::endl;
+			continue;
+		}
+
+		// the window's warp resources too, so swapping them in is an exchange of pointers
+		WarpSettings settings = WarpSettings();
+		{
+			std::lock_guard<std::mutex> lock( mutex_ );
+			for ( size_t j = 0; j < watched_.size(); ++j )
+			{
+				if ( watched_[j].window_id == window_id )
+					settings = watched_[j].settings;
+			}
+		}
+		const ExternalFbo::Profile profile = ExternalFbo::LoadProfile( warper, settings );
+
+		// the render thread only takes them once they are on the GPU
+		Built built = { window_id, profile, glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 ) };
+		glFlush();
+
+		std::lock_guard<std::mutex> lock( mutex_ );
+		for ( std::vector<Built>::iterator it = ready_.begin(); it != ready_.end(); ++it )
+		{
+			// superseded before it was taken
+			if ( it->window_id == window_id )
+			{
+				Destroy( *it );
+				ready_.erase( it );
+				break;
+			}
+		}
+		ready_.push_back( built );
+	}
+}
+
+void CalibrationReloader::Run()
+{
+	if ( !wglMakeCurrent( dc_, worker_context_ ) )
+	{
+		std::cout << "Warning: could not activate the shared GL context, calibration hot reload is off." << std::endl;
+		return;
+	}
+
+	std::vector<WatchedFile> files;
+	std::vector<std::string> directories;
+	std::vector<HANDLE> handles;
+	handles.push_back( stop_event_ );
+	handles.push_back( watch_event_ );
+
+	bool watch_list_changed = true;
+	for ( ;; )
+	{
+		if ( watch_list_changed )
+		{
+			CollectFiles( files );
+			directories.clear();
+			for ( size_t i = 0; i < files.size(); ++i )
+			{
+				const std::string directory = GetDirectory( files[i].path );
+				if ( directories.end() == std::find( directories.begin(), directories.end(), directory ) )
+					directories.push_back( directory );
+			}
+			OpenNotifications( directories, handles );
+			watch_list_changed = false;
+		}
+
+		const DWORD result = WaitForMultipleObjects( (DWORD)handles.size(), &handles[0], FALSE, INFINITE );
+		if ( WAIT_OBJECT_0 == result || WAIT_FAILED == result )
+			break;
+		if ( WAIT_OBJECT_0 + 1 == result )
+		{
+			watch_list_changed = true;
+			continue;
+		}
+		if ( result < WAIT_OBJECT_0 + handles.size() )
+			FindNextChangeNotification( handles[result - WAIT_OBJECT_0] );
+
+		// wait until the calibration tool has finished writing
+		std::vector<WatchedFile> changed;
+		CollectFiles( changed );
+		bool stopping = false;
+		for ( ;; )
+		{
+			if ( WAIT_OBJECT_0 == WaitForSingleObject( stop_event_, debounce_ms_ ) )
+			{
+				stopping = true;
+				break;
+			}
+			std::vector<WatchedFile> again;
+			CollectFiles( again );
+			const bool stable = again.size() == changed.size() && std::equal( again.begin(), again.end(), changed.begin(),
+				[]( const WatchedFile& a, const WatchedFile& b ) { return a.path == b.path && a.write_time == b.write_time; } );
+			changed.swap( again );
+			if ( stable )
+				break;
+		}
+		if ( stopping )
+			break;
+
+		std::vector<int> window_ids;
+		for ( size_t i = 0; i < changed.size(); ++i )
+		{
+			std::vector<WatchedFile>::const_iterator before = std::find_if( files.begin(), files.end(),
+				[&]( const WatchedFile& file ) { return file.path == changed[i].path; } );
+			if ( files.end() != before && before->write_time == changed[i].write_time )
+				continue;
+
+			if ( -1 == changed[i].window_id )
+			{
+				// the ini changed: every window, and the calibration files may have moved
+				std::lock_guard<std::mutex> lock( mutex_ );
+				window_ids.clear();
+				for ( size_t j = 0; j < watched_.size(); ++j )
+					window_ids.push_back( watched_[j].window_id );
+				watch_list_changed = true;
+				break;
+			}
+			if ( window_ids.end() == std::find( window_ids.begin(), window_ids.end(), changed[i].window_id ) )
+				window_ids.push_back( changed[i].window_id );
+		}
+		files.swap( changed );
+
+		if ( !window_ids.empty() )
+		{
+			std::cout << "Info: calibration changed, rebuilding " << window_ids.size() << " warper(s) in the background." << std::endl;
+			Rebuild( window_ids );
+		}
+	}
+
+	for ( size_t i = 2; i < handles.size(); ++i )
+		FindCloseChangeNotification( handles[i] );
+	wglMakeCurrent( nullptr, nullptr );
+}
@@ -0,0 +1,118 @@
+//==============================================================================
+// File:CalibrationReloader.h
+//==============================================================================
+//
+// Description: Watches the VIOSO ini and the calibration files it references and
+//				rebuilds the affected warpers on a background thread when one of
+//				them changes, together with the plugin's warp renderer and
+//				coverage of each. The thread owns a GL context sharing objects
+//				with the IG's, so the new warp resources are complete on the GPU
+//				before the render thread swaps them in at a frame boundary by
+//				exchanging pointers. Replaced warpers and their resources are
+//				destroyed once the GPU has finished with them.
+//
+//==============================================================================
+
+#ifndef DVC_CALIBRATION_RELOADER_H
+#define DVC_CALIBRATION_RELOADER_H
+
+#include "ExternalFbo.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CalibrationReloader
+{
+public:
+	CalibrationReloader();
+	~CalibrationReloader();
+
+	/*!
+	 * Creates the shared context and starts watching. Call on the IG thread with its context current.
+	 *
+	 * @return
+	 *  false if no shared context could be created, hot reload is off then.
+	**/
+	bool Start( const std::string& ini_path, const std::string& log_path, unsigned int debounce_ms );
+
+	/*!
+	 * Stops the thread and destroys every warper still owned by the reloader. Needs the IG context.
+	**/
+	void Stop();
+
+	/*!
+	 * Adds a window to rebuild when its calibration changes. The channel name is "WIN<window_id>",
+	 * as used by setActiveWindow.
+	 *
+	 * @param[in] settings : of the window's warp, see ExternalFbo::LoadProfile
+	**/
+	void Watch( int window_id, const WarpSettings& settings );
+
+	/*!
+	 * Hands over a rebuilt warper with its warp resources, complete on the GPU. Call at a frame
+	 * boundary.
+	 *
+	 * @return
+	 *  false if nothing is ready.
+	**/
+	bool TakeReady( int& window_id, ExternalFbo::Profile& profile );
+
+	/*!
+	 * Takes ownership of a replaced warper and its resources. They are destroyed by a later
+	 * Update() once the GPU is done with the commands issued so far.
+	**/
+	void Retire( const ExternalFbo::Profile& profile );
+
+	/*!
+	 * Destroys retired warpers the GPU is done with. Call once per frame on the IG thread.
+	**/
+	void Update();
+
+	bool IsRunning() const { return nullptr != worker_context_; }
+
+private:
+	struct Built
+	{
+		int window_id;
+		ExternalFbo::Profile profile;
+		GLsync fence;
+	};
+
+	struct Watched
+	{
+		int window_id;
+		WarpSettings settings;
+	};
+
+	struct WatchedFile
+	{
+		std::string path;
+		int window_id;					/* -1 for the ini, which affects every window */
+		unsigned long long write_time;	/* 0 if the file is missing */
+	};
+
+	void Run();
+	void CollectFiles( std::vector<WatchedFile>& files );
+	void Rebuild( const std::vector<int>& window_ids );
+	static void Destroy( Built& built );
+
+	std::string ini_path_;
+	std::string log_path_;
+	unsigned int debounce_ms_;
+
+	HDC dc_;
+	HGLRC worker_context_;
+	HANDLE stop_event_;
+	HANDLE watch_event_;			/* set when the window list changed */
+	std::thread thread_;
+
+	std::mutex mutex_;				/* guards watched_ and ready_ */
+	std::vector<Watched> watched_;
+	std::vector<Built> ready_;
+
+	std::vector<Built> retired_;	/* IG thread only */
+};
+
+#endif // DVC_CALIBRATION_RELOADER_H
@@ -0,0 +1,149 @@
+//==============================================================================
+// File:ChildProcessors.cpp
+//==============================================================================
+
+#include "ChildProcessors.h"
+
+#include <iostream>
+
+ChildProcessors::ChildProcessors()
+{
+}
+
+ChildProcessors::~ChildProcessors()
+{
+	Unload();
+}
+
+void ChildProcessors::Add( const std::string& dll_path, const std::string& config_path )
+{
+	Child child;
+	child.dll_path = dll_path;
+	child.config_path = config_path;
+	child.module = nullptr;
+	child.processor = nullptr;
+	child.destroy = nullptr;
+	listed_.push_back( child );
+}
+
+size_t ChildProcessors::Load()
+{
+	for ( size_t i = 0; i < listed_.size(); ++i )
+	{
+		Child child = listed_[i];
+		child.module = LoadLibraryA( child.dll_path.c_str() );
+		if ( nullptr == child.module )
+		{
+			std::cout << "Warning: could not load image processor " << child.dll_path << ", check the path and its dependencies." << std::endl;
+			continue;
+		}
+
+		const CreateFunction create = (CreateFunction)GetProcAddress( child.module, GIG_CREATE_IMAGEPROCESSOR_PLUGIN );
+		child.destroy = (DeleteFunction)GetProcAddress( child.module, GIG_DELETE_IMAGEPROCESSOR_PLUGIN );
+		child.processor = create ? create() : nullptr;
+		if ( nullptr == child.processor )
+		{
+			std::cout << "Warning: " << child.dll_path << " is not an image processor, it is ignored." << std::endl;
+			Release( child );
+			continue;
+		}
+		if ( child.processor->initialize( child.config_path.empty() ? nullptr : child.config_path.c_str() ) <= 0 )
+		{
+			std::cout << "Warning: image processor " << child.dll_path << " failed to initialize, it is ignored." << std::endl;
+			Release( child );
+			continue;
+		}
+
+		// the scene target is the plugin's, a child cannot bind one of its own
+		if ( child.processor->PluginBindsRenderTarget() )
+			std::cout << "Warning: image processor " << child.dll_path << " renders into the plugin's scene target, not its own." << std::endl;
+		std::cout << "Info: image processor " << child.dll_path << " runs before the warp." << std::endl;
+		children_.push_back( child );
+	}
+	return children_.size();
+}
+
+void ChildProcessors::Unload()
+{
+	for ( size_t i = children_.size(); i > 0; --i )
+	{
+		children_[i - 1].processor->shutdown();
+		Release( children_[i - 1] );
+	}
+	children_.clear();
+}
+
+void ChildProcessors::Release( Child& child )
+{
+	if ( child.processor && child.destroy )
+		child.destroy( child.processor );
+	if ( child.module )
+		FreeLibrary( child.module );
+	child.processor = nullptr;
+	child.destroy = nullptr;
+	child.module = nullptr;
+}
+
+void ChildProcessors::InitializeGraphics()
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+	{
+		if ( children_[i].processor->initializeGraphics() <= 0 )
+			std::cout << "Warning: image processor " << children_[i].dll_path << " failed to initialize its graphics." << std::endl;
+	}
+}
+
+void ChildProcessors::Update( float frame_delta_time, void* param, unsigned int buffer_size_in_bytes )
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+		children_[i].processor->update( frame_delta_time, param, buffer_size_in_bytes );
+}
+
+void ChildProcessors::SetActiveWindow( int window_id, int window_extents[2] )
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+	{
+		// a child may write the extents back, each gets its own copy
+		int extents[2] = { window_extents[0], window_extents[1] };
+		children_[i].processor->setActiveWindow( window_id, extents );
+	}
+}
+
+void ChildProcessors::SetActiveView( int view_id, int viewport[4] )
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+	{
+		int view[4] = { viewport[0], viewport[1], viewport[2], viewport[3] };
+		children_[i].processor->setActiveView( view_id, view );
+	}
+}
+
+void ChildProcessors::PreWindowProcess()
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+		children_[i].processor->preWindowProcess();
+}
+
+void ChildProcessors::PostWindowProcess()
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+		children_[i].processor->postWindowProcess();
+}
+
+void ChildProcessors::PreViewProcess()
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+		children_[i].processor->preViewProcess();
+}
+
+void ChildProcessors::PostViewProcess()
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+		children_[i].processor->postViewProcess();
+}
+
+void ChildProcessors::SetAdditionalRadiance( double additional_radiance )
+{
+	for ( size_t i = 0; i < children_.size(); ++i )
+		children_[i].processor->setAdditionalRadiance( additional_radiance );
+}
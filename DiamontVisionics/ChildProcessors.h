@@ -0,0 +1,87 @@
+//==============================================================================
+// File:ChildProcessors.h
+//==============================================================================
+//
+// Description: Image processor DLLs the plugin hosts, see <processor>. The IG
+//				loads a single image processor, so the plugin loads the others
+//				and forwards the IG's callbacks to them in the order they are
+//				listed. They process the scene in the plugin's scene target, in
+//				postWindowProcess before the warp, so the whole chain shares one
+//				render target and the warp runs once. The plugin keeps the
+//				frustum, the viewport, the model view and the render target; a
+//				child's own answers to those are not asked.
+//
+//==============================================================================
+
+#ifndef DVC_CHILD_PROCESSORS_H
+#define DVC_CHILD_PROCESSORS_H
+
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#include <Windows.h>
+#include "gig/GenesisIG_UserDefined_ImageProcessor200.h"
+
+#include <string>
+#include <vector>
+
+class ChildProcessors
+{
+public:
+	ChildProcessors();
+	~ChildProcessors();
+
+	/*!
+	 * Lists a child, loaded by Load.
+	 *
+	 * @param[in] config_path : passed to its initialize, empty for none
+	**/
+	void Add( const std::string& dll_path, const std::string& config_path );
+
+	/*!
+	 * Loads and initializes the listed children. One that fails is logged and left out.
+	 *
+	 * @return
+	 *  the number running
+	**/
+	size_t Load();
+
+	/*! Shuts the children down and unloads them, the last first. **/
+	void Unload();
+
+	bool IsEmpty() const { return children_.empty(); }
+
+	// forwarded to every child, see IUserDefinedImageProcessor200
+	void InitializeGraphics();
+	void Update( float frame_delta_time, void* param, unsigned int buffer_size_in_bytes );
+	void SetActiveWindow( int window_id, int window_extents[2] );
+	void SetActiveView( int view_id, int viewport[4] );
+	void PreWindowProcess();
+	void PostWindowProcess();
+	void PreViewProcess();
+	void PostViewProcess();
+	void SetAdditionalRadiance( double additional_radiance );
+
+private:
+	ChildProcessors( const ChildProcessors& );
+	ChildProcessors& operator=( const ChildProcessors& );
+
+	typedef IUserDefinedImageProcessor200* ( *CreateFunction )();
+	typedef void ( *DeleteFunction )( IUserDefinedImageProcessor200* );
+
+	struct Child
+	{
+		std::string dll_path;
+		std::string config_path;
+		HMODULE module;
+		IUserDefinedImageProcessor200* processor;
+		DeleteFunction destroy;
+	};
+
+	/*! Frees what a child holds, its processor already shut down. **/
+	static void Release( Child& child );
+
+	std::vector<Child> listed_;		/* see Add */
+	std::vector<Child> children_;	/* loaded and initialized, in the listed order */
+};
+
+#endif // DVC_CHILD_PROCESSORS_H
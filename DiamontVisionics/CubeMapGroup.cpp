@@ -0,0 +1,169 @@
+//==============================================================================
+// File:CubeMapGroup.cpp
+//==============================================================================
+
+#include "CubeMapGroup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	const double kToRadians = 3.14159265358979 / 180.0;
+	const double kEyeTolerance = 1e-3;		// distance between the members' eye points, in the eyepoint frame's units
+	const double kResizeTolerance = 0.02;	// smaller changes of the face size keep the targets
+
+	// looking along each axis with GL's cube map orientation, which has the rows top down
+	const double kFaceForward[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const double kFaceUp[6][3] = { { 0, -1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, -1, 0 }, { 0, -1, 0 } };
+
+	// where a view matrix puts its eye: -R^T t
+	void GetEye( const VWB_float view[16], double eye[3] )
+	{
+		for ( int i = 0; i < 3; ++i )
+			eye[i] = -( view[i * 4 + 0] * view[12] + view[i * 4 + 1] * view[13] + view[i * 4 + 2] * view[14] );
+	}
+}
+
+CubeMapGroup::CubeMapGroup( const std::vector<int>& windows, unsigned int face_size )
+	: windows_( windows )
+	, face_size_( face_size )
+	, face_( 0 )
+	, active_( false )
+	, reported_( false )
+	, leader_frame_( 0 )
+	, order_reported_( false )
+{
+	std::fill( eye_, eye_ + 3, 0.0 );
+	frustum_ = FrustumParameters();
+}
+
+bool CubeMapGroup::Contains( int window_id ) const
+{
+	return windows_.end() != std::find( windows_.begin(), windows_.end(), window_id );
+}
+
+void CubeMapGroup::EndWindow( int window_id, unsigned int frame )
+{
+	if ( GetLeader() == window_id )
+	{
+		leader_frame_ = frame;
+		return;
+	}
+	if ( !active_ || order_reported_ || leader_frame_ == frame || !Contains( window_id ) )
+		return;
+	std::cout << "Warning: window_id " << window_id << " is processed before window_id " << GetLeader()
+		<< ", which renders the cube map of its group, and samples the previous frame. List first the window the IG processes first." << std::endl;
+	order_reported_ = true;
+}
+
+void CubeMapGroup::GetFaceView( int face, double view[16] ) const
+{
+	// rows right, up and backward, then the eye moved to the origin
+	const double* forward = kFaceForward[std::min( std::max( face, 0 ), 5 )];
+	const double* up = kFaceUp[std::min( std::max( face, 0 ), 5 )];
+	const double right[3] = { forward[1] * up[2] - forward[2] * up[1], forward[2] * up[0] - forward[0] * up[2], forward[0] * up[1] - forward[1] * up[0] };
+	for ( int column = 0; column < 3; ++column )
+	{
+		view[column * 4 + 0] = right[column];
+		view[column * 4 + 1] = up[column];
+		view[column * 4 + 2] = -forward[column];
+		view[column * 4 + 3] = 0.0;
+	}
+	for ( int row = 0; row < 3; ++row )
+		view[12 + row] = -( view[row] * eye_[0] + view[4 + row] * eye_[1] + view[8 + row] * eye_[2] );
+	view[15] = 1.0;
+}
+
+void CubeMapGroup::GetFaceFrustum( FrustumParameters& frustum ) const
+{
+	frustum = frustum_;
+}
+
+bool CubeMapGroup::Update( const std::map<int, ExternalFbo*>& fbos )
+{
+	std::vector<ExternalFbo*> members;
+	for ( size_t i = 0; i < windows_.size(); ++i )
+	{
+		std::map<int, ExternalFbo*>::const_iterator found = fbos.find( windows_[i] );
+		if ( fbos.end() == found )
+		{
+			// not every member has been drawn yet
+			Deactivate( fbos );
+			return false;
+		}
+		members.push_back( found->second );
+	}
+
+	ExternalFbo& leader = *members.front();
+	double leader_eye[3] = { 0.0, 0.0, 0.0 };
+	GetEye( leader.GetFrameSetup().view, leader_eye );
+	double density = 0.0;							// window pixels per unit of tangent
+	for ( size_t i = 0; i < members.size(); ++i )
+	{
+		const ExternalFbo::FrameSetup& setup = members[i]->GetFrameSetup();
+		if ( !setup.has_frustum || !setup.has_view )
+			return Fail( fbos, "a warper reports no frustum" );
+		if ( !members[i]->CanWarpCubeMap() )
+			return Fail( fbos, "a channel is not warped by the plugin yet" );
+		double eye[3];
+		GetEye( setup.view, eye );
+		if ( std::abs( eye[0] - leader_eye[0] ) + std::abs( eye[1] - leader_eye[1] ) + std::abs( eye[2] - leader_eye[2] ) > kEyeTolerance )
+			return Fail( fbos, "the channels do not share the leader's eye point" );
+
+		const double width = std::tan( setup.frustum.right_degrees * kToRadians ) - std::tan( setup.frustum.left_degrees * kToRadians );
+		const double height = std::tan( setup.frustum.top_degrees * kToRadians ) - std::tan( setup.frustum.bottom_degrees * kToRadians );
+		if ( !( width > 0.0 ) || !( height > 0.0 ) )
+			return Fail( fbos, "a warper reports an empty frustum" );
+		density = std::max( density, std::max( members[i]->GetWidth() / width, members[i]->GetHeight() / height ) );
+	}
+
+	// a face spans two units of tangent, three faces side by side and two rows fit one texture
+	GLint max_size = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+	const double wanted = face_size_ ? (double)face_size_ : std::ceil( 2.0 * density );
+	const unsigned int face = (unsigned int)std::max( std::min( wanted, max_size / 3.0 ), 1.0 );
+	if ( !active_ || std::abs( (double)face - (double)face_ ) > kResizeTolerance * face_ )
+	{
+		face_ = face;
+		leader.SetMosaicScene( 3 * face_, 2 * face_ );
+		std::cout << "Info: window_id " << GetLeader() << " renders a cube map of " << face_ << "x" << face_
+			<< " faces for " << members.size() << " channels." << std::endl;
+	}
+	for ( size_t i = 0; i < members.size(); ++i )
+		members[i]->SetCubeMapSource( &leader );
+
+	std::copy( leader_eye, leader_eye + 3, eye_ );
+	frustum_ = leader.GetFrameSetup().frustum;
+	frustum_.left_degrees = frustum_.bottom_degrees = -45.0f;
+	frustum_.right_degrees = frustum_.top_degrees = 45.0f;
+	active_ = true;
+	return true;
+}
+
+void CubeMapGroup::Deactivate( const std::map<int, ExternalFbo*>& fbos )
+{
+	if ( !active_ )
+		return;
+
+	for ( size_t i = 0; i < windows_.size(); ++i )
+	{
+		std::map<int, ExternalFbo*>::const_iterator found = fbos.find( windows_[i] );
+		if ( fbos.end() == found )
+			continue;
+		found->second->SetCubeMapSource( nullptr );
+		if ( GetLeader() == windows_[i] )
+			found->second->SetMosaicScene( 0, 0 );
+	}
+	active_ = false;
+}
+
+bool CubeMapGroup::Fail( const std::map<int, ExternalFbo*>& fbos, const char* reason )
+{
+	if ( !reported_ )
+		std::cout << "Warning: the cube map of window_id " << GetLeader() << " is off while " << reason << "." << std::endl;
+	reported_ = true;
+	Deactivate( fbos );
+	return false;
+}
@@ -0,0 +1,83 @@
+//==============================================================================
+// File:CubeMapGroup.h
+//==============================================================================
+//
+// Description: Channels sharing an eye point, e.g. the projectors of a dome,
+//				sampled from one cube map. The group's first window, the leader,
+//				has six views that render the faces of a cube around the eye
+//				point side by side into its scene target. Every member's warp
+//				then looks its directions up in the cube map, so the scene is
+//				rendered as six fixed faces whatever the number of projectors,
+//				and overlaps are no longer rendered twice. The other members'
+//				own renders collapse to a sliver of frustum like in a mosaic.
+//				The leader builds the cube map as it warps, so the IG has to
+//				process it first in a frame: a member processed before it looks
+//				up the previous frame, which EndWindow reports.
+//
+//==============================================================================
+
+#ifndef DVC_CUBE_MAP_GROUP_H
+#define DVC_CUBE_MAP_GROUP_H
+
+#include "ExternalFbo.h"
+
+#include <map>
+#include <vector>
+
+class CubeMapGroup
+{
+public:
+	/*!
+	 * @param[in] windows : ids of the members, the first one leads
+	 * @param[in] face_size : edge of a face in pixels at render scale 1, 0 matches the densest member
+	**/
+	CubeMapGroup( const std::vector<int>& windows, unsigned int face_size );
+
+	int GetLeader() const { return windows_.front(); }
+	bool Contains( int window_id ) const;
+
+	/*! The leader renders the faces this frame. **/
+	bool IsActive() const { return active_; }
+
+	/*!
+	 * What the leader's view of a face renders, in GL order: +x, -x, +y, -y, +z, -z of the
+	 * eyepoint frame.
+	 *
+	 * @param[out] view : the model view offset, column-major like the warpers' views
+	**/
+	void GetFaceView( int face, double view[16] ) const;
+	void GetFaceFrustum( FrustumParameters& frustum ) const;
+
+	/*!
+	 * Checks the members share an eye point and are warped by the plugin, sizes the leader's
+	 * scene for the coming frame and points every member at its cube map. Needs the members'
+	 * frame setups and the IG context.
+	 *
+	 * @return
+	 *  false until all members exist and can sample the cube map: every member renders its own
+	 *  scene then.
+	**/
+	bool Update( const std::map<int, ExternalFbo*>& fbos );
+
+	/*!
+	 * Records that the IG has finished a member's scene, in postWindowProcess. Warns once if a
+	 * member comes before the leader in a frame, since it samples the previous frame's faces.
+	**/
+	void EndWindow( int window_id, unsigned int frame );
+
+private:
+	void Deactivate( const std::map<int, ExternalFbo*>& fbos );
+	bool Fail( const std::map<int, ExternalFbo*>& fbos, const char* reason );
+
+	std::vector<int> windows_;
+	unsigned int face_size_;		/* configured, 0 follows the members */
+	unsigned int face_;				/* in use, kept while within 2% */
+	double eye_[3];					/* shared by the members, in the eyepoint frame */
+	FrustumParameters frustum_;		/* of a face, near and far of the leader */
+	bool active_;
+	bool reported_;					/* a failed check is reported once */
+	unsigned int leader_frame_;		/* the frame the leader's faces were last finished in */
+	bool order_reported_;			/* and a member ahead of it, once */
+};
+
+#endif // DVC_CUBE_MAP_GROUP_H
@@ -0,0 +1,66 @@
+//==============================================================================
+// File:ExposureControl.cpp
+//==============================================================================
+
+#include "ExposureControl.h"
+
+#include <algorithm>
+#include <cmath>
+
+ExposureControl::ExposureControl()
+	: key_( 0.0f )
+	, min_exposure_( 1.0f )
+	, max_exposure_( 1.0f )
+	, adapt_rate_( 1.0f )
+	, radiance_scale_( 0.0f )
+	, additional_radiance_( 0.0f )
+	, sample_sum_( 0.0 )
+	, sample_count_( 0 )
+	, adapted_log_( 0.0f )
+	, adapted_( false )
+	, exposure_( 1.0f )
+{
+}
+
+void ExposureControl::Configure( float key, float min_exposure, float max_exposure, float adapt_rate, float radiance_scale )
+{
+	key_ = std::max( key, 0.0f );
+	min_exposure_ = std::max( min_exposure, 1.0f / 64.0f );
+	max_exposure_ = std::max( max_exposure, min_exposure_ );
+	adapt_rate_ = std::max( adapt_rate, 0.0f );
+	radiance_scale_ = std::max( radiance_scale, 0.0f );
+	sample_sum_ = 0.0;
+	sample_count_ = 0;
+	adapted_ = false;
+	exposure_ = std::min( std::max( 1.0f, min_exposure_ ), max_exposure_ );
+}
+
+void ExposureControl::AddSample( float average_log )
+{
+	sample_sum_ += average_log;
+	++sample_count_;
+}
+
+void ExposureControl::Update( float frame_delta_time )
+{
+	if ( !IsEnabled() )
+		return;
+
+	// a frame without measurements keeps adapting towards the last ones
+	if ( sample_count_ > 0 )
+	{
+		const float measured_log = (float)( sample_sum_ / sample_count_ );
+		if ( !adapted_ )
+			adapted_log_ = measured_log;
+		else
+			adapted_log_ += ( measured_log - adapted_log_ ) * ( 1.0f - std::exp( -std::max( frame_delta_time, 0.0f ) * adapt_rate_ ) );
+		adapted_ = true;
+		sample_sum_ = 0.0;
+		sample_count_ = 0;
+	}
+	if ( !adapted_ )
+		return;
+
+	const float luminance = std::exp2( adapted_log_ ) + additional_radiance_ * radiance_scale_;
+	exposure_ = std::min( std::max( key_ / std::max( luminance, 1.0f / 1024.0f ), min_exposure_ ), max_exposure_ );
+}
@@ -0,0 +1,62 @@
+//==============================================================================
+// File:ExposureControl.h
+//==============================================================================
+//
+// Description: Exposure adaptation, shared by all windows so that blended
+//				channels match. The windows' luminance measurements are averaged
+//				every frame and followed smoothly in log space, like an eye
+//				adapting to dusk. The IG's additional radiance, e.g. lightning,
+//				darkens the exposure at once, without smoothing.
+//
+//==============================================================================
+
+#ifndef DVC_EXPOSURE_CONTROL_H
+#define DVC_EXPOSURE_CONTROL_H
+
+class ExposureControl
+{
+public:
+	ExposureControl();
+
+	/*!
+	 * @param[in] key : luminance the adapted scene is exposed to, 0 disables adaptation
+	 * @param[in] min_exposure, max_exposure : bounds of the scale applied to the scene
+	 * @param[in] adapt_rate : per second, 1 closes about 63% of the gap in a second
+	 * @param[in] radiance_scale : luminance one unit of additional radiance adds
+	**/
+	void Configure( float key, float min_exposure, float max_exposure, float adapt_rate, float radiance_scale );
+
+	bool IsEnabled() const { return key_ > 0.0f; }
+
+	/*! From the IG, see IUserDefinedImageProcessor200::setAdditionalRadiance. **/
+	void SetAdditionalRadiance( double additional_radiance ) { additional_radiance_ = additional_radiance > 0.0 ? (float)additional_radiance : 0.0f; }
+
+	/*! A window's measurement, see LuminanceHistogram::TakeResult. **/
+	void AddSample( float average_log );
+
+	/*!
+	 * Adapts to the samples since the last call. Once per frame, before the windows.
+	 *
+	 * @param[in] frame_delta_time : seconds since the last call
+	**/
+	void Update( float frame_delta_time );
+
+	/*! Scale of the scene ahead of the tone curve. 1 until the first samples arrive. **/
+	float GetExposure() const { return exposure_; }
+
+private:
+	float key_;
+	float min_exposure_;
+	float max_exposure_;
+	float adapt_rate_;
+	float radiance_scale_;
+	float additional_radiance_;
+
+	double sample_sum_;			/* of log2 luminance, since the last Update */
+	unsigned int sample_count_;
+	float adapted_log_;			/* log2 of the luminance the exposure follows */
+	bool adapted_;				/* false until the first samples */
+	float exposure_;
+};
+
+#endif // DVC_EXPOSURE_CONTROL_H
@@ -4,8 +4,15 @@
 
 // User Includes
 #include "ExternalFbo.h"
+#include "GlStateCache.h"
+#include "StereoTarget.h"
+#include "TemporalResolve.h"
+#include "WarpCoverage.h"
+#include "WarpRenderer.h"
 
 // System Includes
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #define VIOSOWARPBLEND_DYNAMIC_IMPLEMENT
@@ -15,6 +22,8 @@
 
 namespace
 {
+	const float kMaxTrimmedArea = 0.98f;	// a region nearly as large as the channel is rendered whole
+
 	GLuint CreateTexture( unsigned internal_format, unsigned width, unsigned height, unsigned format, unsigned type )
 	{
 		GLuint tex = 0;
@@ -56,6 +65,21 @@ ExternalFbo()
 	, existing_fbo_( 0 )
 	, window_w_( 0 )
 	, window_h_( 0 )
+	, scene_w_( 0 )
+	, scene_h_( 0 )
+	, capacity_w_( 0 )
+	, capacity_h_( 0 )
+	, scene_scale_( 1.0f )
+	, mosaic_w_( 0 )
+	, mosaic_h_( 0 )
+	, mosaic_scene_( nullptr )
+	, cube_map_( false )
+	, cube_texture_( 0 )
+	, cube_face_( 0 )
+	, resolve_texture_( 0 )
+	, resolve_fbo_( 0 )
+	, resolve_w_( 0 )
+	, resolve_h_( 0 )
 	, depth_format_( GL_DEPTH_COMPONENT32F_NV )
 	, internal_format_( GL_RGBA )
 	, format_( GL_RGBA )
@@ -63,14 +87,53 @@ ExternalFbo()
 	, coverage_samples_( 4 )
 	, color_samples_( 4 )
 	, warper_(nullptr)
+	, warp_renderer_( nullptr )
+	, coverage_( nullptr )
+	, active_profile_( 0 )
+	, trimmed_( false )
+	, temporal_( nullptr )
+	, scene_resolved_( false )
+	, stereo_( nullptr )
+	, stereo_eye_( 0 )
 {
-
+	warp_settings_.tile_size = 0;
+	warp_settings_.max_error = 0.0f;
+	warp_settings_.output_width = 0;
+	warp_settings_.output_height = 0;
+	warp_settings_.program_cache = nullptr;
+	warp_settings_.post_chain = nullptr;
+	warp_settings_.render_scale = 1.0f;
+	warp_settings_.min_render_scale = 1.0f;
+	warp_settings_.sharpness = 0.0f;
+	warp_settings_.temporal_feedback = 0.0f;
+	warp_settings_.foveation.inset_view = -1;
+	warp_settings_.foveation.inset_size = 1.0f;
+	warp_settings_.foveation.periphery_scale = 1.0f;
+	warp_settings_.foveation.border = 0.0f;
+	warp_settings_.cube_map = false;
+	warp_settings_.trim_frustum = false;
+	warp_settings_.trim_guard = 0.0f;
+	warp_settings_.mip_levels = 0;
+	warp_settings_.stereo.left_view = -1;
+	warp_settings_.stereo.right_view = -1;
+	warp_settings_.stereo.eye_separation = 0.0f;
+	warp_settings_.stereo.convergence = 1.0f;
+	warp_settings_.stereo.layout = STEREO_SIDE_BY_SIDE;
+	frame_setup_.has_used_region = false;
+	trimmed_frustum_ = FrustumParameters();
+	std::fill( trim_region_, trim_region_ + 4, 0.0f );
+	frame_setup_.has_frustum = false;
+	frame_setup_.has_view = false;
+	foveated_layout_ = FoveatedLayout();
+	std::fill( mosaic_rect_, mosaic_rect_ + 4, 0.0f );
+	std::fill( cube_framebuffers_, cube_framebuffers_ + 6, 0u );
 }
 
-void
+bool
 ExternalFbo::
-Load( bool multisample, unsigned int width, unsigned int height, VWB_Warper* pWarper )
+Load( bool multisample, unsigned int width, unsigned int height, VWB_Warper* pWarper, const WarpSettings& warp_settings )
 {
+	warp_settings_ = warp_settings;
 	use_multisampling_ = multisample;
 	depth_format_ = GL_DEPTH_COMPONENT32F_NV;
 
@@ -78,29 +141,149 @@ Load( bool multisample, unsigned int width, unsigned int height, VWB_Warper* pWa
 
 	window_w_ = width;
 	window_h_ = height;
+	warp_settings_.output_width = width;
+	warp_settings_.output_height = height;
+	scene_scale_ = warp_settings_.render_scale;
+	UpdateSceneSize();
 
-	if ( use_multisampling_ )
+	// both eyes in the layers of one target, the warp packs them into the window
+	if ( warp_settings_.stereo.left_view >= 0 )
 	{
-		scene_color_texture_ = CreateMultiTexture(    color_samples_, internal_format_, window_w_, window_h_ );
-		scene_depth_texture_ = CreateMultiTexture( coverage_samples_,    depth_format_, window_w_, window_h_ );
+		stereo_ = new StereoTarget;
+		if ( !stereo_->Load( use_multisampling_, color_samples_, capacity_w_, capacity_h_ ) )
+		{
+			// the warp renders the mono scene then
+			delete stereo_;
+			stereo_ = nullptr;
+			warp_settings_.stereo.left_view = -1;
+		}
+	}
+
+	// allocated at the largest scale, a smaller scene uses the lower left
+	if ( stereo_ )
+	{
+		std::cout << "Info: stereo scene, views " << warp_settings_.stereo.left_view << " and " << warp_settings_.stereo.right_view
+			<< " render the left and the right eye." << std::endl;
+	}
+	else if ( use_multisampling_ )
+	{
+		scene_color_texture_ = CreateMultiTexture(    color_samples_, internal_format_, capacity_w_, capacity_h_ );
+		scene_depth_texture_ = CreateMultiTexture( coverage_samples_,    depth_format_, capacity_w_, capacity_h_ );
 	}
 	else
 	{
-		scene_color_texture_ = CreateTexture( internal_format_, window_w_, window_h_,            format_, type_    );
-		scene_depth_texture_ = CreateTexture(    depth_format_, window_w_, window_h_, GL_DEPTH_COMPONENT, GL_FLOAT );
+		scene_color_texture_ = CreateTexture( internal_format_, capacity_w_, capacity_h_,            format_, type_    );
+		scene_depth_texture_ = CreateTexture(    depth_format_, capacity_w_, capacity_h_, GL_DEPTH_COMPONENT, GL_FLOAT );
 	}
+	if ( warp_settings_.min_render_scale < warp_settings_.render_scale )
+		std::cout << "Info: scene rendered at " << warp_settings_.min_render_scale << " to " << warp_settings_.render_scale
+			<< " of a " << window_w_ << "x" << window_h_ << " window." << std::endl;
+	else if ( IsScaled() )
+		std::cout << "Info: scene rendered at " << scene_w_ << "x" << scene_h_ << " for a " << window_w_ << "x" << window_h_ << " window." << std::endl;
 
 	glGenFramebuffers( 1, &fbo_ );
-	glNamedFramebufferTextureEXT( fbo_, GL_COLOR_ATTACHMENT0, scene_color_texture_, 0 );
-	glNamedFramebufferTextureEXT( fbo_, GL_DEPTH_ATTACHMENT , scene_depth_texture_, 0 );
+	glNamedFramebufferTextureEXT( fbo_, GL_COLOR_ATTACHMENT0, stereo_ ? stereo_->GetColorTexture() : scene_color_texture_, 0 );
+	glNamedFramebufferTextureEXT( fbo_, GL_DEPTH_ATTACHMENT , stereo_ ? stereo_->GetDepthTexture() : scene_depth_texture_, 0 );
 
 	const GLenum status = glCheckNamedFramebufferStatusEXT( fbo_, GL_FRAMEBUFFER_EXT );
 	if (GL_FRAMEBUFFER_COMPLETE_EXT != status)
 	{
 		std::cout << "external rendering will fail due to FBO error: " << status << std::endl;
-		return;
+		VWB_Destroy( pWarper );
+		return false;
 	}
 	warper_ = pWarper;
+
+	if ( !use_multisampling_ && warp_settings_.temporal_feedback > 0.0f && warp_settings_.program_cache )
+	{
+		temporal_ = new TemporalResolve;
+		if ( !temporal_->Load( *warp_settings_.program_cache, warp_settings_.temporal_feedback ) )
+			std::cout << "Warning: the temporal resolve is not available, the scene stays aliased." << std::endl;
+	}
+
+	const Profile profile = LoadProfile( warper_, warp_settings_ );
+	warp_renderer_ = profile.warp_renderer;
+	coverage_ = profile.coverage;
+	profiles_.push_back( profile );
+	active_profile_ = 0;
+	return true;
+}
+
+ExternalFbo::Profile
+ExternalFbo::
+LoadProfile( VWB_Warper* warper, const WarpSettings& settings )
+{
+	Profile profile = { warper, nullptr, nullptr };
+	if ( warper && settings.tile_size > 0 )
+	{
+		profile.warp_renderer = new WarpRenderer;
+		profile.warp_renderer->Load( warper, settings );
+	}
+	// trimmed frusta are remapped by the plugin's warp alone
+	if ( profile.warp_renderer && settings.trim_frustum )
+	{
+		profile.coverage = new WarpCoverage;
+		profile.coverage->Load( warper );
+	}
+	return profile;
+}
+
+void ExternalFbo::ReleaseResources( Profile& profile )
+{
+	if ( profile.warp_renderer )
+	{
+		profile.warp_renderer->Unload();
+		delete profile.warp_renderer;
+	}
+	delete profile.coverage;
+	profile.warp_renderer = nullptr;
+	profile.coverage = nullptr;
+}
+
+ExternalFbo::Profile
+ExternalFbo::
+SwapProfile( const Profile& profile )
+{
+	if ( profiles_.empty() )
+		return profile;
+
+	// profile 0 is the hot reloaded one, active or not
+	const Profile previous = profiles_.front();
+	profiles_.front() = profile;
+	if ( 0 == active_profile_ )
+	{
+		warper_ = profile.warper;
+		warp_renderer_ = profile.warp_renderer;
+		coverage_ = profile.coverage;
+		trimmed_ = false;
+		if ( temporal_ )
+			temporal_->Reset();
+	}
+	return previous;
+}
+
+void ExternalFbo::AddProfile( VWB_Warper* warper )
+{
+	profiles_.push_back( LoadProfile( warper, warp_settings_ ) );
+}
+
+bool ExternalFbo::SelectProfile( size_t profile )
+{
+	if ( profile >= profiles_.size() || nullptr == profiles_[profile].warper )
+		return false;
+	if ( profile == active_profile_ )
+		return true;
+
+	const Profile& selected = profiles_[profile];
+	warper_ = selected.warper;
+	warp_renderer_ = selected.warp_renderer;
+	coverage_ = selected.coverage;
+	active_profile_ = profile;
+	trimmed_ = false;
+	// the history holds the previous calibration's image
+	if ( temporal_ )
+		temporal_->Reset();
+	return true;
 }
 
 void ExternalFbo::UpdateWindowSize( unsigned int width, unsigned int height )
@@ -109,47 +292,385 @@ void ExternalFbo::UpdateWindowSize( unsigned int width, unsigned int height )
 
 	window_w_ = width;
 	window_h_ = height;
+	// maps loaded from now on measure their encoding error in the new size
+	warp_settings_.output_width = width;
+	warp_settings_.output_height = height;
+	UpdateSceneSize();
+	ResizeTargets();
+}
 
-	if ( use_multisampling_ )
+void ExternalFbo::ResizeTargets()
+{
+	if ( stereo_ )
+	{
+		// the layers have immutable storage, new views are handed to the IG
+		stereo_->Load( use_multisampling_, color_samples_, capacity_w_, capacity_h_ );
+		glNamedFramebufferTextureEXT( fbo_, GL_COLOR_ATTACHMENT0, stereo_->GetColorTexture(), 0 );
+		glNamedFramebufferTextureEXT( fbo_, GL_DEPTH_ATTACHMENT , stereo_->GetDepthTexture(), 0 );
+	}
+	else if ( use_multisampling_ )
 	{
 		glBindMultiTextureEXT( GL_TEXTURE0, GL_TEXTURE_2D_MULTISAMPLE, scene_color_texture_ );
-		glTexImage2DMultisample( GL_TEXTURE_2D_MULTISAMPLE, color_samples_, internal_format_, window_w_, window_h_, GL_TRUE );
+		glTexImage2DMultisample( GL_TEXTURE_2D_MULTISAMPLE, color_samples_, internal_format_, capacity_w_, capacity_h_, GL_TRUE );
 		glBindMultiTextureEXT( GL_TEXTURE0, GL_TEXTURE_2D_MULTISAMPLE, scene_depth_texture_ );
-		glTexImage2DMultisample( GL_TEXTURE_2D_MULTISAMPLE, coverage_samples_, depth_format_, window_w_, window_h_, GL_TRUE );
+		glTexImage2DMultisample( GL_TEXTURE_2D_MULTISAMPLE, coverage_samples_, depth_format_, capacity_w_, capacity_h_, GL_TRUE );
 		glBindMultiTextureEXT( GL_TEXTURE0, GL_TEXTURE_2D_MULTISAMPLE, 0 );
 	}
 	else
 	{
-		glTextureImage2DEXT( scene_color_texture_, GL_TEXTURE_2D, 0, internal_format_, window_w_, window_h_, 0,            format_,    type_, 0 );
-		glTextureImage2DEXT( scene_depth_texture_, GL_TEXTURE_2D, 0,    depth_format_, window_w_, window_h_, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0 );
+		glTextureImage2DEXT( scene_color_texture_, GL_TEXTURE_2D, 0, internal_format_, capacity_w_, capacity_h_, 0,            format_,    type_, 0 );
+		glTextureImage2DEXT( scene_depth_texture_, GL_TEXTURE_2D, 0,    depth_format_, capacity_w_, capacity_h_, 0, GL_DEPTH_COMPONENT, GL_FLOAT, 0 );
+	}
+}
+
+GLuint ExternalFbo::GetSceneColorTexture() const
+{
+	return stereo_ ? stereo_->GetColorView( stereo_eye_ ) : scene_color_texture_;
+}
+
+GLuint ExternalFbo::GetSceneDepthTexture() const
+{
+	return stereo_ ? stereo_->GetDepthView( stereo_eye_ ) : scene_depth_texture_;
+}
+
+int ExternalFbo::GetStereoEye( int view_id ) const
+{
+	if ( nullptr == stereo_ )
+		return -1;
+	return warp_settings_.stereo.left_view == view_id ? 0 : warp_settings_.stereo.right_view == view_id ? 1 : -1;
+}
+
+void ExternalFbo::BeginStereoView( int view_id )
+{
+	const int eye = GetStereoEye( view_id );
+	if ( eye < 0 )
+		return;
+	stereo_eye_ = eye;
+
+	// the IG has bound the framebuffer it attached the previous eye's views to
+	GLint framebuffer = 0;
+	glGetIntegerv( GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer );
+	if ( 0 != framebuffer )
+		stereo_->AttachEye( framebuffer, eye );
+}
+
+void ExternalFbo::UpdateFoveation( const FrustumParameters& channel, const float* gaze_direction )
+{
+	if ( !IsFoveated() )
+		return;
+
+	const FoveationSettings& settings = warp_settings_.foveation;
+	const double to_radians = 3.14159265358979 / 180.0;
+	const double left = std::tan( channel.left_degrees * to_radians );
+	const double right = std::tan( channel.right_degrees * to_radians );
+	const double bottom = std::tan( channel.bottom_degrees * to_radians );
+	const double top = std::tan( channel.top_degrees * to_radians );
+
+	// the gaze in the channel's view space, where it crosses the image plane
+	double center[2] = { 0.5, 0.5 };
+	if ( gaze_direction )
+	{
+		const VWB_float* view = frame_setup_.view;
+		double direction[3];
+		for ( int row = 0; row < 3; ++row )
+			direction[row] = view[row] * gaze_direction[0] + view[4 + row] * gaze_direction[1] + view[8 + row] * gaze_direction[2];
+		if ( direction[2] < 0.0 )
+		{
+			center[0] = ( direction[0] / -direction[2] - left ) / ( right - left );
+			center[1] = ( direction[1] / -direction[2] - bottom ) / ( top - bottom );
+		}
+	}
+
+	// the inset stays inside the channel, looking past its edge details the nearest part
+	const double size = settings.inset_size;
+	FoveatedLayout& layout = foveated_layout_;
+	for ( int i = 0; i < 2; ++i )
+	{
+		layout.inset_channel[i] = (float)( std::min( std::max( center[i], 0.5 * size ), 1.0 - 0.5 * size ) - 0.5 * size );
+		layout.inset_channel[2 + i] = (float)size;
 	}
+	layout.border = settings.border;
+
+	// tangents are linear across the channel
+	layout.inset_frustum = channel;
+	layout.inset_frustum.left_degrees = (float)( std::atan( left + ( right - left ) * layout.inset_channel[0] ) / to_radians );
+	layout.inset_frustum.right_degrees = (float)( std::atan( left + ( right - left ) * ( layout.inset_channel[0] + size ) ) / to_radians );
+	layout.inset_frustum.bottom_degrees = (float)( std::atan( bottom + ( top - bottom ) * layout.inset_channel[1] ) / to_radians );
+	layout.inset_frustum.top_degrees = (float)( std::atan( bottom + ( top - bottom ) * ( layout.inset_channel[1] + size ) ) / to_radians );
+
+	// the periphery at the lower left of the scene, the inset at scene resolution to its right
+	layout.periphery[0] = std::max( (int)( scene_w_ * settings.periphery_scale + 0.5f ), 1 );
+	layout.periphery[1] = std::max( (int)( scene_h_ * settings.periphery_scale + 0.5f ), 1 );
+	layout.inset[0] = layout.periphery[0];
+	layout.inset[1] = 0;
+	layout.inset[2] = std::max( std::min( (int)( scene_w_ * size + 0.5 ), (int)scene_w_ - layout.periphery[0] ), 1 );
+	layout.inset[3] = std::max( std::min( (int)( scene_h_ * size + 0.5 ), (int)scene_h_ ), 1 );
+}
+
+void ExternalFbo::UpdateTrim()
+{
+	// the plugin's warp remaps the region, other sources and layouts expect the whole channel
+	const float* region = frame_setup_.used_region;
+	trimmed_ = frame_setup_.has_used_region && warp_renderer_ && warp_renderer_->IsReady()
+		&& !IsFoveated() && !IsMosaic() && !IsTemporal() && region[2] * region[3] < kMaxTrimmedArea;
+	if ( !trimmed_ )
+		return;
+
+	// snapped outwards to whole scene pixels, so the trimmed render keeps the channel's pixel size
+	const double left = std::floor( region[0] * (double)scene_w_ );
+	const double bottom = std::floor( region[1] * (double)scene_h_ );
+	const double right = std::max( std::ceil( ( region[0] + region[2] ) * (double)scene_w_ ), left + 1.0 );
+	const double top = std::max( std::ceil( ( region[1] + region[3] ) * (double)scene_h_ ), bottom + 1.0 );
+	trim_region_[0] = (float)( left / scene_w_ );
+	trim_region_[1] = (float)( bottom / scene_h_ );
+	trim_region_[2] = (float)( ( right - left ) / scene_w_ );
+	trim_region_[3] = (float)( ( top - bottom ) / scene_h_ );
+
+	const double to_radians = 3.14159265358979 / 180.0;
+	const FrustumParameters& channel = frame_setup_.frustum;
+	const double tangent_left = std::tan( channel.left_degrees * to_radians );
+	const double tangent_right = std::tan( channel.right_degrees * to_radians );
+	const double tangent_bottom = std::tan( channel.bottom_degrees * to_radians );
+	const double tangent_top = std::tan( channel.top_degrees * to_radians );
+	const double width = tangent_right - tangent_left;
+	const double height = tangent_top - tangent_bottom;
+	trimmed_frustum_ = channel;
+	trimmed_frustum_.left_degrees = (float)( std::atan( tangent_left + width * left / scene_w_ ) / to_radians );
+	trimmed_frustum_.right_degrees = (float)( std::atan( tangent_left + width * right / scene_w_ ) / to_radians );
+	trimmed_frustum_.bottom_degrees = (float)( std::atan( tangent_bottom + height * bottom / scene_h_ ) / to_radians );
+	trimmed_frustum_.top_degrees = (float)( std::atan( tangent_bottom + height * top / scene_h_ ) / to_radians );
+}
+
+unsigned int ExternalFbo::GetRenderWidth() const
+{
+	return trimmed_ ? std::max( (unsigned int)( trim_region_[2] * scene_w_ + 0.5f ), 1u ) : scene_w_;
+}
+
+unsigned int ExternalFbo::GetRenderHeight() const
+{
+	return trimmed_ ? std::max( (unsigned int)( trim_region_[3] * scene_h_ + 0.5f ), 1u ) : scene_h_;
+}
+
+void ExternalFbo::SetSceneScale( float scale )
+{
+	scene_scale_ = scale;
+	UpdateSceneSize();
+}
+
+void ExternalFbo::SetMosaicScene( unsigned int width, unsigned int height )
+{
+	if ( mosaic_w_ == width && mosaic_h_ == height )
+		return;
+
+	mosaic_w_ = width;
+	mosaic_h_ = height;
+	UpdateSceneSize();
+	ResizeTargets();
+	// the history belongs to the previous frustum
+	if ( temporal_ )
+		temporal_->Reset();
+}
+
+void ExternalFbo::SetMosaicSource( ExternalFbo* scene, const float rect[4] )
+{
+	mosaic_scene_ = scene;
+	cube_map_ = false;
+	if ( scene && rect )
+		std::copy( rect, rect + 4, mosaic_rect_ );
+}
+
+void ExternalFbo::SetCubeMapSource( ExternalFbo* scene )
+{
+	mosaic_scene_ = scene;
+	cube_map_ = nullptr != scene;
+}
+
+bool ExternalFbo::CanWarpCubeMap()
+{
+	return warp_renderer_ && warp_renderer_->IsReady();
+}
+
+void ExternalFbo::UpdateSceneSize()
+{
+	// a mosaic leader renders for its whole group
+	const unsigned int base_w = mosaic_w_ ? mosaic_w_ : window_w_;
+	const unsigned int base_h = mosaic_h_ ? mosaic_h_ : window_h_;
+	const float max_scale = std::min( std::max( warp_settings_.render_scale, 0.25f ), 1.0f );
+	const float min_scale = std::min( std::max( warp_settings_.min_render_scale, 0.25f ), max_scale );
+	const float scale = std::min( std::max( scene_scale_, min_scale ), max_scale );
+	capacity_w_ = std::max( (unsigned int)( base_w * max_scale + 0.5f ), 1u );
+	capacity_h_ = std::max( (unsigned int)( base_h * max_scale + 0.5f ), 1u );
+	scene_w_ = std::min( std::max( (unsigned int)( base_w * scale + 0.5f ), 1u ), capacity_w_ );
+	scene_h_ = std::min( std::max( (unsigned int)( base_h * scale + 0.5f ), 1u ), capacity_h_ );
+}
+
+void ExternalFbo::GetMosaicSource( const float part[4], GLuint& framebuffer, int rect[4] )
+{
+	// the leader has resolved its scene before any member warps, if anyone resolves it in a pass
+	framebuffer = scene_resolved_ ? temporal_->GetFramebuffer() : fbo_;
+	const int left = (int)( part[0] * scene_w_ + 0.5f );
+	const int bottom = (int)( part[1] * scene_h_ + 0.5f );
+	const int right = (int)( ( part[0] + part[2] ) * scene_w_ + 0.5f );
+	const int top = (int)( ( part[1] + part[3] ) * scene_h_ + 0.5f );
+	rect[0] = std::min( left, (int)scene_w_ - 1 );
+	rect[1] = std::min( bottom, (int)scene_h_ - 1 );
+	rect[2] = std::max( std::min( right, (int)scene_w_ ) - rect[0], 1 );
+	rect[3] = std::max( std::min( top, (int)scene_h_ ) - rect[1], 1 );
+}
+
+GLuint ExternalFbo::GetResolveFramebuffer( unsigned int width, unsigned int height )
+{
+	if ( resolve_texture_ && resolve_w_ >= width && resolve_h_ >= height )
+		return resolve_fbo_;
+
+	resolve_w_ = std::max( width, resolve_w_ );
+	resolve_h_ = std::max( height, resolve_h_ );
+	if ( 0 == resolve_texture_ )
+	{
+		resolve_texture_ = CreateTexture( internal_format_, resolve_w_, resolve_h_, format_, type_ );
+		glGenFramebuffers( 1, &resolve_fbo_ );
+		glNamedFramebufferTextureEXT( resolve_fbo_, GL_COLOR_ATTACHMENT0, resolve_texture_, 0 );
+	}
+	else
+	{
+		glTextureImage2DEXT( resolve_texture_, GL_TEXTURE_2D, 0, internal_format_, resolve_w_, resolve_h_, 0, format_, type_, 0 );
+	}
+	return resolve_fbo_;
+}
+
+GLuint ExternalFbo::BuildCubeMap( GlStateCache& gl_state )
+{
+	// the faces lie in a 3x2 grid, +x -x +y on the bottom row
+	const unsigned int face = std::max( std::min( scene_w_ / 3, scene_h_ / 2 ), 1u );
+	if ( face != cube_face_ )
+	{
+		if ( 0 == cube_texture_ )
+		{
+			glGenTextures( 1, &cube_texture_ );
+			glTextureParameteriEXT( cube_texture_, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+			glTextureParameteriEXT( cube_texture_, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+			glTextureParameteriEXT( cube_texture_, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+			glTextureParameteriEXT( cube_texture_, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+			// filtered across the face edges, where available without changing the IG's global state
+			if ( GLEW_ARB_seamless_cubemap_per_texture )
+				glTextureParameteriEXT( cube_texture_, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_SEAMLESS, GL_TRUE );
+			glGenFramebuffers( 6, cube_framebuffers_ );
+		}
+		for ( int i = 0; i < 6; ++i )
+		{
+			glTextureImage2DEXT( cube_texture_, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internal_format_, face, face, 0, format_, type_, 0 );
+			glNamedFramebufferTexture2DEXT( cube_framebuffers_[i], GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, cube_texture_, 0 );
+		}
+		cube_face_ = face;
+	}
+
+	GLuint framebuffer = fbo_;
+	GLuint texture = scene_color_texture_;
+	gl_state.Disable( GL_SCISSOR_TEST );
+	if ( temporal_ && temporal_->IsReady() )
+	{
+		texture = temporal_->Resolve( scene_color_texture_, scene_w_, scene_h_, gl_state );
+		framebuffer = temporal_->GetFramebuffer();
+	}
+	else if ( use_multisampling_ )
+	{
+		// resolved once for all faces and for the exposure measurement
+		gl_state.BindFramebuffer( fbo_ );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, GetResolveFramebuffer( scene_w_, scene_h_ ) );
+		glBlitFramebuffer( 0, 0, scene_w_, scene_h_, 0, 0, scene_w_, scene_h_, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		framebuffer = resolve_fbo_;
+		texture = resolve_texture_;
+	}
+
+	gl_state.BindFramebuffer( framebuffer );
+	for ( int i = 0; i < 6; ++i )
+	{
+		const int x = ( i % 3 ) * face;
+		const int y = ( i / 3 ) * face;
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, cube_framebuffers_[i] );
+		glBlitFramebuffer( x, y, x + face, y + face, 0, 0, face, face, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	}
+	gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+	return texture;
+}
+
+void ExternalFbo::ReleaseCubeMap()
+{
+	if ( cube_texture_ )
+	{
+		glDeleteTextures( 1, &cube_texture_ );
+		glDeleteFramebuffers( 6, cube_framebuffers_ );
+	}
+	cube_texture_ = 0;
+	std::fill( cube_framebuffers_, cube_framebuffers_ + 6, 0u );
+	cube_face_ = 0;
 }
 
 void
 ExternalFbo::
 Unload()
 {
+	// the profiles not selected, the active one follows
+	for ( size_t i = 0; i < profiles_.size(); ++i )
+	{
+		Profile& profile = profiles_[i];
+		if ( i == active_profile_ )
+			continue;
+		if ( nullptr != VWB_Destroy && profile.warper )
+			VWB_Destroy( profile.warper );
+		ReleaseResources( profile );
+	}
+	profiles_.clear();
+	active_profile_ = 0;
+
 	if (nullptr != VWB_Destroy)
 		VWB_Destroy(warper_);
 
+	if ( warp_renderer_ )
+	{
+		warp_renderer_->Unload();
+		delete warp_renderer_;
+		warp_renderer_ = nullptr;
+	}
+	if ( temporal_ )
+	{
+		temporal_->Unload();
+		delete temporal_;
+		temporal_ = nullptr;
+	}
+	delete coverage_;
+	coverage_ = nullptr;
+	trimmed_ = false;
+	if ( stereo_ )
+	{
+		stereo_->Unload();
+		delete stereo_;
+		stereo_ = nullptr;
+	}
+
 	if ( scene_color_texture_ ) glDeleteTextures(     1, &scene_color_texture_ );
 	if ( scene_depth_texture_ ) glDeleteTextures(     1, &scene_depth_texture_ );
 	if ( fbo_ )					glDeleteFramebuffers( 1, &fbo_                 );
+	if ( resolve_texture_ )		glDeleteTextures(     1, &resolve_texture_     );
+	if ( resolve_fbo_ )			glDeleteFramebuffers( 1, &resolve_fbo_         );
+	resolve_texture_ = resolve_fbo_ = 0;
+	resolve_w_ = resolve_h_ = 0;
+	ReleaseCubeMap();
 }
 
 void
 ExternalFbo::
-BindFbo()
+BindFbo( GlStateCache& gl_state )
 {
-	glGetIntegerv( GL_FRAMEBUFFER_BINDING, &existing_fbo_ );
-	glBindFramebuffer( GL_FRAMEBUFFER, fbo_ );
+	existing_fbo_ = gl_state.GetFramebuffer();
+	gl_state.BindFramebuffer( fbo_ );
 }
 
 void
 ExternalFbo::
-UnBindFbo()
+UnBindFbo( GlStateCache& gl_state )
 {
-	glBindFramebuffer( GL_FRAMEBUFFER, existing_fbo_ );	
+	gl_state.BindFramebuffer( existing_fbo_ );
 }
 
 void
@@ -161,6 +682,244 @@ RenderWarp() const
 	VWB_render(warper_, (VWB_param)(size_t)scene_color_texture_, VWB_STATEMASK_DEFAULT | VWB_STATEMASK_VERTEX_SHADER | VWB_STATEMASK_SHADER_RESOURCE );
 }
 
+bool
+ExternalFbo::
+RenderTiledWarp( GLuint source_framebuffer, GlStateCache& gl_state )
+{
+	if ( nullptr == warp_renderer_ || !warp_renderer_->IsReady() )
+		return false;
+
+	if ( stereo_ )
+	{
+		// both eyes in one draw, each with its own view of a 3D map
+		StereoSource stereo;
+		stereo.texture = stereo_->Resolve( scene_w_, scene_h_, gl_state );
+		for ( int eye = 0; eye < 2; ++eye )
+		{
+			StereoTarget::GetEyeViewProj( warp_settings_.stereo, eye, frame_setup_.proj, frame_setup_.view, stereo.view_proj[eye] );
+			StereoTarget::GetEyeRect( warp_settings_.stereo.layout, eye, stereo.eye_rects[eye] );
+		}
+		const int rect[4] = { 0, 0, (int)scene_w_, (int)scene_h_ };
+		warp_renderer_->SetStereoSource( &stereo );
+		warp_renderer_->Render( 0, stereo.texture, rect, gl_state.GetFramebuffer(), window_w_, window_h_, frame_setup_.view_proj, gl_state );
+		warp_renderer_->SetStereoSource( nullptr );
+		return true;
+	}
+
+	if ( IsCubeMap() )
+	{
+		// every channel looks its directions up in the leader's faces, the leader measures them all
+		CubeMapSource cube;
+		const GLuint scene_texture = IsMosaicFollower() ? 0 : BuildCubeMap( gl_state );
+		cube.texture = mosaic_scene_->cube_texture_;
+		for ( int column = 0; column < 3; ++column )
+			for ( int row = 0; row < 3; ++row )
+				cube.channel_to_eye[column * 3 + row] = frame_setup_.view[row * 4 + column];
+		const double to_radians = 3.14159265358979 / 180.0;
+		cube.tangents[0] = (float)std::tan( frame_setup_.frustum.left_degrees * to_radians );
+		cube.tangents[1] = (float)std::tan( frame_setup_.frustum.right_degrees * to_radians );
+		cube.tangents[2] = (float)std::tan( frame_setup_.frustum.bottom_degrees * to_radians );
+		cube.tangents[3] = (float)std::tan( frame_setup_.frustum.top_degrees * to_radians );
+		const int rect[4] = { 0, 0, (int)scene_w_, (int)scene_h_ };
+		warp_renderer_->SetFoveatedLayout( nullptr );
+		warp_renderer_->SetCubeMapSource( &cube );
+		warp_renderer_->Render( 0, scene_texture, rect, gl_state.GetFramebuffer(), window_w_, window_h_, frame_setup_.view_proj, gl_state );
+		warp_renderer_->SetCubeMapSource( nullptr );
+		return true;
+	}
+
+	// in temporal mode each window's warp resolves what it samples of the jittered scene
+	TemporalSource temporal = { 0, 0.0f };
+	const bool warp_resolves = temporal_ && warp_renderer_->IsTemporal();
+	if ( warp_resolves )
+		temporal_->GetWarpSource( window_w_, window_h_, temporal );
+
+	if ( IsMosaic() )
+	{
+		// the leader's part is warped first, a resolve of its own would serve the whole group
+		if ( !IsMosaicFollower() )
+		{
+			scene_resolved_ = !warp_resolves && temporal_ && temporal_->IsReady();
+			if ( scene_resolved_ )
+				temporal_->Resolve( scene_color_texture_, scene_w_, scene_h_, gl_state );
+		}
+		GLuint framebuffer = 0;
+		int rect[4];
+		mosaic_scene_->GetMosaicSource( mosaic_rect_, framebuffer, rect );
+		warp_renderer_->SetFoveatedLayout( nullptr );
+		warp_renderer_->SetTemporalSource( warp_resolves ? &temporal : nullptr );
+		warp_renderer_->Render( framebuffer, 0, rect, gl_state.GetFramebuffer(), window_w_, window_h_, frame_setup_.view_proj, gl_state );
+		warp_renderer_->SetTemporalSource( nullptr );
+		return true;
+	}
+
+	// the plugin's own single-sampled target is read in place, resolved first in temporal mode
+	// unless the warp resolves it
+	const bool from_scene = fbo_ == source_framebuffer;
+	GLuint source_color = 0;
+	if ( from_scene && temporal_ && !warp_resolves && temporal_->IsReady() )
+		source_color = temporal_->Resolve( scene_color_texture_, scene_w_, scene_h_, gl_state );
+	else if ( from_scene && !use_multisampling_ )
+		source_color = scene_color_texture_;
+
+	// a trimmed render fills the lower left of the scene
+	const bool trimmed = from_scene && trimmed_;
+	const int rect[4] = { 0, 0, (int)( from_scene ? GetRenderWidth() : window_w_ ), (int)( from_scene ? GetRenderHeight() : window_h_ ) };
+	warp_renderer_->SetFoveatedLayout( IsFoveated() && from_scene ? &foveated_layout_ : nullptr );
+	warp_renderer_->SetSourceRegion( trimmed ? trim_region_ : nullptr );
+	warp_renderer_->SetTemporalSource( warp_resolves && from_scene ? &temporal : nullptr );
+	warp_renderer_->Render( source_framebuffer, source_color, rect, gl_state.GetFramebuffer(), window_w_, window_h_, frame_setup_.view_proj, gl_state );
+	warp_renderer_->SetSourceRegion( nullptr );
+	warp_renderer_->SetTemporalSource( nullptr );
+	return true;
+}
+
+void
+ExternalFbo::
+PresentScene( GlStateCache& gl_state )
+{
+	GLuint scene_framebuffer = fbo_;
+	gl_state.Disable( GL_SCISSOR_TEST );
+	if ( stereo_ )
+	{
+		// VWB_render warps one image, the channel stays black until the plugin's warp is ready
+		gl_state.BindFramebuffer( gl_state.GetFramebuffer() );
+		gl_state.ClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
+		glClear( GL_COLOR_BUFFER_BIT );
+		return;
+	}
+	if ( IsCubeMap() )
+	{
+		// only the plugin's warp samples a cube map, the channel stays black until it is ready
+		if ( !IsMosaicFollower() )
+			BuildCubeMap( gl_state );
+		gl_state.BindFramebuffer( gl_state.GetFramebuffer() );
+		gl_state.ClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
+		glClear( GL_COLOR_BUFFER_BIT );
+		return;
+	}
+	if ( IsMosaic() )
+	{
+		if ( !IsMosaicFollower() )
+		{
+			scene_resolved_ = temporal_ && temporal_->IsReady();
+			if ( scene_resolved_ )
+				temporal_->Resolve( scene_color_texture_, scene_w_, scene_h_, gl_state );
+		}
+		int rect[4];
+		mosaic_scene_->GetMosaicSource( mosaic_rect_, scene_framebuffer, rect );
+		if ( mosaic_scene_->use_multisampling_ && mosaic_scene_->fbo_ == scene_framebuffer )
+		{
+			// resolved at the part's size, the stretch to the window follows
+			gl_state.BindFramebuffer( scene_framebuffer );
+			glBindFramebuffer( GL_DRAW_FRAMEBUFFER, GetResolveFramebuffer( rect[2], rect[3] ) );
+			glBlitFramebuffer( rect[0], rect[1], rect[0] + rect[2], rect[1] + rect[3], 0, 0, rect[2], rect[3], GL_COLOR_BUFFER_BIT, GL_NEAREST );
+			scene_framebuffer = resolve_fbo_;
+			rect[0] = rect[1] = 0;
+		}
+		glBindFramebuffer( GL_READ_FRAMEBUFFER, scene_framebuffer );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, gl_state.GetFramebuffer() );
+		glBlitFramebuffer( rect[0], rect[1], rect[0] + rect[2], rect[1] + rect[3], 0, 0, window_w_, window_h_, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+		gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+		gl_state.BindFramebuffer( gl_state.GetFramebuffer() );
+		return;
+	}
+
+	if ( temporal_ && temporal_->IsReady() )
+	{
+		temporal_->Resolve( scene_color_texture_, scene_w_, scene_h_, gl_state );
+		scene_framebuffer = temporal_->GetFramebuffer();
+	}
+	else if ( use_multisampling_ )
+	{
+		// a multisampled source can only be blitted at its own size, so resolve first
+		gl_state.BindFramebuffer( fbo_ );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, GetResolveFramebuffer( scene_w_, scene_h_ ) );
+		glBlitFramebuffer( 0, 0, scene_w_, scene_h_, 0, 0, scene_w_, scene_h_, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		scene_framebuffer = resolve_fbo_;
+	}
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, scene_framebuffer );
+	glBindFramebuffer( GL_DRAW_FRAMEBUFFER, gl_state.GetFramebuffer() );
+	if ( IsFoveated() )
+	{
+		// the periphery stretched, the inset over it with a hard edge
+		const FoveatedLayout& layout = foveated_layout_;
+		const int x = (int)( layout.inset_channel[0] * window_w_ + 0.5f );
+		const int y = (int)( layout.inset_channel[1] * window_h_ + 0.5f );
+		const int right = (int)( ( layout.inset_channel[0] + layout.inset_channel[2] ) * window_w_ + 0.5f );
+		const int top = (int)( ( layout.inset_channel[1] + layout.inset_channel[3] ) * window_h_ + 0.5f );
+		glBlitFramebuffer( 0, 0, layout.periphery[0], layout.periphery[1], 0, 0, window_w_, window_h_, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+		glBlitFramebuffer( layout.inset[0], layout.inset[1], layout.inset[0] + layout.inset[2], layout.inset[1] + layout.inset[3],
+			x, y, right, top, GL_COLOR_BUFFER_BIT, GL_LINEAR );
+	}
+	else
+	{
+		glBlitFramebuffer( 0, 0, scene_w_, scene_h_, 0, 0, window_w_, window_h_, GL_COLOR_BUFFER_BIT, IsScaled() ? GL_LINEAR : GL_NEAREST );
+	}
+	gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+	gl_state.BindFramebuffer( gl_state.GetFramebuffer() );
+}
+
+void
+ExternalFbo::
+PrepareFrame()
+{
+	VWB_float eye[3] = { 0 };
+	VWB_float dir[3] = { 0 };
+	VWB_float view[16] = { 0 };
+	VWB_float clip[6] = { 0 };
+	frame_setup_.has_frustum = nullptr != VWB_getViewClip && VWB_ERROR_NONE == VWB_getViewClip( warper_, eye, dir, view, clip );
+	if ( frame_setup_.has_frustum )
+	{
+		frame_setup_.frustum.left_degrees = -clip[0];
+		frame_setup_.frustum.right_degrees = clip[2];
+		frame_setup_.frustum.top_degrees = clip[1];
+		frame_setup_.frustum.bottom_degrees = -clip[3];
+		frame_setup_.frustum.near_plane = clip[4];
+		frame_setup_.frustum.far_plane = clip[5];
+		frame_setup_.frustum.override_near_far = false;
+	}
+
+	const VWB_float* proj = frame_setup_.proj;
+	frame_setup_.has_view = nullptr != VWB_getViewProj && VWB_ERROR_NONE == VWB_getViewProj( warper_, eye, dir, frame_setup_.view, frame_setup_.proj );
+	if ( !frame_setup_.has_view )
+	{
+		for ( int i = 0; i < 16; ++i )
+			frame_setup_.view[i] = frame_setup_.proj[i] = frame_setup_.view_proj[i] = ( 0 == i % 5 ) ? 1.0f : 0.0f;
+	}
+	else
+	{
+		for ( int column = 0; column < 4; ++column )
+		{
+			for ( int row = 0; row < 4; ++row )
+			{
+				VWB_float sum = 0.0f;
+				for ( int k = 0; k < 4; ++k )
+					sum += proj[k * 4 + row] * frame_setup_.view[column * 4 + k];
+				frame_setup_.view_proj[column * 4 + row] = sum;
+			}
+		}
+	}
+
+	// what the warp reads with this view, widened by the guard band
+	float* region = frame_setup_.used_region;
+	frame_setup_.has_used_region = warp_settings_.trim_frustum && frame_setup_.has_frustum && coverage_
+		&& coverage_->GetRegion( frame_setup_.has_view ? frame_setup_.view_proj : nullptr, region );
+	if ( frame_setup_.has_used_region )
+	{
+		const float guard = std::max( warp_settings_.trim_guard, 0.0f );
+		const float left = std::max( region[0] - guard, 0.0f );
+		const float bottom = std::max( region[1] - guard, 0.0f );
+		const float right = std::min( region[0] + region[2] + guard, 1.0f );
+		const float top = std::min( region[1] + region[3] + guard, 1.0f );
+		frame_setup_.has_used_region = right > left && top > bottom;
+		region[0] = left;
+		region[1] = bottom;
+		region[2] = right - left;
+		region[3] = top - bottom;
+	}
+}
+
 //==============================================================================
 // Copyright  2014-2018 Diamond Visionics, LLC. ALL RIGHTS RESERVED.
 //==============================================================================
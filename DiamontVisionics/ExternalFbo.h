@@ -12,46 +12,396 @@
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 #include <Windows.h>
 #include "gig/GenesisIG_UserDefined_ImageProcessor200.h"
-#define GLEW_STATIC
+#ifndef GLEW_STATIC
+	#define GLEW_STATIC
+#endif
 #include "GL/glew.h"
 #include <gl/GL.h>
 
 #define VIOSOWARPBLEND_DYNAMIC_DEFINE
 #include "../../vioso_api/Include/VIOSOWarpBlend.h"
 
+#include "JobSystem.h"
+
+#include <vector>
+
+class ExposureControl;
+class GlProgramCache;
+class GlStateCache;
+class PostChain;
+class StereoTarget;
+class TemporalResolve;
+class WarpCoverage;
+class WarpRenderer;
+
+/*!
+ * Gaze-contingent rendering: the window's inset view renders a full resolution inset around
+ * the gaze, its other view the whole channel at a reduced resolution.
+**/
+struct FoveationSettings
+{
+	int inset_view;					/* id of the view rendering the inset, -1 disables foveation */
+	float inset_size;				/* inset width and height relative to the channel */
+	float periphery_scale;			/* resolution of the whole channel relative to the scene */
+	float border;					/* fade from the inset into the periphery, relative to the inset */
+};
+
+/*!
+ * Where the views of a foveated scene lie this frame, see ExternalFbo::UpdateFoveation.
+**/
+struct FoveatedLayout
+{
+	int periphery[2];				/* size of the whole channel, at the lower left of the scene */
+	int inset[4];					/* x, y, width and height of the inset in the scene, in pixels */
+	float inset_channel[4];			/* x, y, width and height of the inset in the channel, 0-1 from the lower left */
+	float border;
+	FrustumParameters inset_frustum;
+};
+
+/*!
+ * A channel sampled by direction from its group's cube map, see CubeMapGroup.
+**/
+struct CubeMapSource
+{
+	GLuint texture;					/* faces in GL order, built by the group's leader */
+	float channel_to_eye[9];		/* rotates view space directions of the channel into the eyepoint frame, column-major */
+	float tangents[4];				/* left, right, bottom and top of the channel */
+};
+
+/*!
+ * How a stereo window shares its output between the eyes.
+**/
+enum StereoLayout
+{
+	STEREO_SIDE_BY_SIDE = 0,		/* left eye in the left half */
+	STEREO_TOP_BOTTOM				/* left eye in the upper half */
+};
+
+/*!
+ * Stereo channels: two views of the window render the eyes into the layers of one scene
+ * target, see StereoTarget, and one warp draw packs both into the window.
+**/
+struct StereoSettings
+{
+	int left_view;					/* id of the view rendering the left eye, -1 disables stereo */
+	int right_view;
+	float eye_separation;			/* in the units of the calibration */
+	float convergence;				/* distance at which both eyes see the same point of the channel */
+	StereoLayout layout;
+};
+
+/*!
+ * Both eyes of a stereo channel, warped in one draw, see StereoTarget.
+**/
+struct StereoSource
+{
+	GLuint texture;					/* single-sampled 2D array, layer 0 the left eye */
+	float view_proj[2][16];			/* of each eye, column-major, used by 3D maps */
+	float eye_rects[2][4];			/* x, y, width and height of each eye in the target, 0-1 from the lower left */
+};
+
+/*!
+ * The history a warp blends a jittered scene into, see TemporalResolve::GetWarpSource.
+**/
+struct TemporalSource
+{
+	GLuint history;					/* RGBA8 at the target's size, read and written as an image */
+	float feedback;					/* share of the history in each pixel, 0 while it holds nothing */
+};
+
+/*!
+ * How the plugin warps a channel itself, see WarpRenderer.
+**/
+struct WarpSettings
+{
+	int tile_size;					/* tile edge in map pixels, 0 leaves the warp to VWB_render */
+	float max_error;				/* output pixels of lookup error a compact warp map encoding may add */
+	int output_width;				/* of the window when the maps load, max_error is measured in it */
+	int output_height;
+	GlProgramCache* program_cache;
+	PostChain* post_chain;			/* its last pass runs inside the warp, may be null */
+	float render_scale;				/* scene target size relative to the window, below 1 upscaled in the warp */
+	float min_render_scale;			/* below render_scale the scene scale floats, see ExternalFbo::SetSceneScale */
+	float sharpness;				/* 0-1, sharpening after the upscale */
+	float temporal_feedback;		/* above 0 a single-sampled scene is resolved over frames, see TemporalResolve */
+	FoveationSettings foveation;
+	ExposureControl* exposure;		/* scales and tone maps the scene in the warp, may be null or disabled */
+	bool cube_map;					/* the warp programs can sample a CubeMapSource */
+	bool trim_frustum;				/* render only what the warp reads, see WarpCoverage */
+	float trim_guard;				/* kept around it on every side, relative to the channel */
+	int mip_levels;					/* most levels below the source the warp reads where it minifies, see SourceMips */
+	StereoSettings stereo;			/* the window renders both eyes, its other features are off then */
+};
 
 class ExternalFbo
 {
 public:
+	/*!
+	 * What a frame needs from the warper, queried ahead of the window by PrepareFrame.
+	**/
+	struct FrameSetup
+	{
+		bool has_frustum;			/* false if the warper could not report its clip planes */
+		bool has_view;				/* false if the warper could not report view and projection */
+		FrustumParameters frustum;
+		VWB_float view[16];			/* column-major */
+		VWB_float proj[16];			/* column-major */
+		VWB_float view_proj[16];	/* projection * view, column-major */
+		bool has_used_region;		/* the warp's maps tell what it reads, see WarpCoverage */
+		float used_region[4];		/* x, y, width and height in the channel, 0-1 from the lower left, guard included */
+	};
+
 	ExternalFbo();
 
-	void Load( bool multisample, unsigned int width, unsigned int height, VWB_Warper* pWarper );
+	/*!
+	 * Takes ownership of pWarper, it is destroyed if the scene target cannot be made.
+	 *
+	 * @return
+	 *  false if the scene target is incomplete, the window then has no warper and no profiles
+	**/
+	bool Load( bool multisample, unsigned int width, unsigned int height, VWB_Warper* pWarper, const WarpSettings& warp_settings );
 	void Unload();
 
-	void BindFbo();
-	void UnBindFbo();
+	void BindFbo( GlStateCache& gl_state );
+	void UnBindFbo( GlStateCache& gl_state );
 
 	void RenderWarp() const;
 
+	/*!
+	 * Runs the post effects and warps source_framebuffer into the framebuffer the IG had bound,
+	 * with the plugin's tiled renderer. source_framebuffer is either the scene target, see
+	 * GetFramebuffer(), or window sized.
+	 *
+	 * @return
+	 *  false if the tiled renderer is not available for this warper, or not ready yet: use
+	 *  PostChain::Apply and VWB_render then.
+	**/
+	bool RenderTiledWarp( GLuint source_framebuffer, GlStateCache& gl_state );
+
+	/*!
+	 * Copies the scene target to the framebuffer the IG had bound, for VWB_render: resolved
+	 * over time in temporal mode, stretched if scaled. Bilinear only: the plugin's own warp
+	 * upscales far better.
+	**/
+	void PresentScene( GlStateCache& gl_state );
+
+	/*!
+	 * Queries the warper for the coming frame. CPU only, runs on a job thread.
+	**/
+	void PrepareFrame();
+
+	/*! Valid once the prepare job is done, see GetPrepareJob. **/
+	const FrameSetup& GetFrameSetup() const { return frame_setup_; }
+	JobCounter& GetPrepareJob() { return prepare_job_; }
+
 	void UpdateWindowSize( unsigned int width, unsigned int height );
 
-	GLuint GetSceneColorTexture() const { return scene_color_texture_; }
-	GLuint GetSceneDepthTexture() const { return scene_depth_texture_; }
+	/*!
+	 * Places the foveated inset around the gaze for the coming frame. Needs the frame setup.
+	 *
+	 * @param[in] channel : the channel's unjittered frustum
+	 * @param[in] gaze_direction : in the eyepoint frame, x right, y up, -z forward. Null centers the inset.
+	**/
+	void UpdateFoveation( const FrustumParameters& channel, const float* gaze_direction );
+
+	/*!
+	 * Decides whether the IG renders the whole channel or only the used region of the frame
+	 * setup. The region has to be warped by the plugin, which remaps it. Needs the frame setup
+	 * and the IG context.
+	**/
+	void UpdateTrim();
+
+	/*! The IG renders the trimmed frustum, into the lower left of the scene. **/
+	bool IsTrimmed() const { return trimmed_; }
+	const FrustumParameters& GetTrimmedFrustum() const { return trimmed_frustum_; }
+	const float* GetTrimRegion() const { return trim_region_; }
+
+	bool IsFoveated() const { return warp_settings_.foveation.inset_view >= 0; }
+	const FoveatedLayout& GetFoveatedLayout() const { return foveated_layout_; }
+
+	/*!
+	 * Renders the next frames at another fraction of the window size, clamped to the render scale
+	 * and its minimum. The targets are allocated at the render scale, only the viewport changes.
+	**/
+	void SetSceneScale( float scale );
+
+	/*!
+	 * Makes the scene target hold a whole mosaic group rather than this window, see MosaicGroup,
+	 * or the faces of a cube map group side by side, see CubeMapGroup.
+	 * The size is at render scale 1, 0 returns to the window size.
+	**/
+	void SetMosaicScene( unsigned int width, unsigned int height );
+
+	/*!
+	 * Warps a part of another window's scene instead of this window's own, see MosaicGroup.
+	 *
+	 * @param[in] scene : the group's leader, may be this window. Null warps the own scene again.
+	 * @param[in] rect : x, y, width and height of the part, 0-1 from the lower left of the scene
+	**/
+	void SetMosaicSource( ExternalFbo* scene, const float rect[4] );
+
+	/*!
+	 * Warps from the cube map of another window's scene instead of this window's own, see
+	 * CubeMapGroup. Null warps the own scene again.
+	**/
+	void SetCubeMapSource( ExternalFbo* scene );
+
+	/*! The window warps from a mosaic or cube map group's scene. **/
+	bool IsMosaic() const { return nullptr != mosaic_scene_; }
+	bool IsCubeMap() const { return IsMosaic() && cube_map_; }
+
+	/*! The plugin's own warp is loaded and ready, the only one that can sample a cube map. **/
+	bool CanWarpCubeMap();
+	/*! A member other than the leader, its own render is not used. **/
+	bool IsMosaicFollower() const { return IsMosaic() && this != mosaic_scene_; }
+
+	/*! What the IG renders into, a stereo window's are the layers of the eye it renders now. **/
+	GLuint GetSceneColorTexture() const;
+	GLuint GetSceneDepthTexture() const;
+	GLuint GetFramebuffer() const { return fbo_; }
 
 	unsigned int GetWidth() const { return window_w_; }
 	unsigned int GetHeight() const { return window_h_; }
+
+	/*! The scene target is smaller than the window, the IG renders into it with a scaled viewport. **/
+	bool IsScaled() const { return scene_w_ != window_w_ || scene_h_ != window_h_; }
+	/*! The scene is single-sampled with a jittered projection and resolved over frames. **/
+	bool IsTemporal() const { return nullptr != temporal_; }
+
+	/*! The IG renders both eyes into the layers of the scene target, see StereoTarget. **/
+	bool IsStereo() const { return nullptr != stereo_; }
+
+	/*! 0 for the left eye's view, 1 for the right one's, -1 for any other view or a mono window. **/
+	int GetStereoEye( int view_id ) const;
+
+	/*!
+	 * Makes the IG's bound framebuffer render into the layers of the view's eye. Call before
+	 * each view of a stereo window.
+	**/
+	void BeginStereoView( int view_id );
+
+	/*! The IG renders into the plugin's scene target rather than leaving the scene in its own framebuffer. **/
+	bool OwnsScene() const { return IsScaled() || IsTemporal() || IsFoveated() || IsMosaic() || IsTrimmed() || IsStereo(); }
+
+	unsigned int GetSceneWidth() const { return scene_w_; }
+	unsigned int GetSceneHeight() const { return scene_h_; }
+	/*! The part of the scene target the IG renders into, smaller than the scene if trimmed. **/
+	unsigned int GetRenderWidth() const;
+	unsigned int GetRenderHeight() const;
 	VWB_Warper* GetWarper() const { return warper_; }
 
+	/*! A loaded calibration with its warp resources, see CalibrationProfiles. **/
+	struct Profile
+	{
+		VWB_Warper* warper;
+		WarpRenderer* warp_renderer;	/* null if VWB_render warps it */
+		WarpCoverage* coverage;			/* null unless trimming */
+	};
+
+	/*!
+	 * Builds the warp resources of a warper as a window with these settings uses them. Needs a
+	 * context sharing objects with the IG's, nothing is made that contexts do not share.
+	**/
+	static Profile LoadProfile( VWB_Warper* warper, const WarpSettings& settings );
+
+	/*! Unloads and deletes the resources of a profile, the warper is left to the caller. **/
+	static void ReleaseResources( Profile& profile );
+
+	const WarpSettings& GetWarpSettings() const { return warp_settings_; }
+
+	/*!
+	 * Replaces profile 0 with one built by LoadProfile, only the pointers are exchanged. The
+	 * caller takes ownership of the previous warper and its resources. Its prepare job must be done.
+	**/
+	Profile SwapProfile( const Profile& profile );
+
+	/*! The loaded calibrations, in the order of CalibrationProfiles. **/
+	const std::vector<Profile>& GetProfiles() const { return profiles_; }
+
+	/*!
+	 * Loads another calibration of the window with its warp resources, see CalibrationProfiles.
+	 * The window owns the warper. Needs the IG context.
+	 *
+	 * @param[in] warper : null keeps the profile's place, selecting it keeps the active one then
+	**/
+	void AddProfile( VWB_Warper* warper );
+
+	/*!
+	 * Makes a loaded calibration the active one, from the next PrepareFrame on. Nothing is
+	 * allocated or read from disk. Its prepare job must be done.
+	 *
+	 * @return
+	 *  false if the profile was not loaded
+	**/
+	bool SelectProfile( size_t profile );
+
 private:
+	void UpdateSceneSize();
+	void ResizeTargets();
+
+	/*!
+	 * Where a member finds its part of this leader's scene, resolved if the leader resolved it.
+	 *
+	 * @param[out] rect : x, y, width and height in pixels of framebuffer
+	**/
+	void GetMosaicSource( const float part[4], GLuint& framebuffer, int rect[4] );
+
+	/*! A single-sampled target of at least the given size, grown as needed. **/
+	GLuint GetResolveFramebuffer( unsigned int width, unsigned int height );
+
+	/*!
+	 * Copies the faces of this leader's scene into its cube map, once per frame before any
+	 * member warps.
+	 *
+	 * @return
+	 *  the single-sampled scene the faces were copied from
+	**/
+	GLuint BuildCubeMap( GlStateCache& gl_state );
+	void ReleaseCubeMap();
+
 	bool use_multisampling_;
 	GLuint scene_color_texture_, scene_depth_texture_;
 	GLuint scene_rb_, scene_depth_rb_;
 	GLuint fbo_, ms_fbo_;
 	GLint existing_fbo_;
 	VWB_Warper* warper_;
+	WarpRenderer* warp_renderer_;
+	WarpCoverage* coverage_;		/* what the warp reads, null unless trimming */
+
+	/*! The loaded calibrations, the active one is also in warper_, warp_renderer_ and coverage_. **/
+	std::vector<Profile> profiles_;
+	size_t active_profile_;
+	bool trimmed_;
+	FrustumParameters trimmed_frustum_;
+	float trim_region_[4];			/* the used region the trimmed frustum covers */
+	TemporalResolve* temporal_;		/* history of a temporally anti-aliased scene, null with MSAA */
+	bool scene_resolved_;			/* temporal_ holds this frame's resolved scene, the warp resolves in its own pass otherwise */
+	StereoTarget* stereo_;			/* layered scene of a stereo window, which has no 2D scene target then */
+	int stereo_eye_;				/* rendered by the IG now */
+	WarpSettings warp_settings_;
+	FrameSetup frame_setup_;
+	FoveatedLayout foveated_layout_;
+	JobCounter prepare_job_;
 
 	unsigned int window_w_;
 	unsigned int window_h_;
+	unsigned int scene_w_;			/* window size times the scene scale, the used part of the targets */
+	unsigned int scene_h_;
+	unsigned int capacity_w_;		/* window size times the render scale, the allocated size of the targets */
+	unsigned int capacity_h_;
+	float scene_scale_;
+	unsigned int mosaic_w_;			/* size of a mosaic group's scene at render scale 1, 0 without */
+	unsigned int mosaic_h_;
+	ExternalFbo* mosaic_scene_;		/* the leader whose scene this window warps, null for the own scene */
+	float mosaic_rect_[4];			/* this window's part of it, 0-1 */
+	bool cube_map_;					/* mosaic_scene_ holds cube faces, sampled through its cube map */
+	GLuint cube_texture_;			/* of a cube map leader, faces as large as the scene's cells */
+	GLuint cube_framebuffers_[6];
+	unsigned int cube_face_;
+	GLuint resolve_texture_;		/* single-sampled copy of a multisampled scene, for PresentScene */
+	GLuint resolve_fbo_;
+	unsigned int resolve_w_;
+	unsigned int resolve_h_;
 
 	unsigned int target_;
 	unsigned int internal_format_;
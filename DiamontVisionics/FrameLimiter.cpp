@@ -0,0 +1,110 @@
+//==============================================================================
+// File:FrameLimiter.cpp
+//==============================================================================
+
+#include "FrameLimiter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+	const GLuint64 kWaitSliceNs = 100000000;	// 100 ms, keeps a lost context from hanging the IG forever
+	const int kMaxWaitSlices = 20;
+}
+
+FrameLimiter::FrameLimiter()
+	: max_frames_in_flight_( 0 )
+	, report_interval_( 0 )
+	, frame_fence_( 0 )
+	, last_wait_ms_( 0.0 )
+	, total_wait_ms_( 0.0 )
+	, max_wait_ms_( 0.0 )
+	, waited_frames_( 0 )
+	, frames_( 0 )
+{
+}
+
+FrameLimiter::~FrameLimiter()
+{
+}
+
+void FrameLimiter::Configure( int max_frames_in_flight, int report_interval )
+{
+	max_frames_in_flight_ = max_frames_in_flight > 0 ? std::min( std::max( max_frames_in_flight, 1 ), 3 ) : 0;
+	report_interval_ = std::max( report_interval, 0 );
+}
+
+void FrameLimiter::BeginFrame()
+{
+	if ( !IsEnabled() )
+		return;
+
+	if ( frame_fence_ )
+	{
+		in_flight_.push_back( frame_fence_ );
+		frame_fence_ = 0;
+	}
+
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool waited = false;
+	while ( (int)in_flight_.size() >= max_frames_in_flight_ )
+	{
+		GLsync oldest = in_flight_.front();
+		in_flight_.pop_front();
+
+		// flush on the first attempt only, the fence has to reach the GPU once
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		for ( int slice = 0; slice < kMaxWaitSlices; ++slice )
+		{
+			const GLenum result = glClientWaitSync( oldest, flags, kWaitSliceNs );
+			if ( GL_TIMEOUT_EXPIRED != result )
+			{
+				waited = waited || GL_CONDITION_SATISFIED == result;
+				if ( GL_WAIT_FAILED == result )
+					std::cout << "Warning: frame limiter fence wait failed." << std::endl;
+				break;
+			}
+			flags = 0;
+		}
+		glDeleteSync( oldest );
+	}
+	last_wait_ms_ = std::chrono::duration<double, std::milli>( std::chrono::steady_clock::now() - start ).count();
+
+	total_wait_ms_ += last_wait_ms_;
+	max_wait_ms_ = std::max( max_wait_ms_, last_wait_ms_ );
+	if ( waited )
+		++waited_frames_;
+	if ( report_interval_ > 0 && ++frames_ >= report_interval_ )
+	{
+		std::cout << "VIOSO-Plugin: Info: " << max_frames_in_flight_ << " frame(s) in flight, waited in "
+			<< waited_frames_ << " of " << frames_ << " frames, avg " << total_wait_ms_ / frames_
+			<< " ms, max " << max_wait_ms_ << " ms" << std::endl;
+		total_wait_ms_ = 0.0;
+		max_wait_ms_ = 0.0;
+		waited_frames_ = 0;
+		frames_ = 0;
+	}
+}
+
+void FrameLimiter::Fence()
+{
+	if ( !IsEnabled() )
+		return;
+
+	if ( frame_fence_ )
+		glDeleteSync( frame_fence_ );
+	frame_fence_ = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+}
+
+void FrameLimiter::Shutdown()
+{
+	if ( frame_fence_ )
+		glDeleteSync( frame_fence_ );
+	frame_fence_ = 0;
+
+	for ( std::deque<GLsync>::iterator it = in_flight_.begin(); it != in_flight_.end(); ++it )
+		glDeleteSync( *it );
+	in_flight_.clear();
+}
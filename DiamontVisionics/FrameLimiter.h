@@ -0,0 +1,66 @@
+//==============================================================================
+// File:FrameLimiter.h
+//==============================================================================
+//
+// Description: Bounds the number of frames the driver may queue ahead of the GPU.
+//				A fence is inserted after each window's warp; at the start of the
+//				next frame the CPU waits until no more than the configured number
+//				of frames are still in flight. Trades some throughput for a short,
+//				steady latency between the host update and the projected image.
+//
+//==============================================================================
+
+#ifndef DVC_FRAME_LIMITER_H
+#define DVC_FRAME_LIMITER_H
+
+#include "GL/glew.h"
+
+#include <deque>
+
+class FrameLimiter
+{
+public:
+	FrameLimiter();
+	~FrameLimiter();
+
+	/*!
+	 * @param[in] max_frames_in_flight : 0 disables the limiter, otherwise clamped to 1..3
+	 * @param[in] report_interval : frames between wait time reports, 0 for none
+	**/
+	void Configure( int max_frames_in_flight, int report_interval );
+
+	bool IsEnabled() const { return max_frames_in_flight_ > 0; }
+	int GetMaxFramesInFlight() const { return max_frames_in_flight_; }	/* after clamping */
+
+	/*!
+	 * Call once at the start of a frame, before anything is rendered. Blocks while too many
+	 * frames are queued.
+	**/
+	void BeginFrame();
+
+	/*!
+	 * Call after each warp. The last fence of a frame stands for the whole frame.
+	**/
+	void Fence();
+
+	/*!
+	 * Releases all fences. Needs the GL context.
+	**/
+	void Shutdown();
+
+	double GetLastWaitMs() const { return last_wait_ms_; }
+
+private:
+	int max_frames_in_flight_;
+	int report_interval_;
+	GLsync frame_fence_;				/* fence of the frame being rendered */
+	std::deque<GLsync> in_flight_;		/* fences of submitted frames, oldest first */
+
+	double last_wait_ms_;
+	double total_wait_ms_;
+	double max_wait_ms_;
+	int waited_frames_;
+	int frames_;
+};
+
+#endif // DVC_FRAME_LIMITER_H
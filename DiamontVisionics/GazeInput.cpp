@@ -0,0 +1,128 @@
+//==============================================================================
+// File:GazeInput.cpp
+//==============================================================================
+
+#include "GazeInput.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	const unsigned int kOpenRetryFrames = 120;	// a missing tracker is looked for about every two seconds
+	const int kReadAttempts = 4;				// the writer holds the block for a few instructions only
+}
+
+GazeInput::GazeInput()
+	: mapping_( NULL )
+	, block_( nullptr )
+	, last_sequence_( 0 )
+	, open_retry_( 0 )
+	, valid_( false )
+{
+	direction_[0] = direction_[1] = 0.0f;
+	direction_[2] = -1.0f;
+}
+
+GazeInput::~GazeInput()
+{
+	Close();
+}
+
+void GazeInput::Configure( const std::string& shared_memory_name )
+{
+	Close();
+	shared_memory_name_ = shared_memory_name;
+}
+
+bool GazeInput::ReadMessage( const void* param, unsigned int size )
+{
+	if ( nullptr == param || size < sizeof( GazeMsg ) )
+		return false;
+
+	GazeMsg message;
+	std::memcpy( &message, param, sizeof( message ) );
+	if ( kGazeMsg != message.msg )
+		return false;
+
+	SetDirection( message.direction );
+	return true;
+}
+
+void GazeInput::Poll()
+{
+	if ( shared_memory_name_.empty() )
+		return;
+
+	if ( nullptr == block_ )
+	{
+		if ( open_retry_ > 0 )
+		{
+			--open_retry_;
+			return;
+		}
+		open_retry_ = kOpenRetryFrames;
+		mapping_ = OpenFileMappingA( FILE_MAP_READ, FALSE, shared_memory_name_.c_str() );
+		if ( NULL == mapping_ )
+			return;
+		block_ = static_cast<const GazeSharedBlock*>( MapViewOfFile( mapping_, FILE_MAP_READ, 0, 0, sizeof( GazeSharedBlock ) ) );
+		if ( nullptr == block_ )
+		{
+			CloseHandle( mapping_ );
+			mapping_ = NULL;
+			return;
+		}
+		std::cout << "Info: reading the gaze from " << shared_memory_name_ << "." << std::endl;
+	}
+
+	// retried while the tracker writes, a frame without a consistent sample keeps the last one
+	for ( int attempt = 0; attempt < kReadAttempts; ++attempt )
+	{
+		const LONG before = block_->sequence;
+		if ( before & 1 )
+			continue;
+		if ( before == last_sequence_ )
+			return;
+		MemoryBarrier();
+		float direction[3] = { block_->direction[0], block_->direction[1], block_->direction[2] };
+		MemoryBarrier();
+		if ( before == block_->sequence )
+		{
+			last_sequence_ = before;
+			SetDirection( direction );
+			return;
+		}
+	}
+}
+
+bool GazeInput::GetDirection( float direction[3] ) const
+{
+	if ( !valid_ )
+		return false;
+	for ( int i = 0; i < 3; ++i )
+		direction[i] = direction_[i];
+	return true;
+}
+
+void GazeInput::SetDirection( const float direction[3] )
+{
+	const float length = std::sqrt( direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2] );
+	if ( !( length > 0.0f ) )
+		return;
+	for ( int i = 0; i < 3; ++i )
+		direction_[i] = direction[i] / length;
+	valid_ = true;
+}
+
+void GazeInput::Close()
+{
+	if ( block_ )
+		UnmapViewOfFile( block_ );
+	if ( mapping_ )
+		CloseHandle( mapping_ );
+	block_ = nullptr;
+	mapping_ = NULL;
+	last_sequence_ = 0;
+	open_retry_ = 0;
+}
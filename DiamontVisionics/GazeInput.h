@@ -0,0 +1,92 @@
+//==============================================================================
+// File:GazeInput.h
+//==============================================================================
+//
+// Description: The pilot's gaze direction from an eye tracker, for foveated
+//				rendering. A host passes it with update() as a GazeMsg, or the
+//				tracker writes it into a named shared memory block that is polled
+//				once per frame. The last sample is kept until a new one arrives.
+//
+//==============================================================================
+
+#ifndef DVC_GAZE_INPUT_H
+#define DVC_GAZE_INPUT_H
+
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#include <Windows.h>
+
+#include <string>
+
+/*! Tells a GazeMsg from the IgInterface messages, which share the update() param. **/
+const int kGazeMsg = 0x657A6147;	/* "Gaze" */
+
+/*!
+ * update() param carrying a gaze sample.
+**/
+struct GazeMsg
+{
+	int msg;						/* kGazeMsg */
+	float direction[3];				/* in the eyepoint frame: x right, y up, -z forward */
+};
+
+/*!
+ * Layout of the shared memory block. The writer increments sequence before and after each
+ * update, so it is odd while the direction changes.
+**/
+struct GazeSharedBlock
+{
+	volatile LONG sequence;
+	float direction[3];
+};
+
+class GazeInput
+{
+public:
+	GazeInput();
+	~GazeInput();
+
+	/*!
+	 * @param[in] shared_memory_name : block to poll, e.g. "Local\\GazeData". Empty takes messages only.
+	**/
+	void Configure( const std::string& shared_memory_name );
+
+	/*!
+	 * Takes the sample of a GazeMsg.
+	 *
+	 * @return
+	 *  false if param is not a GazeMsg
+	**/
+	bool ReadMessage( const void* param, unsigned int size );
+
+	/*!
+	 * Reads the shared memory block, opening it once the tracker has created it.
+	**/
+	void Poll();
+
+	/*!
+	 * @param[out] direction : the last sample, normalized
+	 *
+	 * @return
+	 *  false until the first sample arrives
+	**/
+	bool GetDirection( float direction[3] ) const;
+
+	void Close();
+
+private:
+	GazeInput( const GazeInput& );
+	GazeInput& operator=( const GazeInput& );
+
+	void SetDirection( const float direction[3] );
+
+	std::string shared_memory_name_;
+	HANDLE mapping_;
+	const GazeSharedBlock* block_;
+	LONG last_sequence_;
+	unsigned int open_retry_;		/* frames until the block is looked for again */
+	float direction_[3];
+	bool valid_;
+};
+
+#endif // DVC_GAZE_INPUT_H
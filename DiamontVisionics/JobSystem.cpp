@@ -0,0 +1,154 @@
+//==============================================================================
+// File:JobSystem.cpp
+//==============================================================================
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem()
+	: next_queue_( 0 )
+	, queued_( 0 )
+	, stopping_( false )
+{
+}
+
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+unsigned int JobSystem::DefaultThreadCount()
+{
+	const unsigned int cores = std::thread::hardware_concurrency();
+	return std::min( std::max( cores, 2u ) - 1, 8u );
+}
+
+void JobSystem::Start( unsigned int thread_count )
+{
+	Stop();
+	stopping_ = false;
+	for ( unsigned int i = 0; i < thread_count; ++i )
+		queues_.push_back( std::unique_ptr<Queue>( new Queue ) );
+	for ( unsigned int i = 0; i < thread_count; ++i )
+		threads_.push_back( std::thread( &JobSystem::Work, this, (size_t)i ) );
+}
+
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock( sleep_mutex_ );
+		stopping_ = true;
+	}
+	work_available_.notify_all();
+	for ( size_t i = 0; i < threads_.size(); ++i )
+		threads_[i].join();
+
+	threads_.clear();
+	queues_.clear();
+	queued_ = 0;
+}
+
+void JobSystem::Run( const Job& job, JobCounter& counter )
+{
+	counter.pending_.fetch_add( 1, std::memory_order_relaxed );
+	Entry entry = { job, &counter };
+	if ( queues_.empty() )
+	{
+		Execute( entry );
+		return;
+	}
+
+	Queue& queue = *queues_[next_queue_++ % queues_.size()];
+	{
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		queue.entries.push_back( entry );
+	}
+	queued_.fetch_add( 1 );
+	{
+		// a worker between its check and its wait would miss the notification
+		std::lock_guard<std::mutex> lock( sleep_mutex_ );
+	}
+	work_available_.notify_one();
+}
+
+void JobSystem::Wait( JobCounter& counter )
+{
+	Entry entry;
+	while ( !counter.IsDone() )
+	{
+		// the caller owns no queue, it only steals
+		if ( Steal( queues_.size(), entry ) )
+		{
+			Execute( entry );
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( sleep_mutex_ );
+		work_done_.wait( lock, [&]() { return counter.IsDone() || queued_.load() > 0; } );
+	}
+}
+
+bool JobSystem::Pop( size_t queue, Entry& entry )
+{
+	Queue& own = *queues_[queue];
+	std::lock_guard<std::mutex> lock( own.mutex );
+	if ( own.entries.empty() )
+		return false;
+
+	entry = own.entries.back();
+	own.entries.pop_back();
+	queued_.fetch_sub( 1 );
+	return true;
+}
+
+bool JobSystem::Steal( size_t thief, Entry& entry )
+{
+	for ( size_t i = 1; i <= queues_.size(); ++i )
+	{
+		const size_t victim = ( thief + i ) % queues_.size();
+		if ( victim == thief )
+			continue;
+
+		Queue& queue = *queues_[victim];
+		std::lock_guard<std::mutex> lock( queue.mutex );
+		if ( queue.entries.empty() )
+			continue;
+
+		entry = queue.entries.front();
+		queue.entries.pop_front();
+		queued_.fetch_sub( 1 );
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::Execute( Entry& entry )
+{
+	entry.job();
+	if ( 1 == entry.counter->pending_.fetch_sub( 1, std::memory_order_acq_rel ) )
+	{
+		// lock so a waiter cannot miss the notification between its check and its wait
+		std::lock_guard<std::mutex> lock( sleep_mutex_ );
+		work_done_.notify_all();
+	}
+}
+
+void JobSystem::Work( size_t queue )
+{
+	Entry entry;
+	for ( ;; )
+	{
+		if ( Pop( queue, entry ) || Steal( queue, entry ) )
+		{
+			Execute( entry );
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock( sleep_mutex_ );
+		work_available_.wait( lock, [&]() { return stopping_.load() || queued_.load() > 0; } );
+		// the queued jobs still run, their counters would never finish otherwise
+		if ( stopping_ && 0 == queued_.load() )
+			return;
+	}
+}
@@ -0,0 +1,112 @@
+//==============================================================================
+// File:JobSystem.h
+//==============================================================================
+//
+// Description: A small work-stealing job system for the CPU work a plugin does
+//				per window. Each worker owns a queue it takes from at the back,
+//				idle workers and a waiting caller take from the front of the
+//				others. A caller waiting on a counter runs jobs itself instead
+//				of blocking, so waiting never costs more than doing the work
+//				inline. Jobs must not touch GL.
+//
+//==============================================================================
+
+#ifndef DVC_JOB_SYSTEM_H
+#define DVC_JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+ * Counts the unfinished jobs of a group. Reusable once done.
+**/
+class JobCounter
+{
+public:
+	JobCounter() : pending_( 0 ) {}
+
+	bool IsDone() const { return 0 == pending_.load( std::memory_order_acquire ); }
+
+private:
+	friend class JobSystem;
+
+	JobCounter( const JobCounter& );
+	JobCounter& operator=( const JobCounter& );
+
+	std::atomic<int> pending_;
+};
+
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+
+	JobSystem();
+	~JobSystem();
+
+	/*!
+	 * Starts the workers.
+	 *
+	 * @param[in] thread_count : 0 runs every job inline in Run()
+	**/
+	void Start( unsigned int thread_count );
+
+	/*!
+	 * Runs the queued jobs to the end and stops the workers.
+	**/
+	void Stop();
+
+	/*!
+	 * Queues a job and adds it to the counter.
+	**/
+	void Run( const Job& job, JobCounter& counter );
+
+	/*!
+	 * Returns once every job of the counter has finished, running queued jobs meanwhile.
+	**/
+	void Wait( JobCounter& counter );
+
+	unsigned int GetThreadCount() const { return (unsigned int)threads_.size(); }
+
+	/*! A worker count that leaves the render thread a core. **/
+	static unsigned int DefaultThreadCount();
+
+private:
+	JobSystem( const JobSystem& );
+	JobSystem& operator=( const JobSystem& );
+
+	struct Entry
+	{
+		Job job;
+		JobCounter* counter;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Entry> entries;
+	};
+
+	bool Pop( size_t queue, Entry& entry );
+	bool Steal( size_t thief, Entry& entry );
+	void Execute( Entry& entry );
+	void Work( size_t queue );
+
+	std::vector<std::unique_ptr<Queue> > queues_;	/* one per worker */
+	std::vector<std::thread> threads_;
+	size_t next_queue_;								/* round robin for Run */
+
+	std::mutex sleep_mutex_;
+	std::condition_variable work_available_;
+	std::condition_variable work_done_;
+	std::atomic<int> queued_;
+	std::atomic<bool> stopping_;
+};
+
+#endif // DVC_JOB_SYSTEM_H
@@ -0,0 +1,220 @@
+//==============================================================================
+// File:LuminanceHistogram.cpp
+//==============================================================================
+
+#include "LuminanceHistogram.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	// every 4th pixel in both directions, binned in shared memory before the few global atomics
+	const char* kBuildShader = R"(
+#version 430
+layout( local_size_x = 16, local_size_y = 16 ) in;
+layout( std430, binding = 0 ) buffer Histogram { uint bins[64]; };
+uniform sampler2D u_source;
+uniform ivec4 u_rect;		// x, y, width and height of the analyzed part, in pixels
+shared uint local_bins[64];
+
+void main()
+{
+	uint index = gl_LocalInvocationIndex;
+	if ( index < 64u )
+		local_bins[index] = 0u;
+	barrier();
+
+	ivec2 pixel = ivec2( gl_GlobalInvocationID.xy ) * 4 + 2;
+	if ( all( lessThan( pixel, u_rect.zw ) ) )
+	{
+		// bin 0 holds black, 1-63 log2 luminance from -10 to 0
+		float luminance = dot( texelFetch( u_source, u_rect.xy + pixel, 0 ).rgb, vec3( 0.2126, 0.7152, 0.0722 ) );
+		uint bin = luminance < 1.0 / 1024.0 ? 0u : 1u + uint( clamp( log2( luminance ) / 10.0 + 1.0, 0.0, 1.0 ) * 62.0 + 0.5 );
+		atomicAdd( local_bins[bin], 1u );
+	}
+	barrier();
+
+	if ( index < 64u && local_bins[index] > 0u )
+		atomicAdd( bins[index], local_bins[index] );
+}
+)";
+
+	// averages between the 50th and 95th percentile, so neither a dark sky nor a few lights decide
+	const char* kReduceShader = R"(
+#version 430
+layout( local_size_x = 64 ) in;
+layout( std430, binding = 0 ) buffer Histogram { uint bins[64]; };
+layout( std430, binding = 1 ) buffer Result { float average_log; uint samples; };
+shared uint counts[64];
+
+void main()
+{
+	uint index = gl_LocalInvocationIndex;
+	counts[index] = bins[index];
+	bins[index] = 0u;
+	barrier();
+	if ( 0u != index )
+		return;
+
+	uint total = 0u;
+	for ( int i = 0; i < 64; ++i )
+		total += counts[i];
+	float lo = 0.5 * float( total );
+	float hi = 0.95 * float( total );
+	float below = 0.0;
+	float sum = 0.0;
+	float weight = 0.0;
+	for ( int i = 0; i < 64; ++i )
+	{
+		float count = float( counts[i] );
+		float taken = clamp( below + count, lo, hi ) - clamp( below, lo, hi );
+		sum += taken * ( 0 == i ? -10.0 : float( i - 1 ) / 62.0 * 10.0 - 10.0 );
+		weight += taken;
+		below += count;
+	}
+	average_log = weight > 0.0 ? sum / weight : -10.0;
+	samples = total;
+}
+)";
+
+	// like the warp's source, 0 is left to the IG
+	const GLint kSourceUnit = 1;
+	const int kStride = 4;
+	const int kGroupSize = 16;
+
+	struct Result
+	{
+		GLfloat average_log;
+		GLuint samples;
+	};
+
+	bool IsSignaled( GLsync fence )
+	{
+		const GLenum result = glClientWaitSync( fence, 0, 0 );
+		return GL_ALREADY_SIGNALED == result || GL_CONDITION_SATISFIED == result;
+	}
+}
+
+LuminanceHistogram::LuminanceHistogram()
+	: rect_location_( -1 )
+	, programs_ready_( false )
+	, histogram_buffer_( 0 )
+	, result_buffer_( 0 )
+	, slot_stride_( 0 )
+	, next_slot_( 0 )
+	, oldest_slot_( 0 )
+{
+	for ( int i = 0; i < kSlots; ++i )
+		fences_[i] = 0;
+}
+
+bool LuminanceHistogram::Load( GlProgramCache& program_cache )
+{
+	Unload();
+	if ( !GLEW_VERSION_4_3 && !( GLEW_ARB_compute_shader && GLEW_ARB_shader_storage_buffer_object ) )
+	{
+		std::cout << "Warning: the context has no compute shaders, exposure adaptation is off." << std::endl;
+		return false;
+	}
+
+	build_.RequestCompute( program_cache, "VIOSO-Plugin luminance histogram", kBuildShader );
+	reduce_.RequestCompute( program_cache, "VIOSO-Plugin luminance reduce", kReduceShader );
+	if ( !( build_.IsValid() || build_.IsPending() ) || !( reduce_.IsValid() || reduce_.IsPending() ) )
+	{
+		Unload();
+		return false;
+	}
+
+	GLint alignment = 0;
+	glGetIntegerv( GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment );
+	slot_stride_ = std::max<GLintptr>( alignment, sizeof( Result ) );
+
+	const GLuint zero[64] = { 0 };
+	glGenBuffers( 1, &histogram_buffer_ );
+	glGenBuffers( 1, &result_buffer_ );
+	glNamedBufferDataEXT( histogram_buffer_, sizeof( zero ), zero, GL_DYNAMIC_COPY );
+	glNamedBufferDataEXT( result_buffer_, kSlots * slot_stride_, nullptr, GL_STREAM_READ );
+	return true;
+}
+
+void LuminanceHistogram::Unload()
+{
+	build_.Release();
+	reduce_.Release();
+	programs_ready_ = false;
+	for ( int i = 0; i < kSlots; ++i )
+	{
+		if ( fences_[i] )
+			glDeleteSync( fences_[i] );
+		fences_[i] = 0;
+	}
+	if ( histogram_buffer_ )	glDeleteBuffers( 1, &histogram_buffer_ );
+	if ( result_buffer_ )		glDeleteBuffers( 1, &result_buffer_    );
+
+	histogram_buffer_ = result_buffer_ = 0;
+	next_slot_ = oldest_slot_ = 0;
+}
+
+bool LuminanceHistogram::IsReady()
+{
+	if ( programs_ready_ )
+		return true;
+	if ( 0 == histogram_buffer_ )
+		return false;
+
+	build_.TakeReady();
+	reduce_.TakeReady();
+	if ( !build_.IsValid() || !reduce_.IsValid() )
+		return false;
+
+	glProgramUniform1iEXT( build_.GetId(), build_.GetUniform( "u_source" ), kSourceUnit );
+	rect_location_ = build_.GetUniform( "u_rect" );
+	programs_ready_ = true;
+	return true;
+}
+
+void LuminanceHistogram::Analyze( GLuint texture, const int rect[4], GlStateCache& gl_state )
+{
+	// every slot still on its way: this window is measured again next frame
+	if ( fences_[next_slot_] || rect[2] < kStride || rect[3] < kStride )
+		return;
+
+	gl_state.UseProgram( build_.GetId() );
+	gl_state.BindMultiTexture2D( kSourceUnit, texture );
+	glUniform4i( rect_location_, rect[0], rect[1], rect[2], rect[3] );
+	gl_state.BindStorageBufferRange( 0, histogram_buffer_, 0, 0 );
+	glDispatchCompute( ( rect[2] / kStride + kGroupSize - 1 ) / kGroupSize, ( rect[3] / kStride + kGroupSize - 1 ) / kGroupSize, 1 );
+	glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+
+	gl_state.UseProgram( reduce_.GetId() );
+	gl_state.BindStorageBufferRange( 1, result_buffer_, next_slot_ * slot_stride_, sizeof( Result ) );
+	glDispatchCompute( 1, 1, 1 );
+	glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT );
+
+	// the IG's state cache knows nothing of storage buffers, the generic binding is restored with the rest
+	gl_state.BindStorageBufferRange( 0, 0, 0, 0 );
+	gl_state.BindStorageBufferRange( 1, 0, 0, 0 );
+
+	fences_[next_slot_] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	next_slot_ = ( next_slot_ + 1 ) % kSlots;
+}
+
+bool LuminanceHistogram::TakeResult( float& average_log )
+{
+	while ( fences_[oldest_slot_] && IsSignaled( fences_[oldest_slot_] ) )
+	{
+		glDeleteSync( fences_[oldest_slot_] );
+		fences_[oldest_slot_] = 0;
+
+		Result result = { 0.0f, 0 };
+		glGetNamedBufferSubDataEXT( result_buffer_, oldest_slot_ * slot_stride_, sizeof( result ), &result );
+		oldest_slot_ = ( oldest_slot_ + 1 ) % kSlots;
+		if ( result.samples > 0 )
+		{
+			average_log = result.average_log;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,72 @@
+//==============================================================================
+// File:LuminanceHistogram.h
+//==============================================================================
+//
+// Description: Measures the brightness of a channel on the GPU, for exposure
+//				adaptation. A compute pass bins the log luminance of every 4th
+//				pixel in both directions into a 64 bin histogram, a second pass
+//				reduces it to the average log luminance between the 50th and
+//				95th percentile. The result is read back frames later, once its
+//				fence has passed, so the CPU never waits for the GPU.
+//
+//==============================================================================
+
+#ifndef DVC_LUMINANCE_HISTOGRAM_H
+#define DVC_LUMINANCE_HISTOGRAM_H
+
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
+
+class LuminanceHistogram
+{
+public:
+	LuminanceHistogram();
+
+	/*!
+	 * Needs the IG context, GL 4.3 or ARB_compute_shader and ARB_shader_storage_buffer_object.
+	 *
+	 * @return
+	 *  false if the context cannot run the analysis.
+	**/
+	bool Load( GlProgramCache& program_cache );
+	void Unload();
+
+	bool IsReady();
+
+	/*!
+	 * Queues the analysis of a part of a texture. Skipped while every result slot still waits
+	 * for the GPU. Leaves no shader storage buffer bound.
+	 *
+	 * @param[in] texture : single-sampled color
+	 * @param[in] rect : x, y, width and height of the part to analyze, in pixels
+	**/
+	void Analyze( GLuint texture, const int rect[4], GlStateCache& gl_state );
+
+	/*!
+	 * Hands over the oldest finished analysis, call until it returns false.
+	 *
+	 * @param[out] average_log : log2 of the average luminance, -10 for black
+	**/
+	bool TakeResult( float& average_log );
+
+private:
+	LuminanceHistogram( const LuminanceHistogram& );
+	LuminanceHistogram& operator=( const LuminanceHistogram& );
+
+	enum { kSlots = 4 };
+
+	GlProgram build_;
+	GlProgram reduce_;
+	GLint rect_location_;
+	bool programs_ready_;
+
+	GLuint histogram_buffer_;		/* the bins, cleared by every reduce */
+	GLuint result_buffer_;			/* one result per slot, slot_stride_ apart */
+	GLintptr slot_stride_;
+	GLsync fences_[kSlots];			/* set while the slot's result is on its way */
+	unsigned int next_slot_;		/* written next */
+	unsigned int oldest_slot_;		/* read next */
+};
+
+#endif // DVC_LUMINANCE_HISTOGRAM_H
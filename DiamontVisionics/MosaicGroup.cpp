@@ -0,0 +1,164 @@
+//==============================================================================
+// File:MosaicGroup.cpp
+//==============================================================================
+
+#include "MosaicGroup.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	const double kToRadians = 3.14159265358979 / 180.0;
+	const float kViewTolerance = 1e-3f;		// view matrix elements of members sharing eye point and orientation
+	const double kCoverageTolerance = 1.02;	// the union may exceed the members' area by rounding only
+	const double kResizeTolerance = 0.02;	// smaller changes of the scene size keep the targets
+
+	bool Differs( unsigned int current, unsigned int wanted )
+	{
+		return std::abs( (double)wanted - (double)current ) > kResizeTolerance * current;
+	}
+}
+
+MosaicGroup::MosaicGroup( const std::vector<int>& windows )
+	: windows_( windows )
+	, scene_width_( 0 )
+	, scene_height_( 0 )
+	, active_( false )
+	, reported_( false )
+	, leader_frame_( 0 )
+	, order_reported_( false )
+{
+	frustum_ = FrustumParameters();
+}
+
+bool MosaicGroup::Contains( int window_id ) const
+{
+	return windows_.end() != std::find( windows_.begin(), windows_.end(), window_id );
+}
+
+void MosaicGroup::EndWindow( int window_id, unsigned int frame )
+{
+	if ( GetLeader() == window_id )
+	{
+		leader_frame_ = frame;
+		return;
+	}
+	if ( !active_ || order_reported_ || leader_frame_ == frame || !Contains( window_id ) )
+		return;
+	std::cout << "Warning: window_id " << window_id << " is processed before window_id " << GetLeader()
+		<< ", which renders the scene of its mosaic, and warps the previous frame. List first the window the IG processes first." << std::endl;
+	order_reported_ = true;
+}
+
+bool MosaicGroup::Update( const std::map<int, ExternalFbo*>& fbos )
+{
+	std::vector<ExternalFbo*> members;
+	for ( size_t i = 0; i < windows_.size(); ++i )
+	{
+		std::map<int, ExternalFbo*>::const_iterator found = fbos.find( windows_[i] );
+		if ( fbos.end() == found )
+		{
+			// not every member has been drawn yet
+			Deactivate( fbos );
+			return false;
+		}
+		members.push_back( found->second );
+	}
+
+	ExternalFbo& leader = *members.front();
+	const ExternalFbo::FrameSetup& leader_setup = leader.GetFrameSetup();
+	double bounds[4] = { HUGE_VAL, -HUGE_VAL, HUGE_VAL, -HUGE_VAL };	// tangents: left, right, bottom, top
+	double area = 0.0;
+	double density[2] = { 0.0, 0.0 };								// window pixels per unit of tangent
+	std::vector<double> tangents( members.size() * 4 );
+	for ( size_t i = 0; i < members.size(); ++i )
+	{
+		const ExternalFbo::FrameSetup& setup = members[i]->GetFrameSetup();
+		if ( !setup.has_frustum || !setup.has_view )
+			return Fail( fbos, "a warper reports no frustum" );
+		for ( int k = 0; k < 16; ++k )
+		{
+			if ( std::abs( setup.view[k] - leader_setup.view[k] ) > kViewTolerance )
+				return Fail( fbos, "the channels do not share the leader's eye point and orientation" );
+		}
+
+		double* t = &tangents[i * 4];
+		t[0] = std::tan( setup.frustum.left_degrees * kToRadians );
+		t[1] = std::tan( setup.frustum.right_degrees * kToRadians );
+		t[2] = std::tan( setup.frustum.bottom_degrees * kToRadians );
+		t[3] = std::tan( setup.frustum.top_degrees * kToRadians );
+		if ( !( t[1] > t[0] ) || !( t[3] > t[2] ) )
+			return Fail( fbos, "a warper reports an empty frustum" );
+		bounds[0] = std::min( bounds[0], t[0] );
+		bounds[1] = std::max( bounds[1], t[1] );
+		bounds[2] = std::min( bounds[2], t[2] );
+		bounds[3] = std::max( bounds[3], t[3] );
+		area += ( t[1] - t[0] ) * ( t[3] - t[2] );
+		density[0] = std::max( density[0], members[i]->GetWidth() / ( t[1] - t[0] ) );
+		density[1] = std::max( density[1], members[i]->GetHeight() / ( t[3] - t[2] ) );
+	}
+
+	// overlaps only add to the members' area, so a union larger than it has holes
+	const double width = bounds[1] - bounds[0];
+	const double height = bounds[3] - bounds[2];
+	if ( width * height > area * kCoverageTolerance )
+		return Fail( fbos, "the channels leave gaps between them" );
+
+	// the densest member sets the resolution, within what a texture can hold
+	GLint max_size = 0;
+	glGetIntegerv( GL_MAX_TEXTURE_SIZE, &max_size );
+	const unsigned int scene_width = (unsigned int)std::min( std::ceil( density[0] * width ), (double)max_size );
+	const unsigned int scene_height = (unsigned int)std::min( std::ceil( density[1] * height ), (double)max_size );
+	if ( !active_ || Differs( scene_width_, scene_width ) || Differs( scene_height_, scene_height ) )
+	{
+		scene_width_ = scene_width;
+		scene_height_ = scene_height;
+		leader.SetMosaicScene( scene_width_, scene_height_ );
+		std::cout << "Info: window_id " << GetLeader() << " renders " << members.size() << " channels as one "
+			<< scene_width_ << "x" << scene_height_ << " scene." << std::endl;
+	}
+
+	for ( size_t i = 0; i < members.size(); ++i )
+	{
+		const double* t = &tangents[i * 4];
+		const float rect[4] = { (float)( ( t[0] - bounds[0] ) / width ), (float)( ( t[2] - bounds[2] ) / height ),
+			(float)( ( t[1] - t[0] ) / width ), (float)( ( t[3] - t[2] ) / height ) };
+		members[i]->SetMosaicSource( &leader, rect );
+	}
+
+	frustum_ = leader_setup.frustum;
+	frustum_.left_degrees = (float)( std::atan( bounds[0] ) / kToRadians );
+	frustum_.right_degrees = (float)( std::atan( bounds[1] ) / kToRadians );
+	frustum_.bottom_degrees = (float)( std::atan( bounds[2] ) / kToRadians );
+	frustum_.top_degrees = (float)( std::atan( bounds[3] ) / kToRadians );
+	active_ = true;
+	return true;
+}
+
+void MosaicGroup::Deactivate( const std::map<int, ExternalFbo*>& fbos )
+{
+	if ( !active_ )
+		return;
+
+	for ( size_t i = 0; i < windows_.size(); ++i )
+	{
+		std::map<int, ExternalFbo*>::const_iterator found = fbos.find( windows_[i] );
+		if ( fbos.end() == found )
+			continue;
+		found->second->SetMosaicSource( nullptr, nullptr );
+		if ( GetLeader() == windows_[i] )
+			found->second->SetMosaicScene( 0, 0 );
+	}
+	active_ = false;
+}
+
+bool MosaicGroup::Fail( const std::map<int, ExternalFbo*>& fbos, const char* reason )
+{
+	if ( !reported_ )
+		std::cout << "Warning: the mosaic of window_id " << GetLeader() << " is off while " << reason << "." << std::endl;
+	reported_ = true;
+	Deactivate( fbos );
+	return false;
+}
@@ -0,0 +1,71 @@
+//==============================================================================
+// File:MosaicGroup.h
+//==============================================================================
+//
+// Description: Adjacent channels sharing an eye point, rendered as one scene.
+//				The group's first window, the leader, has the IG render the
+//				union of the members' frusta into one large scene target, and
+//				every member warps its own part of it. The other members' own
+//				renders collapse to a sliver of frustum the IG culls at once.
+//				The IG has to process the leader first in a frame: a member
+//				processed before it warps the leader's previous frame, which
+//				EndWindow reports.
+//
+//==============================================================================
+
+#ifndef DVC_MOSAIC_GROUP_H
+#define DVC_MOSAIC_GROUP_H
+
+#include "ExternalFbo.h"
+
+#include <map>
+#include <vector>
+
+class MosaicGroup
+{
+public:
+	/*!
+	 * @param[in] windows : ids of the members, the first one leads
+	**/
+	explicit MosaicGroup( const std::vector<int>& windows );
+
+	int GetLeader() const { return windows_.front(); }
+	bool Contains( int window_id ) const;
+
+	/*! The leader renders for the group this frame. **/
+	bool IsActive() const { return active_; }
+
+	/*! Union of the members' frusta, for the leader's render. **/
+	const FrustumParameters& GetFrustum() const { return frustum_; }
+
+	/*!
+	 * Merges the members' frusta for the coming frame, sizes the leader's scene and hands every
+	 * member its part. Needs the members' frame setups and the IG context.
+	 *
+	 * @return
+	 *  false until all members exist, or if their frusta do not form one image: every member
+	 *  renders its own scene then.
+	**/
+	bool Update( const std::map<int, ExternalFbo*>& fbos );
+
+	/*!
+	 * Records that the IG has finished a member's scene, in postWindowProcess. Warns once if a
+	 * member comes before the leader in a frame, it warps the leader's previous frame then.
+	**/
+	void EndWindow( int window_id, unsigned int frame );
+
+private:
+	void Deactivate( const std::map<int, ExternalFbo*>& fbos );
+	bool Fail( const std::map<int, ExternalFbo*>& fbos, const char* reason );
+
+	std::vector<int> windows_;
+	FrustumParameters frustum_;
+	unsigned int scene_width_;		/* of the leader at render scale 1, kept while within 2% */
+	unsigned int scene_height_;
+	bool active_;
+	bool reported_;					/* a failed merge is reported once */
+	unsigned int leader_frame_;		/* the frame the leader's scene was last finished in */
+	bool order_reported_;			/* and a member ahead of it, once */
+};
+
+#endif // DVC_MOSAIC_GROUP_H
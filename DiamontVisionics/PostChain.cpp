@@ -0,0 +1,294 @@
+//==============================================================================
+// File:PostChain.cpp
+//==============================================================================
+
+#include "PostChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	const char* kVertexShader = R"(
+#version 330 core
+void main()
+{
+	vec2 corner = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );
+	gl_Position = vec4( corner * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+	// followed by the merged effects and kFragmentMain
+	const char* kFragmentDeclarations = R"(
+#version 330 core
+uniform sampler2D u_source;
+uniform vec2 u_source_texel;	// of the part of u_source that holds the source
+uniform float u_post_seed;
+out vec4 frag_color;
+vec3 PostSource( vec2 uv )
+{
+	vec2 scale = 1.0 / ( u_source_texel * vec2( textureSize( u_source, 0 ) ) );
+	return texture( u_source, clamp( uv, 0.5 * u_source_texel, 1.0 - 0.5 * u_source_texel ) * scale ).rgb;
+}
+)";
+
+	const char* kFragmentMain = R"(
+void main()
+{
+	frag_color = vec4( Post( gl_FragCoord.xy * u_source_texel ), 1.0 );
+}
+)";
+
+	// shared by all generated effects, PostSource is up to the shader they are part of
+	const char* kPostFunctions = R"(
+float PostHash( vec2 p )
+{
+	return fract( sin( dot( p, vec2( 12.9898, 78.233 ) ) ) * 43758.5453 );
+}
+vec3 PostStage0( vec2 uv )
+{
+	return PostSource( uv );
+}
+)";
+
+	// same unit as the warp's source, 0 is left to the IG
+	const GLint kSourceUnit = 1;
+
+	int GetTaps( const PostEffect& effect )
+	{
+		return PostEffect::SHARPEN == effect.type ? 5 : 1;
+	}
+}
+
+PostChain::PostChain()
+	: vertex_array_( 0 )
+	, programs_ready_( false )
+	, seed_( 0.0f )
+{
+}
+
+void PostChain::Configure( const std::vector<PostEffect>& effects, int max_taps )
+{
+	passes_.clear();
+	programs_ready_ = false;
+	max_taps = std::max( max_taps, 1 );
+
+	// taps multiply: each effect reads the ones before it once per tap
+	size_t first = 0;
+	int taps = 1;
+	for ( size_t i = 0; i < effects.size(); ++i )
+	{
+		if ( i > first && taps * GetTaps( effects[i] ) > max_taps )
+		{
+			AddPass( effects, first, i - first );
+			first = i;
+			taps = 1;
+		}
+		taps *= GetTaps( effects[i] );
+	}
+	if ( first < effects.size() )
+		AddPass( effects, first, effects.size() - first );
+
+	if ( !passes_.empty() )
+		std::cout << "Info: " << effects.size() << " post effect(s) merged into " << passes_.size() << " pass(es)." << std::endl;
+}
+
+void PostChain::AddPass( const std::vector<PostEffect>& effects, size_t first, size_t count )
+{
+	// parameters are baked in as float literals, so they always need a decimal point
+	std::ostringstream glsl;
+	glsl << std::showpoint << kPostFunctions;
+	for ( size_t stage = 1; stage <= count; ++stage )
+	{
+		const PostEffect& effect = effects[first + stage - 1];
+		std::ostringstream previous;
+		previous << "PostStage" << stage - 1;
+		const std::string p = previous.str();
+
+		glsl << "vec3 PostStage" << stage << "( vec2 uv )\n{\n";
+		switch ( effect.type )
+		{
+		case PostEffect::SHARPEN:
+			glsl << "\tvec3 c = " << p << "( uv );\n"
+				<< "\tvec3 n = " << p << "( uv + vec2( u_source_texel.x, 0.0 ) ) + " << p << "( uv - vec2( u_source_texel.x, 0.0 ) )\n"
+				<< "\t\t+ " << p << "( uv + vec2( 0.0, u_source_texel.y ) ) + " << p << "( uv - vec2( 0.0, u_source_texel.y ) );\n"
+				<< "\treturn max( c + " << effect.amount << " * ( c - 0.25 * n ), 0.0 );\n";
+			break;
+		case PostEffect::VIGNETTE:
+			glsl << "\tvec2 d = uv - 0.5;\n"
+				<< "\treturn " << p << "( uv ) * ( 1.0 - " << effect.amount << " * smoothstep( 0.1, 0.5, dot( d, d ) ) );\n";
+			break;
+		case PostEffect::GRAIN:
+			// per source pixel, so the grain does not swim with the warp
+			glsl << "\tfloat noise = PostHash( floor( uv / u_source_texel ) + u_post_seed * 251.0 ) - 0.5;\n"
+				<< "\treturn max( " << p << "( uv ) + " << effect.amount << " * noise, 0.0 );\n";
+			break;
+		case PostEffect::TINT:
+			glsl << "\tvec3 c = " << p << "( uv );\n"
+				<< "\tvec3 tint = dot( c, vec3( 0.2126, 0.7152, 0.0722 ) ) * vec3( "
+				<< effect.color[0] << ", " << effect.color[1] << ", " << effect.color[2] << " );\n"
+				<< "\treturn mix( c, tint, " << effect.amount << " );\n";
+			break;
+		}
+		glsl << "}\n";
+	}
+	glsl << "vec3 Post( vec2 uv )\n{\n\treturn PostStage" << count << "( uv );\n}\n";
+
+	std::unique_ptr<Pass> pass( new Pass );
+	pass->source = glsl.str();
+	pass->source_texel_location = -1;
+	pass->seed_location = -1;
+	passes_.push_back( std::move( pass ) );
+}
+
+bool PostChain::Initialize( GlProgramCache& program_cache )
+{
+	if ( passes_.empty() )
+		return true;
+
+	glGenVertexArrays( 1, &vertex_array_ );
+	bool requested = true;
+	for ( size_t i = 0; i < passes_.size(); ++i )
+	{
+		const std::string fragment_source = kFragmentDeclarations + passes_[i]->source + kFragmentMain;
+		passes_[i]->program.Request( program_cache, "VIOSO-Plugin post effects", kVertexShader, fragment_source.c_str() );
+		requested = requested && ( passes_[i]->program.IsValid() || passes_[i]->program.IsPending() );
+	}
+	Update();
+	return requested;
+}
+
+void PostChain::Shutdown()
+{
+	for ( size_t i = 0; i < passes_.size(); ++i )
+		passes_[i]->program.Release();
+	for ( size_t i = 0; i < pool_.size(); ++i )
+	{
+		glDeleteFramebuffers( 1, &pool_[i].framebuffer );
+		glDeleteTextures( 1, &pool_[i].texture );
+	}
+	pool_.clear();
+	if ( vertex_array_ )
+		glDeleteVertexArrays( 1, &vertex_array_ );
+	vertex_array_ = 0;
+	programs_ready_ = false;
+}
+
+void PostChain::Update()
+{
+	seed_ = seed_ + 0.618034f - std::floor( seed_ + 0.618034f );
+	if ( programs_ready_ || passes_.empty() )
+		return;
+
+	bool ready = true;
+	for ( size_t i = 0; i < passes_.size(); ++i )
+	{
+		Pass& pass = *passes_[i];
+		if ( pass.program.TakeReady() )
+		{
+			glProgramUniform1iEXT( pass.program.GetId(), pass.program.GetUniform( "u_source" ), kSourceUnit );
+			pass.source_texel_location = pass.program.GetUniform( "u_source_texel" );
+			pass.seed_location = pass.program.GetUniform( "u_post_seed" );
+		}
+		ready = ready && pass.program.IsValid();
+	}
+	programs_ready_ = ready;
+}
+
+const std::string& PostChain::GetFusedSource() const
+{
+	static const std::string empty;
+	return passes_.empty() ? empty : passes_.back()->source;
+}
+
+GLuint PostChain::Apply( GLuint source_framebuffer, GLuint source_texture, int width, int height, bool fuse_last, GlStateCache& gl_state )
+{
+	for ( size_t i = 0; i < pool_.size(); ++i )
+		pool_[i].in_use = false;
+
+	const size_t own_passes = passes_.size() - ( fuse_last && !passes_.empty() ? 1 : 0 );
+	if ( !programs_ready_ || 0 == own_passes )
+		return 0;
+
+	// passes ping-pong between pool targets; a source that can be sampled is read in place,
+	// unless a single unfused pass would write to it at the same time
+	const size_t none = pool_.size() + passes_.size() + 1;
+	size_t input = none;
+	size_t output = none;
+	GLuint input_texture = ( fuse_last || own_passes > 1 ) ? source_texture : 0;
+	if ( 0 == input_texture )
+	{
+		// the blit also resolves a multisampled source
+		input = Acquire( width, height );
+		gl_state.Disable( GL_SCISSOR_TEST );
+		gl_state.BindFramebuffer( source_framebuffer );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, pool_[input].framebuffer );
+		glBlitFramebuffer( 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+		input_texture = pool_[input].texture;
+	}
+
+	for ( size_t i = 0; i < own_passes; ++i )
+	{
+		// the last pass of an unfused chain writes the result back
+		if ( !fuse_last && i + 1 == own_passes )
+		{
+			Draw( *passes_[i], input_texture, source_framebuffer, width, height, gl_state );
+			return 0;
+		}
+		if ( none == output )
+			output = Acquire( width, height );
+		Draw( *passes_[i], input_texture, pool_[output].framebuffer, width, height, gl_state );
+		input_texture = pool_[output].texture;
+		std::swap( input, output );
+	}
+	return input_texture;
+}
+
+size_t PostChain::Acquire( int width, int height )
+{
+	// the smallest free target that fits, a smaller image uses its lower left
+	size_t best = pool_.size();
+	for ( size_t i = 0; i < pool_.size(); ++i )
+	{
+		if ( !pool_[i].in_use && pool_[i].width >= width && pool_[i].height >= height
+			&& ( pool_.size() == best || pool_[i].width * pool_[i].height < pool_[best].width * pool_[best].height ) )
+			best = i;
+	}
+	if ( best < pool_.size() )
+	{
+		pool_[best].in_use = true;
+		return best;
+	}
+
+	Target target = { 0, 0, width, height, true };
+	glGenTextures( 1, &target.texture );
+	glTextureParameteriEXT( target.texture, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S    , GL_CLAMP_TO_EDGE );
+	glTextureParameteriEXT( target.texture, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T    , GL_CLAMP_TO_EDGE );
+	glTextureParameteriEXT( target.texture, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR       );
+	glTextureParameteriEXT( target.texture, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR       );
+	glTextureImage2DEXT( target.texture, GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+	glGenFramebuffers( 1, &target.framebuffer );
+	glNamedFramebufferTextureEXT( target.framebuffer, GL_COLOR_ATTACHMENT0, target.texture, 0 );
+	pool_.push_back( target );
+	return pool_.size() - 1;
+}
+
+void PostChain::Draw( const Pass& pass, GLuint source_texture, GLuint target_framebuffer, int width, int height, GlStateCache& gl_state )
+{
+	gl_state.BindFramebuffer( target_framebuffer );
+	gl_state.Viewport( 0, 0, width, height );
+	gl_state.Disable( GL_DEPTH_TEST );
+	gl_state.Disable( GL_BLEND );
+	gl_state.Disable( GL_CULL_FACE );
+	gl_state.Disable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
+	gl_state.UseProgram( pass.program.GetId() );
+	gl_state.BindVertexArray( vertex_array_ );
+	gl_state.BindMultiTexture2D( kSourceUnit, source_texture );
+
+	glUniform2f( pass.source_texel_location, 1.0f / width, 1.0f / height );
+	glUniform1f( pass.seed_location, seed_ );
+	glDrawArrays( GL_TRIANGLES, 0, 3 );
+}
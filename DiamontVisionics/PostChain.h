@@ -0,0 +1,130 @@
+//==============================================================================
+// File:PostChain.h
+//==============================================================================
+//
+// Description: Runs the post effects configured for the VIOSO plugin (sharpen,
+//				vignette, film grain, NVG tint) in as few full-screen passes as
+//				possible. Consecutive effects are merged into one generated
+//				shader: per-pixel effects follow each other, and an effect that
+//				reads neighbours evaluates the effects before it at each tap. A
+//				new pass starts only where the taps per pixel would exceed the
+//				configured limit. The last pass runs inside the warp when the
+//				plugin warps the channel itself, see GetFusedSource().
+//
+//==============================================================================
+
+#ifndef DVC_POST_CHAIN_H
+#define DVC_POST_CHAIN_H
+
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+struct PostEffect
+{
+	enum Type
+	{
+		SHARPEN = 0,	/* unsharp mask over the 4 neighbours, 5 taps */
+		VIGNETTE,		/* darkens towards the corners */
+		GRAIN,			/* film grain, new every frame */
+		TINT			/* luminance times color, e.g. NVG phosphor green */
+	};
+
+	Type type;
+	float amount;		/* strength, 0-1 except for SHARPEN */
+	float color[3];		/* TINT only */
+};
+
+class PostChain
+{
+public:
+	PostChain();
+
+	/*!
+	 * Takes the effects in the order they are applied and merges them into passes.
+	 *
+	 * @param[in] max_taps : source reads per pixel a merged pass may make, at least 1
+	**/
+	void Configure( const std::vector<PostEffect>& effects, int max_taps );
+
+	bool IsEmpty() const { return passes_.empty(); }
+
+	/*! Full-screen passes the effects take, the last one may run inside the warp. **/
+	size_t GetPassCount() const { return passes_.size(); }
+
+	/*!
+	 * Requests the programs of all passes. Needs the IG context. The effects stay off until
+	 * every program is ready, so a chain never shows half applied.
+	**/
+	bool Initialize( GlProgramCache& program_cache );
+	void Shutdown();
+
+	/*!
+	 * Picks up compiled programs and moves the grain on. Call once per frame.
+	**/
+	void Update();
+
+	bool IsReady() const { return programs_ready_; }
+
+	/*!
+	 * GLSL of the last pass, defining vec3 Post( vec2 uv ) for a shader that declares
+	 * vec2 u_source_texel and float u_post_seed and reads its source with vec3 PostSource( vec2 uv ).
+	 * Empty without effects.
+	**/
+	const std::string& GetFusedSource() const;
+
+	/*! Value for u_post_seed this frame. **/
+	GLfloat GetSeed() const { return seed_; }
+
+	/*!
+	 * Runs the passes on the color of source_framebuffer. Nothing happens until IsReady().
+	 *
+	 * @param[in] source_texture : the color of source_framebuffer if it is single-sampled
+	 *  and may be read while the passes run, which saves copying it. 0 otherwise.
+	 * @param[in] width, height : size of source_framebuffer in pixels
+	 * @param[in] fuse_last : the caller runs the last pass, with GetFusedSource()
+	 *
+	 * @return
+	 *  with fuse_last, the texture the last pass has to read, 0 for the color of
+	 *  source_framebuffer itself. Without it 0: the result is back in source_framebuffer.
+	**/
+	GLuint Apply( GLuint source_framebuffer, GLuint source_texture, int width, int height, bool fuse_last, GlStateCache& gl_state );
+
+private:
+	PostChain( const PostChain& );
+	PostChain& operator=( const PostChain& );
+
+	struct Pass
+	{
+		std::string source;		/* the merged effects, see GetFusedSource() */
+		GlProgram program;
+		GLint source_texel_location;
+		GLint seed_location;
+	};
+
+	/*! A ping-pong target, kept across frames and shared by all images that fit into it. **/
+	struct Target
+	{
+		GLuint texture;
+		GLuint framebuffer;
+		int width;
+		int height;
+		bool in_use;
+	};
+
+	void AddPass( const std::vector<PostEffect>& effects, size_t first, size_t count );
+	size_t Acquire( int width, int height );	/* index into pool_, free again at the next Apply */
+	void Draw( const Pass& pass, GLuint source_texture, GLuint target_framebuffer, int width, int height, GlStateCache& gl_state );
+
+	std::vector<std::unique_ptr<Pass> > passes_;
+	std::vector<Target> pool_;
+	GLuint vertex_array_;
+	bool programs_ready_;
+	GLfloat seed_;				/* grain offset, a low discrepancy sequence over the frames */
+};
+
+#endif // DVC_POST_CHAIN_H
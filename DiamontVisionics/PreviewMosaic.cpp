@@ -0,0 +1,253 @@
+//==============================================================================
+// File:PreviewMosaic.cpp
+//==============================================================================
+
+#include "PreviewMosaic.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	const int kMaxTiles = 32;			// more projector channels than any installation has
+
+	bool IsSignaled( GLsync fence )
+	{
+		const GLenum result = glClientWaitSync( fence, 0, 0 );
+		return GL_ALREADY_SIGNALED == result || GL_CONDITION_SATISFIED == result;
+	}
+}
+
+PreviewMosaic::PreviewMosaic()
+	: tile_width_( 0 )
+	, tile_height_( 0 )
+	, interval_( 1 )
+	, mapping_( NULL )
+	, header_( nullptr )
+	, tiles_( nullptr )
+	, pixels_( nullptr )
+	, open_failed_( false )
+{
+}
+
+PreviewMosaic::~PreviewMosaic()
+{
+	// no context guaranteed here, Shutdown() is the owner's job
+}
+
+void PreviewMosaic::Configure( int tile_width, int tile_height, const std::string& shared_memory_name, unsigned int interval )
+{
+	tile_width_ = std::max( tile_width, 0 );
+	tile_height_ = std::max( tile_height, 0 );
+	shared_memory_name_ = shared_memory_name;
+	interval_ = std::max( interval, 1u );
+	if ( shared_memory_name_.empty() )
+		tile_width_ = tile_height_ = 0;
+}
+
+bool PreviewMosaic::Open()
+{
+	if ( header_ )
+		return true;
+	if ( open_failed_ )
+		return false;
+
+	const size_t image_size = (size_t)tile_width_ * tile_height_ * 4;
+	const size_t size = sizeof( PreviewHeader ) + kMaxTiles * ( sizeof( PreviewTile ) + image_size );
+	mapping_ = CreateFileMappingA( INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, (DWORD)size, shared_memory_name_.c_str() );
+	void* view = mapping_ ? MapViewOfFile( mapping_, FILE_MAP_WRITE, 0, 0, size ) : nullptr;
+	if ( nullptr == view )
+	{
+		std::cout << "Warning: could not create the preview mosaic " << shared_memory_name_ << ", previews are off." << std::endl;
+		if ( mapping_ )
+			CloseHandle( mapping_ );
+		mapping_ = NULL;
+		open_failed_ = true;
+		return false;
+	}
+
+	header_ = static_cast<PreviewHeader*>( view );
+	tiles_ = reinterpret_cast<PreviewTile*>( header_ + 1 );
+	pixels_ = reinterpret_cast<unsigned char*>( tiles_ + kMaxTiles );
+	header_->magic = kPreviewMagic;
+	header_->version = kPreviewVersion;
+	header_->tile_width = tile_width_;
+	header_->tile_height = tile_height_;
+	header_->max_tiles = kMaxTiles;
+	header_->tile_count = 0;
+	for ( int i = 0; i < kMaxTiles; ++i )
+	{
+		tiles_[i].sequence = 0;
+		tiles_[i].window_id = -1;
+		tiles_[i].window_width = tiles_[i].window_height = 0;
+	}
+	std::cout << "Info: previews of " << tile_width_ << "x" << tile_height_ << " go to " << shared_memory_name_ << "." << std::endl;
+	return true;
+}
+
+PreviewMosaic::Channel* PreviewMosaic::GetChannel( int window_id )
+{
+	std::map<int, Channel>::iterator found = channels_.find( window_id );
+	if ( channels_.end() != found )
+		return &found->second;
+
+	const int tile = (int)channels_.size();
+	if ( tile >= kMaxTiles )
+	{
+		if ( kMaxTiles == tile )
+			std::cout << "Warning: the preview mosaic holds " << kMaxTiles << " windows, window_id " << window_id << " and later are left out." << std::endl;
+		channels_[window_id].tile = -1;
+		return nullptr;
+	}
+
+	Channel& channel = channels_[window_id];
+	channel.tile = tile;
+	channel.width = channel.height = 0;
+	glGenBuffers( kSlots, channel.buffers );
+	for ( int i = 0; i < kSlots; ++i )
+	{
+		glNamedBufferDataEXT( channel.buffers[i], tile_width_ * tile_height_ * 4, nullptr, GL_STREAM_READ );
+		channel.fences[i] = 0;
+	}
+	channel.next_slot = channel.oldest_slot = 0;
+	channel.frames = 0;
+
+	tiles_[tile].window_id = window_id;
+	InterlockedIncrement( &header_->tile_count );
+	return &channel;
+}
+
+void PreviewMosaic::Capture( int window_id, GLuint framebuffer, int width, int height, GlStateCache& gl_state )
+{
+	if ( !IsEnabled() || width <= 0 || height <= 0 || !Open() )
+		return;
+	Channel* found = GetChannel( window_id );
+	if ( nullptr == found || found->tile < 0 )
+		return;
+	Channel& channel = *found;
+
+	// finished reads go straight into the viewer's memory
+	const size_t image_size = (size_t)tile_width_ * tile_height_ * 4;
+	PreviewTile& tile = tiles_[channel.tile];
+	while ( channel.fences[channel.oldest_slot] && IsSignaled( channel.fences[channel.oldest_slot] ) )
+	{
+		glDeleteSync( channel.fences[channel.oldest_slot] );
+		channel.fences[channel.oldest_slot] = 0;
+		InterlockedIncrement( &tile.sequence );
+		tile.window_width = channel.width;
+		tile.window_height = channel.height;
+		glGetNamedBufferSubDataEXT( channel.buffers[channel.oldest_slot], 0, image_size, pixels_ + channel.tile * image_size );
+		InterlockedIncrement( &tile.sequence );
+		channel.oldest_slot = ( channel.oldest_slot + 1 ) % kSlots;
+	}
+
+	// every interval_ frames, skipped while every slot is still on its way
+	if ( 0 != channel.frames++ % interval_ || channel.fences[channel.next_slot] )
+		return;
+
+	if ( channel.width != width || channel.height != height )
+		BuildLevels( channel, framebuffer, width, height, gl_state );
+
+	// blits are clipped by the scissor, and the cache does not know the read and draw bindings
+	gl_state.Disable( GL_SCISSOR_TEST );
+	gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+	GLuint source = framebuffer;
+	int source_width = width;
+	int source_height = height;
+	for ( size_t i = 0; i < channel.levels.size(); ++i )
+	{
+		const Level& level = channel.levels[i];
+		glBindFramebuffer( GL_READ_FRAMEBUFFER, source );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, level.framebuffer );
+		glBlitFramebuffer( 0, 0, source_width, source_height, 0, 0, level.width, level.height, GL_COLOR_BUFFER_BIT,
+			level.width == source_width && level.height == source_height ? GL_NEAREST : GL_LINEAR );
+		source = level.framebuffer;
+		source_width = level.width;
+		source_height = level.height;
+	}
+
+	// the IG's pack buffer is put back with the rest of the state
+	glBindFramebuffer( GL_READ_FRAMEBUFFER, source );
+	gl_state.BindPixelPackBuffer( channel.buffers[channel.next_slot] );
+	glReadPixels( 0, 0, tile_width_, tile_height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+	gl_state.BindPixelPackBuffer( 0 );
+	channel.fences[channel.next_slot] = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	channel.next_slot = ( channel.next_slot + 1 ) % kSlots;
+}
+
+void PreviewMosaic::BuildLevels( Channel& channel, GLuint framebuffer, int width, int height, GlStateCache& gl_state )
+{
+	ReleaseLevels( channel );
+	channel.width = width;
+	channel.height = height;
+
+	// a scaled blit cannot read a multisampled framebuffer, it is resolved at full size first
+	gl_state.BindFramebuffer( framebuffer );
+	GLint sample_buffers = 0;
+	glGetIntegerv( GL_SAMPLE_BUFFERS, &sample_buffers );
+	std::vector<Level> sizes;
+	Level level = { 0, 0, width, height };
+	if ( sample_buffers > 0 )
+		sizes.push_back( level );
+	// halved while that stays above the tile, each step averages 2x2 pixels
+	while ( level.width / 2 >= tile_width_ && level.height / 2 >= tile_height_ )
+	{
+		level.width /= 2;
+		level.height /= 2;
+		sizes.push_back( level );
+	}
+	if ( sizes.empty() || level.width != tile_width_ || level.height != tile_height_ )
+	{
+		level.width = tile_width_;
+		level.height = tile_height_;
+		sizes.push_back( level );
+	}
+
+	for ( size_t i = 0; i < sizes.size(); ++i )
+	{
+		Level& step = sizes[i];
+		glGenTextures( 1, &step.texture );
+		glGenFramebuffers( 1, &step.framebuffer );
+		glTextureImage2DEXT( step.texture, GL_TEXTURE_2D, 0, GL_RGBA8, step.width, step.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+		glTextureParameteriEXT( step.texture, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glNamedFramebufferTextureEXT( step.framebuffer, GL_COLOR_ATTACHMENT0, step.texture, 0 );
+	}
+	channel.levels.swap( sizes );
+}
+
+void PreviewMosaic::ReleaseLevels( Channel& channel )
+{
+	for ( size_t i = 0; i < channel.levels.size(); ++i )
+	{
+		glDeleteFramebuffers( 1, &channel.levels[i].framebuffer );
+		glDeleteTextures( 1, &channel.levels[i].texture );
+	}
+	channel.levels.clear();
+}
+
+void PreviewMosaic::Shutdown()
+{
+	for ( std::map<int, Channel>::iterator it = channels_.begin(); it != channels_.end(); ++it )
+	{
+		Channel& channel = it->second;
+		if ( channel.tile < 0 )
+			continue;
+		ReleaseLevels( channel );
+		for ( int i = 0; i < kSlots; ++i )
+		{
+			if ( channel.fences[i] )
+				glDeleteSync( channel.fences[i] );
+		}
+		glDeleteBuffers( kSlots, channel.buffers );
+	}
+	channels_.clear();
+
+	if ( header_ )
+		UnmapViewOfFile( header_ );
+	if ( mapping_ )
+		CloseHandle( mapping_ );
+	header_ = nullptr;
+	tiles_ = nullptr;
+	pixels_ = nullptr;
+	mapping_ = NULL;
+}
@@ -0,0 +1,131 @@
+//==============================================================================
+// File:PreviewMosaic.h
+//==============================================================================
+//
+// Description: Thumbnails of every window's warped output for an instructor
+//				station. Each window is reduced on the GPU by a chain of 2:1
+//				linear blits, which average 2x2 pixels each, down to the tile
+//				size. The tile is read into a ring of pixel buffers and copied
+//				into a named shared memory mosaic once its fence has passed, so
+//				the render thread never waits. A viewer maps the mosaic as is.
+//
+//==============================================================================
+
+#ifndef DVC_PREVIEW_MOSAIC_H
+#define DVC_PREVIEW_MOSAIC_H
+
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
+#include <Windows.h>
+#include "GL/glew.h"
+
+#include "GlStateCache.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/*! Tells the mosaic from other shared memory, and its layout version. **/
+const int kPreviewMagic = 0x76725056;	/* "VPrv" */
+const int kPreviewVersion = 1;
+
+/*!
+ * Start of the shared memory block. It is followed by max_tiles PreviewTile headers, then by
+ * max_tiles images of tile_width x tile_height RGBA8 pixels, bottom row first.
+**/
+struct PreviewHeader
+{
+	int magic;						/* kPreviewMagic */
+	int version;					/* kPreviewVersion */
+	int tile_width;
+	int tile_height;
+	int max_tiles;
+	volatile LONG tile_count;		/* tiles in use, grows as windows appear */
+};
+
+/*!
+ * One window's tile. The plugin increments sequence before and after it writes the image, so
+ * it is odd while the image changes.
+**/
+struct PreviewTile
+{
+	volatile LONG sequence;
+	int window_id;
+	int window_width;				/* for the aspect ratio, the image is stretched to the tile */
+	int window_height;
+};
+
+class PreviewMosaic
+{
+public:
+	PreviewMosaic();
+	~PreviewMosaic();
+
+	/*!
+	 * @param[in] tile_width, tile_height : size of each thumbnail, 0 disables previews
+	 * @param[in] shared_memory_name : block created for the viewer, e.g. "Local\\VIOSOPreview"
+	 * @param[in] interval : frames between two captures of a window
+	**/
+	void Configure( int tile_width, int tile_height, const std::string& shared_memory_name, unsigned int interval );
+
+	bool IsEnabled() const { return tile_width_ > 0 && tile_height_ > 0; }
+
+	/*!
+	 * Copies finished thumbnails of the window into the mosaic, then queues the next one from
+	 * framebuffer, which holds the warped output. Needs the IG context.
+	**/
+	void Capture( int window_id, GLuint framebuffer, int width, int height, GlStateCache& gl_state );
+
+	/*!
+	 * Releases the GL objects and the shared memory. Needs the IG context.
+	**/
+	void Shutdown();
+
+private:
+	PreviewMosaic( const PreviewMosaic& );
+	PreviewMosaic& operator=( const PreviewMosaic& );
+
+	enum { kSlots = 3 };
+
+	/*! A reduction step, the last one has the tile size. **/
+	struct Level
+	{
+		GLuint texture;
+		GLuint framebuffer;
+		int width;
+		int height;
+	};
+
+	struct Channel
+	{
+		int tile;					/* index in the mosaic */
+		int width;					/* of the window the levels were built for */
+		int height;
+		std::vector<Level> levels;
+		GLuint buffers[kSlots];		/* pixel pack buffers, one tile each */
+		GLsync fences[kSlots];		/* set while the slot's read is on its way */
+		unsigned int next_slot;
+		unsigned int oldest_slot;
+		unsigned int frames;		/* since the first capture, for the interval */
+	};
+
+	bool Open();
+	Channel* GetChannel( int window_id );
+	void BuildLevels( Channel& channel, GLuint framebuffer, int width, int height, GlStateCache& gl_state );
+	static void ReleaseLevels( Channel& channel );
+
+	int tile_width_;
+	int tile_height_;
+	std::string shared_memory_name_;
+	unsigned int interval_;
+
+	HANDLE mapping_;
+	PreviewHeader* header_;			/* null until the block is created */
+	PreviewTile* tiles_;
+	unsigned char* pixels_;
+	bool open_failed_;				/* reported once, previews are off then */
+
+	std::map<int, Channel> channels_;
+};
+
+#endif // DVC_PREVIEW_MOSAIC_H
@@ -0,0 +1,131 @@
+//==============================================================================
+// File:ResolutionController.cpp
+//==============================================================================
+
+#include "ResolutionController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	const size_t kFramesInFlight = 4;	// timestamps are read back this many frames later
+	const double kHeadroom = 0.95;		// aim a little below the target, frame times are noisy
+	const double kGain = 0.3;			// share of the correction applied per frame
+	const double kMinStep = 0.02;		// smaller corrections are not worth a new viewport
+}
+
+ResolutionController::ResolutionController()
+	: target_ms_( 0.0f )
+	, min_scale_( 1.0f )
+	, max_scale_( 1.0f )
+	, scale_( 1.0f )
+	, current_( 0 )
+	, recording_( false )
+{
+}
+
+void ResolutionController::Configure( float target_ms, float min_scale, float max_scale )
+{
+	target_ms_ = std::max( target_ms, 0.0f );
+	max_scale_ = std::min( std::max( max_scale, 0.25f ), 1.0f );
+	min_scale_ = std::min( std::max( min_scale, 0.25f ), max_scale_ );
+	scale_ = max_scale_;
+	if ( IsEnabled() )
+		std::cout << "Info: dynamic resolution holds " << target_ms_ << " ms of GPU time per frame, scale "
+			<< min_scale_ << " to " << max_scale_ << "." << std::endl;
+}
+
+void ResolutionController::BeginFrame()
+{
+	if ( !IsEnabled() )
+		return;
+
+	if ( frames_.empty() )
+	{
+		frames_.resize( kFramesInFlight );
+		for ( size_t i = 0; i < frames_.size(); ++i )
+			frames_[i].used = 0;
+	}
+	current_ = ( current_ + 1 ) % frames_.size();
+
+	// the slot comes around again: its frame should be done by now, never wait for it
+	Frame& frame = frames_[current_];
+	recording_ = true;
+	if ( frame.used > 0 )
+	{
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv( frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available );
+		if ( GL_FALSE == available )
+		{
+			recording_ = false;
+			return;
+		}
+
+		GLuint64 total_ns = 0;
+		for ( size_t i = 0; i + 1 < frame.used; i += 2 )
+		{
+			GLuint64 begin = 0;
+			GLuint64 end = 0;
+			glGetQueryObjectui64v( frame.queries[i], GL_QUERY_RESULT, &begin );
+			glGetQueryObjectui64v( frame.queries[i + 1], GL_QUERY_RESULT, &end );
+			total_ns += end > begin ? end - begin : 0;
+		}
+		frame.used = 0;
+		Adjust( total_ns / 1000000.0 );
+	}
+}
+
+void ResolutionController::BeginWindow()
+{
+	if ( !IsEnabled() || !recording_ )
+		return;
+
+	Frame& frame = frames_[current_];
+	if ( frame.queries.size() < frame.used + 2 )
+	{
+		frame.queries.resize( frame.used + 2, 0 );
+		glGenQueries( 2, &frame.queries[frame.used] );
+	}
+	glQueryCounter( frame.queries[frame.used], GL_TIMESTAMP );
+}
+
+void ResolutionController::EndWindow()
+{
+	if ( !IsEnabled() || !recording_ )
+		return;
+
+	Frame& frame = frames_[current_];
+	if ( frame.queries.size() < frame.used + 2 )
+		return;
+	glQueryCounter( frame.queries[frame.used + 1], GL_TIMESTAMP );
+	frame.used += 2;
+}
+
+void ResolutionController::Adjust( double gpu_ms )
+{
+	if ( gpu_ms <= 0.0 )
+		return;
+
+	// the scene's fill cost follows its pixel count, the square of the scale
+	const double desired = std::min( std::max( scale_ * std::sqrt( target_ms_ * kHeadroom / gpu_ms ), (double)min_scale_ ), (double)max_scale_ );
+	double next = scale_ + ( desired - scale_ ) * kGain;
+
+	// a bound is snapped to rather than crept up on
+	if ( ( desired == min_scale_ || desired == max_scale_ ) && std::fabs( desired - next ) < kMinStep )
+		next = desired;
+	if ( std::fabs( next - scale_ ) >= kMinStep || next == desired )
+		scale_ = (float)next;
+}
+
+void ResolutionController::Shutdown()
+{
+	for ( size_t i = 0; i < frames_.size(); ++i )
+	{
+		if ( !frames_[i].queries.empty() )
+			glDeleteQueries( (GLsizei)frames_[i].queries.size(), &frames_[i].queries[0] );
+	}
+	frames_.clear();
+	recording_ = false;
+}
@@ -0,0 +1,71 @@
+//==============================================================================
+// File:ResolutionController.h
+//==============================================================================
+//
+// Description: Closed-loop dynamic resolution. GPU timestamps around every
+//				window measure the frame's GPU time a few frames later, without
+//				stalling. The controller then moves the scene scale of all windows
+//				towards the frame time target, within configured bounds. Scene
+//				targets are allocated at the largest scale, so a new scale only
+//				changes the viewport handed to the IG.
+//
+//==============================================================================
+
+#ifndef DVC_RESOLUTION_CONTROLLER_H
+#define DVC_RESOLUTION_CONTROLLER_H
+
+#include "GL/glew.h"
+
+#include <vector>
+
+class ResolutionController
+{
+public:
+	ResolutionController();
+
+	/*!
+	 * @param[in] target_ms : GPU time per frame to hold, 0 disables the controller
+	 * @param[in] min_scale, max_scale : bounds of the scene scale, max_scale is where it starts
+	**/
+	void Configure( float target_ms, float min_scale, float max_scale );
+
+	bool IsEnabled() const { return target_ms_ > 0.0f; }
+
+	/*!
+	 * Call once at the start of a frame, before the first window. Reads the oldest finished
+	 * frame's timings and adjusts the scale. Needs the GL context.
+	**/
+	void BeginFrame();
+
+	/*! Bracket the GPU work of every window, including the warp. **/
+	void BeginWindow();
+	void EndWindow();
+
+	/*! Scene scale for the next frame, between the configured bounds. **/
+	float GetScale() const { return scale_; }
+
+	/*!
+	 * Releases all queries. Needs the GL context.
+	**/
+	void Shutdown();
+
+private:
+	/*! Timestamp pairs of one frame, begin and end of each window. **/
+	struct Frame
+	{
+		std::vector<GLuint> queries;
+		size_t used;
+	};
+
+	void Adjust( double gpu_ms );
+
+	float target_ms_;
+	float min_scale_;
+	float max_scale_;
+	float scale_;
+	std::vector<Frame> frames_;		/* ring, read back when it comes around again */
+	size_t current_;
+	bool recording_;				/* false while the current slot still waits for the GPU */
+};
+
+#endif // DVC_RESOLUTION_CONTROLLER_H
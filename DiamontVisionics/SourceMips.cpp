@@ -0,0 +1,157 @@
+//==============================================================================
+// File:SourceMips.cpp
+//==============================================================================
+
+#include "SourceMips.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	// a box over 2x2 texels of the level above, the last row and column repeated for odd sizes
+	const char* kReduceShader = R"(
+#version 430
+layout( local_size_x = 8, local_size_y = 8 ) in;
+layout( rgba16f, binding = 0 ) writeonly uniform image2D u_target;
+uniform sampler2D u_source;
+uniform ivec2 u_source_size;	// pixels of the level above that hold the source
+uniform int u_source_level;
+uniform ivec2 u_target_size;
+
+void main()
+{
+	ivec2 pixel = ivec2( gl_GlobalInvocationID.xy );
+	if ( any( greaterThanEqual( pixel, u_target_size ) ) )
+		return;
+
+	ivec2 last = u_source_size - 1;
+	ivec2 corner = pixel * 2;
+	vec4 sum = texelFetch( u_source, min( corner, last ), u_source_level )
+		+ texelFetch( u_source, min( corner + ivec2( 1, 0 ), last ), u_source_level )
+		+ texelFetch( u_source, min( corner + ivec2( 0, 1 ), last ), u_source_level )
+		+ texelFetch( u_source, min( corner + ivec2( 1, 1 ), last ), u_source_level );
+	imageStore( u_target, pixel, sum * 0.25 );
+}
+)";
+
+	// like the warp's source, 0 is left to the IG
+	const GLint kSourceUnit = 1;
+	const int kGroupSize = 8;
+
+	int HalfSize( int size )
+	{
+		return std::max( ( size + 1 ) / 2, 1 );
+	}
+}
+
+SourceMips::SourceMips()
+	: source_size_location_( -1 )
+	, source_level_location_( -1 )
+	, target_size_location_( -1 )
+	, program_ready_( false )
+	, texture_( 0 )
+	, width_( 0 )
+	, height_( 0 )
+{
+}
+
+bool SourceMips::Load( GlProgramCache& program_cache )
+{
+	Unload();
+	if ( !GLEW_VERSION_4_3 && !( GLEW_ARB_compute_shader && GLEW_ARB_shader_image_load_store ) )
+	{
+		std::cout << "Warning: the context has no compute shaders, the warp samples its source without mip levels." << std::endl;
+		return false;
+	}
+
+	reduce_.RequestCompute( program_cache, "VIOSO-Plugin source mips", kReduceShader );
+	if ( !reduce_.IsValid() && !reduce_.IsPending() )
+	{
+		Unload();
+		return false;
+	}
+	return true;
+}
+
+void SourceMips::Unload()
+{
+	reduce_.Release();
+	program_ready_ = false;
+	if ( texture_ )
+		glDeleteTextures( 1, &texture_ );
+	texture_ = 0;
+	width_ = height_ = 0;
+}
+
+bool SourceMips::IsReady()
+{
+	if ( program_ready_ )
+		return true;
+
+	reduce_.TakeReady();
+	if ( !reduce_.IsValid() )
+		return false;
+
+	glProgramUniform1iEXT( reduce_.GetId(), reduce_.GetUniform( "u_source" ), kSourceUnit );
+	source_size_location_ = reduce_.GetUniform( "u_source_size" );
+	source_level_location_ = reduce_.GetUniform( "u_source_level" );
+	target_size_location_ = reduce_.GetUniform( "u_target_size" );
+	program_ready_ = true;
+	return true;
+}
+
+GLuint SourceMips::Build( GLuint source, int width, int height, int levels, GlStateCache& gl_state )
+{
+	levels = std::min( std::max( levels, 1 ), (int)kMaxLevels );
+	UpdateTexture( HalfSize( width ), HalfSize( height ) );
+
+	gl_state.UseProgram( reduce_.GetId() );
+	int source_width = width;
+	int source_height = height;
+	for ( int level = 0; level < levels; ++level )
+	{
+		// level 0 reads the source, every other level the one above it in the chain
+		const int target_width = HalfSize( source_width );
+		const int target_height = HalfSize( source_height );
+		gl_state.BindMultiTexture2D( kSourceUnit, 0 == level ? source : texture_ );
+		glUniform2i( source_size_location_, source_width, source_height );
+		glUniform1i( source_level_location_, 0 == level ? 0 : level - 1 );
+		glUniform2i( target_size_location_, target_width, target_height );
+		glBindImageTexture( 0, texture_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F );
+		glDispatchCompute( ( target_width + kGroupSize - 1 ) / kGroupSize, ( target_height + kGroupSize - 1 ) / kGroupSize, 1 );
+		glMemoryBarrier( GL_TEXTURE_FETCH_BARRIER_BIT );
+		source_width = target_width;
+		source_height = target_height;
+	}
+
+	// the IG's state cache knows nothing of images
+	glBindImageTexture( 0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA16F );
+	return texture_;
+}
+
+void SourceMips::UpdateTexture( int width, int height )
+{
+	// only grows: a dynamically scaled source fills the lower left of every level
+	if ( texture_ && width_ >= width && height_ >= height )
+		return;
+
+	width_ = std::max( width, width_ );
+	height_ = std::max( height, height_ );
+	if ( texture_ )
+		glDeleteTextures( 1, &texture_ );
+	glGenTextures( 1, &texture_ );
+	glTextureParameteriEXT( texture_, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S    , GL_CLAMP_TO_EDGE );
+	glTextureParameteriEXT( texture_, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T    , GL_CLAMP_TO_EDGE );
+	glTextureParameteriEXT( texture_, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+	glTextureParameteriEXT( texture_, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+	glTextureParameteriEXT( texture_, GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL , kMaxLevels - 1 );
+	int level_width = width_;
+	int level_height = height_;
+	for ( int level = 0; level < kMaxLevels; ++level )
+	{
+		glTextureImage2DEXT( texture_, GL_TEXTURE_2D, level, GL_RGBA16F, level_width, level_height, 0, GL_RGBA, GL_HALF_FLOAT, nullptr );
+		level_width = HalfSize( level_width );
+		level_height = HalfSize( level_height );
+	}
+}
@@ -0,0 +1,72 @@
+//==============================================================================
+// File:SourceMips.h
+//==============================================================================
+//
+// Description: The levels below a warp source, for the parts of a channel the
+//				warp compresses. A compute pass per level averages 2x2 texels of
+//				the level above into an RGBA16F chain of its own, so the source
+//				itself needs no mip storage. Only as many levels as the warp
+//				reads are built, and only the part of each that holds the source.
+//
+//==============================================================================
+
+#ifndef DVC_SOURCE_MIPS_H
+#define DVC_SOURCE_MIPS_H
+
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
+
+class SourceMips
+{
+public:
+	/*! Levels below the source there is storage for. **/
+	enum { kMaxLevels = 6 };
+
+	SourceMips();
+
+	/*!
+	 * Needs the IG context, GL 4.3 or ARB_compute_shader and ARB_shader_image_load_store.
+	 *
+	 * @return
+	 *  false if the context cannot build the chain.
+	**/
+	bool Load( GlProgramCache& program_cache );
+	void Unload();
+
+	bool IsReady();
+
+	/*!
+	 * Builds the levels below a source. Leaves no image bound.
+	 *
+	 * @param[in] source : single-sampled color, the source in its lower left
+	 * @param[in] width, height : of the source in pixels
+	 * @param[in] levels : 1 to kMaxLevels, level 0 of the chain is half the source
+	 *
+	 * @return
+	 *  the chain, its lower left holds the levels of the source
+	**/
+	GLuint Build( GLuint source, int width, int height, int levels, GlStateCache& gl_state );
+
+	/*! Size of level 0 of the chain, it only grows. **/
+	int GetWidth() const { return width_; }
+	int GetHeight() const { return height_; }
+
+private:
+	SourceMips( const SourceMips& );
+	SourceMips& operator=( const SourceMips& );
+
+	void UpdateTexture( int width, int height );
+
+	GlProgram reduce_;
+	GLint source_size_location_;
+	GLint source_level_location_;
+	GLint target_size_location_;
+	bool program_ready_;
+
+	GLuint texture_;
+	int width_;
+	int height_;
+};
+
+#endif // DVC_SOURCE_MIPS_H
@@ -0,0 +1,179 @@
+//==============================================================================
+// File:StereoTarget.cpp
+//==============================================================================
+
+#include "StereoTarget.h"
+
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	// sized, so the layers can be viewed
+	const GLenum kColorFormat = GL_RGBA8;
+	const GLenum kDepthFormat = GL_DEPTH_COMPONENT32F;
+	const GLsizei kEyes = 2;
+
+	GLuint CreateArray( bool multisample, unsigned int samples, GLenum internal_format, unsigned int width, unsigned int height )
+	{
+		GLuint tex = 0;
+		glGenTextures( 1, &tex );
+		if ( multisample )
+		{
+			glTextureStorage3DMultisampleEXT( tex, GL_TEXTURE_2D_MULTISAMPLE_ARRAY, samples, internal_format, width, height, kEyes, GL_TRUE );
+			return tex;
+		}
+
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S    , GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T    , GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR       );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR       );
+		glTextureStorage3DEXT( tex, GL_TEXTURE_2D_ARRAY, 1, internal_format, width, height, kEyes );
+		return tex;
+	}
+
+	GLuint CreateView( bool multisample, GLuint array, GLenum internal_format, int eye )
+	{
+		GLuint view = 0;
+		glGenTextures( 1, &view );
+		glTextureView( view, multisample ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D, array, internal_format, 0, 1, eye, 1 );
+		return view;
+	}
+}
+
+StereoTarget::StereoTarget()
+	: multisample_( false )
+	, color_texture_( 0 )
+	, depth_texture_( 0 )
+	, resolve_texture_( 0 )
+{
+	for ( int eye = 0; eye < kEyes; ++eye )
+		color_views_[eye] = depth_views_[eye] = read_framebuffers_[eye] = draw_framebuffers_[eye] = 0;
+}
+
+bool StereoTarget::Load( bool multisample, unsigned int samples, unsigned int width, unsigned int height )
+{
+	Unload();
+	if ( !GLEW_VERSION_4_3 && !( GLEW_ARB_texture_view && GLEW_ARB_texture_storage_multisample ) )
+	{
+		std::cout << "Warning: the context has no texture views, stereo is off." << std::endl;
+		return false;
+	}
+
+	multisample_ = multisample;
+	color_texture_ = CreateArray( multisample, samples, kColorFormat, width, height );
+	depth_texture_ = CreateArray( multisample, samples, kDepthFormat, width, height );
+	for ( int eye = 0; eye < kEyes; ++eye )
+	{
+		color_views_[eye] = CreateView( multisample, color_texture_, kColorFormat, eye );
+		depth_views_[eye] = CreateView( multisample, depth_texture_, kDepthFormat, eye );
+	}
+
+	// the warp samples both eyes from one single-sampled array
+	if ( multisample )
+	{
+		resolve_texture_ = CreateArray( false, 0, kColorFormat, width, height );
+		glGenFramebuffers( kEyes, read_framebuffers_ );
+		glGenFramebuffers( kEyes, draw_framebuffers_ );
+		for ( int eye = 0; eye < kEyes; ++eye )
+		{
+			glNamedFramebufferTextureLayerEXT( read_framebuffers_[eye], GL_COLOR_ATTACHMENT0, color_texture_, 0, eye );
+			glNamedFramebufferTextureLayerEXT( draw_framebuffers_[eye], GL_COLOR_ATTACHMENT0, resolve_texture_, 0, eye );
+		}
+	}
+	return true;
+}
+
+void StereoTarget::Unload()
+{
+	if ( color_views_[0] )			glDeleteTextures(     kEyes, color_views_        );
+	if ( depth_views_[0] )			glDeleteTextures(     kEyes, depth_views_        );
+	if ( color_texture_ )			glDeleteTextures(     1,     &color_texture_     );
+	if ( depth_texture_ )			glDeleteTextures(     1,     &depth_texture_     );
+	if ( resolve_texture_ )			glDeleteTextures(     1,     &resolve_texture_   );
+	if ( read_framebuffers_[0] )	glDeleteFramebuffers( kEyes, read_framebuffers_  );
+	if ( draw_framebuffers_[0] )	glDeleteFramebuffers( kEyes, draw_framebuffers_  );
+
+	color_texture_ = depth_texture_ = resolve_texture_ = 0;
+	for ( int eye = 0; eye < kEyes; ++eye )
+		color_views_[eye] = depth_views_[eye] = read_framebuffers_[eye] = draw_framebuffers_[eye] = 0;
+}
+
+void StereoTarget::AttachEye( GLuint framebuffer, int eye ) const
+{
+	glNamedFramebufferTextureEXT( framebuffer, GL_COLOR_ATTACHMENT0, color_views_[eye], 0 );
+	glNamedFramebufferTextureEXT( framebuffer, GL_DEPTH_ATTACHMENT , depth_views_[eye], 0 );
+}
+
+GLuint StereoTarget::Resolve( int width, int height, GlStateCache& gl_state )
+{
+	if ( !multisample_ )
+		return color_texture_;
+
+	gl_state.Disable( GL_SCISSOR_TEST );
+	for ( int eye = 0; eye < kEyes; ++eye )
+	{
+		gl_state.BindFramebuffer( read_framebuffers_[eye] );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, draw_framebuffers_[eye] );
+		glBlitFramebuffer( 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+	}
+	return resolve_texture_;
+}
+
+float StereoTarget::GetEyeOffset( const StereoSettings& settings, int eye )
+{
+	return ( 0 == eye ? -0.5f : 0.5f ) * settings.eye_separation;
+}
+
+void StereoTarget::GetEyeView( const StereoSettings& settings, int eye, const float view[16], float eye_view[16] )
+{
+	// moved along the view's own x axis: the world shifts the other way
+	const float offset = GetEyeOffset( settings, eye );
+	for ( int column = 0; column < 4; ++column )
+	{
+		for ( int row = 0; row < 4; ++row )
+			eye_view[column * 4 + row] = view[column * 4 + row];
+		eye_view[column * 4 + 0] -= offset * view[column * 4 + 3];
+	}
+}
+
+void StereoTarget::GetEyeFrustum( const StereoSettings& settings, int eye, const FrustumParameters& channel, FrustumParameters& frustum )
+{
+	// points on the convergence plane keep their place in the channel
+	const double to_radians = 3.14159265358979 / 180.0;
+	const double shift = -GetEyeOffset( settings, eye ) / settings.convergence;
+	frustum = channel;
+	frustum.left_degrees = (float)( std::atan( std::tan( channel.left_degrees * to_radians ) + shift ) / to_radians );
+	frustum.right_degrees = (float)( std::atan( std::tan( channel.right_degrees * to_radians ) + shift ) / to_radians );
+}
+
+void StereoTarget::GetEyeViewProj( const StereoSettings& settings, int eye, const float proj[16], const float view[16], float eye_view_proj[16] )
+{
+	float eye_view[16];
+	GetEyeView( settings, eye, view, eye_view );
+	for ( int column = 0; column < 4; ++column )
+	{
+		for ( int row = 0; row < 4; ++row )
+		{
+			float sum = 0.0f;
+			for ( int k = 0; k < 4; ++k )
+				sum += proj[k * 4 + row] * eye_view[column * 4 + k];
+			eye_view_proj[column * 4 + row] = sum;
+		}
+	}
+
+	// the frustum shift of GetEyeFrustum in clip space, x moves by a multiple of w; proj[0] is 2 / width in tangents
+	const float shift = -GetEyeOffset( settings, eye ) / settings.convergence * proj[0];
+	for ( int column = 0; column < 4; ++column )
+		eye_view_proj[column * 4 + 0] -= shift * eye_view_proj[column * 4 + 3];
+}
+
+void StereoTarget::GetEyeRect( StereoLayout layout, int eye, float rect[4] )
+{
+	const bool top_bottom = STEREO_TOP_BOTTOM == layout;
+	rect[0] = !top_bottom && 1 == eye ? 0.5f : 0.0f;
+	rect[1] = top_bottom && 0 == eye ? 0.5f : 0.0f;
+	rect[2] = top_bottom ? 1.0f : 0.5f;
+	rect[3] = top_bottom ? 0.5f : 1.0f;
+}
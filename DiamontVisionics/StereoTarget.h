@@ -0,0 +1,87 @@
+//==============================================================================
+// File:StereoTarget.h
+//==============================================================================
+//
+// Description: The scene target of a stereo window: color and depth as two
+//				layer texture arrays, layer 0 the left eye. The IG only knows 2D
+//				render targets, so every layer is also a texture view, and the
+//				view of the eye a window view renders is attached to the IG's
+//				framebuffer before it draws. The eyes are offset from the
+//				warper's eye point along its x axis, with frusta that meet on the
+//				convergence plane, where the channel's warp maps hold for both.
+//
+//==============================================================================
+
+#ifndef DVC_STEREO_TARGET_H
+#define DVC_STEREO_TARGET_H
+
+#include "ExternalFbo.h"
+#include "GlStateCache.h"
+
+class StereoTarget
+{
+public:
+	StereoTarget();
+
+	/*!
+	 * Allocates both layers. Needs GL 4.3 or ARB_texture_view and ARB_texture_storage_multisample.
+	 *
+	 * @return
+	 *  false if the context cannot view a layer as a 2D texture
+	**/
+	bool Load( bool multisample, unsigned int samples, unsigned int width, unsigned int height );
+	void Unload();
+
+	/*! The arrays, attached layered. **/
+	GLuint GetColorTexture() const { return color_texture_; }
+	GLuint GetDepthTexture() const { return depth_texture_; }
+
+	/*! An eye's layer as a 2D texture, GL_TEXTURE_2D_MULTISAMPLE if multisampled. **/
+	GLuint GetColorView( int eye ) const { return color_views_[eye]; }
+	GLuint GetDepthView( int eye ) const { return depth_views_[eye]; }
+
+	/*! Makes framebuffer render into an eye's layers. **/
+	void AttachEye( GLuint framebuffer, int eye ) const;
+
+	/*!
+	 * @param[in] width, height : the part of each layer the IG rendered, from the lower left
+	 *
+	 * @return
+	 *  both eyes in a single-sampled array, resolved first if multisampled
+	**/
+	GLuint Resolve( int width, int height, GlStateCache& gl_state );
+
+	/*! The view of an eye, column-major. **/
+	static void GetEyeView( const StereoSettings& settings, int eye, const float view[16], float eye_view[16] );
+
+	/*! The frustum of an eye, shifted so both meet on the convergence plane. **/
+	static void GetEyeFrustum( const StereoSettings& settings, int eye, const FrustumParameters& channel, FrustumParameters& frustum );
+
+	/*!
+	 * projection * view of an eye, column-major.
+	 *
+	 * @param[in] proj, view : of the channel, column-major
+	**/
+	static void GetEyeViewProj( const StereoSettings& settings, int eye, const float proj[16], const float view[16], float eye_view_proj[16] );
+
+	/*! x, y, width and height of an eye in the window, 0-1 from the lower left. **/
+	static void GetEyeRect( StereoLayout layout, int eye, float rect[4] );
+
+private:
+	StereoTarget( const StereoTarget& );
+	StereoTarget& operator=( const StereoTarget& );
+
+	/*! Offset of an eye from the eye point, along the view's x axis. **/
+	static float GetEyeOffset( const StereoSettings& settings, int eye );
+
+	bool multisample_;
+	GLuint color_texture_;
+	GLuint depth_texture_;
+	GLuint color_views_[2];
+	GLuint depth_views_[2];
+	GLuint resolve_texture_;		/* single-sampled array of a multisampled target */
+	GLuint read_framebuffers_[2];	/* an eye's multisampled layer */
+	GLuint draw_framebuffers_[2];	/* and its resolved layer */
+};
+
+#endif // DVC_STEREO_TARGET_H
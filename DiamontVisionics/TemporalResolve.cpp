@@ -0,0 +1,235 @@
+//==============================================================================
+// File:TemporalResolve.cpp
+//==============================================================================
+
+#include "TemporalResolve.h"
+
+#include <algorithm>
+
+namespace
+{
+	const char* kVertexShader = R"(
+#version 330 core
+void main()
+{
+	vec2 corner = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );
+	gl_Position = vec4( corner * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+	// the history is clipped towards the neighbourhood's mean in YCoCg, which keeps its hue
+	const char* kFragmentShader = R"(
+#version 330 core
+uniform sampler2D u_scene;
+uniform sampler2D u_history;
+uniform float u_feedback;
+uniform ivec2 u_last;		// last pixel of the scene, which may fill only part of its texture
+out vec4 frag_color;
+
+vec3 ToYCoCg( vec3 c )
+{
+	return vec3( 0.25 * c.r + 0.5 * c.g + 0.25 * c.b, 0.5 * c.r - 0.5 * c.b, -0.25 * c.r + 0.5 * c.g - 0.25 * c.b );
+}
+
+vec3 FromYCoCg( vec3 c )
+{
+	return vec3( c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z );
+}
+
+void main()
+{
+	ivec2 pixel = ivec2( gl_FragCoord.xy );
+	vec3 current = ToYCoCg( texelFetch( u_scene, pixel, 0 ).rgb );
+	vec3 lo = current;
+	vec3 hi = current;
+	for ( int y = -1; y <= 1; ++y )
+	{
+		for ( int x = -1; x <= 1; ++x )
+		{
+			vec3 c = ToYCoCg( texelFetch( u_scene, clamp( pixel + ivec2( x, y ), ivec2( 0 ), u_last ), 0 ).rgb );
+			lo = min( lo, c );
+			hi = max( hi, c );
+		}
+	}
+
+	vec3 history = ToYCoCg( texelFetch( u_history, pixel, 0 ).rgb );
+	vec3 center = 0.5 * ( lo + hi );
+	vec3 extent = max( 0.5 * ( hi - lo ), vec3( 1.0 / 1024.0 ) );
+	vec3 offset = history - center;
+	vec3 units = abs( offset / extent );
+	float outside = max( units.x, max( units.y, units.z ) );
+	if ( outside > 1.0 )
+		history = center + offset / outside;
+
+	frag_color = vec4( FromYCoCg( mix( current, history, u_feedback ) ), 1.0 );
+}
+)";
+
+	// units 1 and 2, like the warp's source and map; 0 is left to the IG
+	const GLint kSceneUnit = 1;
+	const GLint kHistoryUnit = 2;
+
+	float Halton( unsigned int index, unsigned int base )
+	{
+		float result = 0.0f;
+		float fraction = 1.0f;
+		for ( ; index > 0; index /= base )
+		{
+			fraction /= base;
+			result += fraction * ( index % base );
+		}
+		return result;
+	}
+}
+
+TemporalResolve::TemporalResolve()
+	: feedback_location_( -1 )
+	, last_location_( -1 )
+	, program_ready_( false )
+	, vertex_array_( 0 )
+	, current_( 0 )
+	, history_width_( 0 )
+	, history_height_( 0 )
+	, resolved_width_( 0 )
+	, resolved_height_( 0 )
+	, history_valid_( false )
+	, feedback_( 0.9f )
+	, warp_history_( 0 )
+	, warp_history_width_( 0 )
+	, warp_history_height_( 0 )
+	, warp_history_valid_( false )
+{
+	history_textures_[0] = history_textures_[1] = 0;
+	history_framebuffers_[0] = history_framebuffers_[1] = 0;
+}
+
+bool TemporalResolve::Load( GlProgramCache& program_cache, float feedback )
+{
+	Unload();
+	feedback_ = std::min( std::max( feedback, 0.0f ), 0.98f );
+	program_.Request( program_cache, "VIOSO-Plugin temporal resolve", kVertexShader, kFragmentShader );
+	glGenVertexArrays( 1, &vertex_array_ );
+	return program_.IsValid() || program_.IsPending();
+}
+
+void TemporalResolve::Unload()
+{
+	program_.Release();
+	program_ready_ = false;
+	if ( vertex_array_ )			glDeleteVertexArrays( 1, &vertex_array_ );
+	if ( history_framebuffers_[0] )	glDeleteFramebuffers( 2, history_framebuffers_ );
+	if ( history_textures_[0] )		glDeleteTextures(     2, history_textures_     );
+	if ( warp_history_ )			glDeleteTextures(     1, &warp_history_        );
+
+	vertex_array_ = 0;
+	history_textures_[0] = history_textures_[1] = 0;
+	history_framebuffers_[0] = history_framebuffers_[1] = 0;
+	history_width_ = history_height_ = 0;
+	resolved_width_ = resolved_height_ = 0;
+	history_valid_ = false;
+	warp_history_ = 0;
+	warp_history_width_ = warp_history_height_ = 0;
+	warp_history_valid_ = false;
+}
+
+bool TemporalResolve::IsReady()
+{
+	if ( program_ready_ )
+		return true;
+
+	program_.TakeReady();
+	if ( !program_.IsValid() )
+		return false;
+
+	glProgramUniform1iEXT( program_.GetId(), program_.GetUniform( "u_scene" ), kSceneUnit );
+	glProgramUniform1iEXT( program_.GetId(), program_.GetUniform( "u_history" ), kHistoryUnit );
+	feedback_location_ = program_.GetUniform( "u_feedback" );
+	last_location_ = program_.GetUniform( "u_last" );
+	program_ready_ = true;
+	return true;
+}
+
+GLuint TemporalResolve::Resolve( GLuint scene_texture, int width, int height, GlStateCache& gl_state )
+{
+	UpdateHistory( width, height );
+	const int previous = current_;
+	current_ = 1 - current_;
+
+	gl_state.BindFramebuffer( history_framebuffers_[current_] );
+	gl_state.Viewport( 0, 0, width, height );
+	gl_state.Disable( GL_SCISSOR_TEST );
+	gl_state.Disable( GL_DEPTH_TEST );
+	gl_state.Disable( GL_BLEND );
+	gl_state.Disable( GL_CULL_FACE );
+	gl_state.Disable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
+	gl_state.UseProgram( program_.GetId() );
+	gl_state.BindVertexArray( vertex_array_ );
+	gl_state.BindMultiTexture2D( kSceneUnit, scene_texture );
+	gl_state.BindMultiTexture2D( kHistoryUnit, history_textures_[previous] );
+
+	glUniform1f( feedback_location_, history_valid_ ? feedback_ : 0.0f );
+	glUniform2i( last_location_, width - 1, height - 1 );
+	glDrawArrays( GL_TRIANGLES, 0, 3 );
+	history_valid_ = true;
+	return history_textures_[current_];
+}
+
+void TemporalResolve::UpdateHistory( int width, int height )
+{
+	// a rescaled scene no longer lines up with the history
+	if ( resolved_width_ != width || resolved_height_ != height )
+		history_valid_ = false;
+	resolved_width_ = width;
+	resolved_height_ = height;
+
+	// only grows: a dynamically scaled scene is resolved into the lower left
+	if ( history_textures_[0] && history_width_ >= width && history_height_ >= height )
+		return;
+
+	width = std::max( width, history_width_ );
+	height = std::max( height, history_height_ );
+
+	if ( 0 == history_textures_[0] )
+	{
+		glGenTextures( 2, history_textures_ );
+		glGenFramebuffers( 2, history_framebuffers_ );
+	}
+	for ( int i = 0; i < 2; ++i )
+	{
+		glTextureParameteriEXT( history_textures_[i], GL_TEXTURE_2D, GL_TEXTURE_WRAP_S    , GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( history_textures_[i], GL_TEXTURE_2D, GL_TEXTURE_WRAP_T    , GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( history_textures_[i], GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR       );
+		glTextureParameteriEXT( history_textures_[i], GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR       );
+		glTextureImage2DEXT( history_textures_[i], GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+		glNamedFramebufferTextureEXT( history_framebuffers_[i], GL_COLOR_ATTACHMENT0, history_textures_[i], 0 );
+	}
+	history_width_ = width;
+	history_height_ = height;
+	history_valid_ = false;
+}
+
+void TemporalResolve::GetWarpSource( int width, int height, TemporalSource& source )
+{
+	if ( warp_history_width_ != width || warp_history_height_ != height )
+	{
+		// immutable, an image binding needs a fixed format
+		if ( warp_history_ )
+			glDeleteTextures( 1, &warp_history_ );
+		glGenTextures( 1, &warp_history_ );
+		glTextureStorage2DEXT( warp_history_, GL_TEXTURE_2D, 1, GL_RGBA8, width, height );
+		warp_history_width_ = width;
+		warp_history_height_ = height;
+		warp_history_valid_ = false;
+	}
+	source.history = warp_history_;
+	source.feedback = warp_history_valid_ ? feedback_ : 0.0f;
+	warp_history_valid_ = true;
+}
+
+void TemporalResolve::GetJitter( unsigned int frame, float offset[2] )
+{
+	// 1-based: index 0 would be the unjittered corner of both sequences
+	const unsigned int index = frame % 8 + 1;
+	offset[0] = Halton( index, 2 ) - 0.5f;
+	offset[1] = Halton( index, 3 ) - 0.5f;
+}
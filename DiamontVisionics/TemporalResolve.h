@@ -0,0 +1,97 @@
+//==============================================================================
+// File:TemporalResolve.h
+//==============================================================================
+//
+// Description: Temporal anti-aliasing for a single-sampled scene whose
+//				projection is jittered by a sub-pixel offset every frame. Each
+//				frame is blended into a per-window history, and the history is
+//				clamped to the current frame's 3x3 neighbourhood so moving edges
+//				do not ghost. Where the plugin warps the channel itself, the warp
+//				does this as it samples the scene, into a history at the window's
+//				size, see GetWarpSource. The resolve pass here serves the rest:
+//				VWB_render, cube faces, and stereo and foveated scenes.
+//
+//==============================================================================
+
+#ifndef DVC_TEMPORAL_RESOLVE_H
+#define DVC_TEMPORAL_RESOLVE_H
+
+#include "ExternalFbo.h"
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
+
+class TemporalResolve
+{
+public:
+	TemporalResolve();
+
+	/*!
+	 * Needs the IG context.
+	 *
+	 * @param[in] feedback : share of the history in each resolved pixel, 0-0.98
+	**/
+	bool Load( GlProgramCache& program_cache, float feedback );
+	void Unload();
+
+	/*! The next resolve starts over from the current frame, e.g. after a recalibration. **/
+	void Reset() { history_valid_ = false; warp_history_valid_ = false; }
+
+	bool IsReady();
+
+	/*!
+	 * Blends the scene into the history.
+	 *
+	 * @param[in] scene_texture : single-sampled color of the jittered scene
+	 *
+	 * @return
+	 *  the resolved texture, valid until the next Resolve. GetFramebuffer() has it attached.
+	 *  It may be larger than width x height, the image is in its lower left.
+	**/
+	GLuint Resolve( GLuint scene_texture, int width, int height, GlStateCache& gl_state );
+
+	/*! The framebuffer of the last resolve. **/
+	GLuint GetFramebuffer() const { return history_framebuffers_[current_]; }
+
+	/*!
+	 * The history for a warp that resolves the scene itself, at the size of its target, which
+	 * it keeps valid for the next frame. Resized, it starts over.
+	**/
+	void GetWarpSource( int width, int height, TemporalSource& source );
+
+	/*!
+	 * Sub-pixel offset of the scene for a frame, Halton (2, 3) over 8 frames.
+	 *
+	 * @param[out] offset : x and y in pixels, within +-0.5
+	**/
+	static void GetJitter( unsigned int frame, float offset[2] );
+
+private:
+	TemporalResolve( const TemporalResolve& );
+	TemporalResolve& operator=( const TemporalResolve& );
+
+	void UpdateHistory( int width, int height );
+
+	GlProgram program_;
+	GLint feedback_location_;
+	GLint last_location_;
+	bool program_ready_;
+	GLuint vertex_array_;
+
+	GLuint history_textures_[2];	/* ping-pong: one is read while the other is written */
+	GLuint history_framebuffers_[2];
+	int current_;					/* index of the last resolved history */
+	int history_width_;
+	int history_height_;
+	int resolved_width_;			/* part of the history the last resolve wrote */
+	int resolved_height_;
+	bool history_valid_;
+	float feedback_;
+
+	GLuint warp_history_;			/* of GetWarpSource, in the warp's target pixels */
+	int warp_history_width_;
+	int warp_history_height_;
+	bool warp_history_valid_;
+};
+
+#endif // DVC_TEMPORAL_RESOLVE_H
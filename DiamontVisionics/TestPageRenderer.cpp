@@ -0,0 +1,289 @@
+//==============================================================================
+// File:TestPageRenderer.cpp
+//==============================================================================
+
+#include "TestPageRenderer.h"
+
+#include <cmath>
+#include <iostream>
+
+using namespace dvc::IgInterface;
+
+namespace
+{
+	// full screen triangle, no vertex data
+	const char* kVertexShader = R"(
+#version 330 core
+void main()
+{
+	vec2 corner = vec2( ( gl_VertexID << 1 ) & 2, gl_VertexID & 2 );
+	gl_Position = vec4( corner * 2.0 - 1.0, 0.0, 1.0 );
+}
+)";
+
+	// page and modifier numbers follow the enums in IgInterface.h
+	const char* kFragmentShader = R"(
+#version 330 core
+uniform int u_page;
+uniform int u_modifier;
+uniform vec2 u_size;
+uniform vec4 u_tangents;	// left, right, bottom, top
+uniform mat4 u_view;
+uniform vec2 u_offset;		// yaw, pitch in degrees
+uniform float u_res_size;	// resolution target size in pixels
+out vec4 frag_color;
+
+// anti-aliased line of the given pixel width at every multiple of spacing
+float Line( float v, float spacing, float width )
+{
+	float d = abs( v - spacing * floor( v / spacing + 0.5 ) );
+	float w = fwidth( v );
+	return 1.0 - smoothstep( 0.5 * width * w, ( 0.5 * width + 1.0 ) * w, d );
+}
+
+float Grid( vec2 v, float spacing, float width )
+{
+	return max( Line( v.x, spacing, width ), Line( v.y, spacing, width ) );
+}
+
+float Dot( vec2 v, vec2 center, float radius )
+{
+	float d = length( v - center );
+	float w = length( fwidth( v ) );
+	return 1.0 - smoothstep( radius, radius + w, d );
+}
+
+float Box( vec2 v, vec2 lo, vec2 hi )
+{
+	return step( lo.x, v.x ) * step( lo.y, v.y ) * step( v.x, hi.x ) * step( v.y, hi.y );
+}
+
+// world space yaw and pitch of this pixel in degrees, animated
+vec2 Angles( vec2 uv )
+{
+	vec3 dir = normalize( vec3( mix( u_tangents.x, u_tangents.y, uv.x ), mix( u_tangents.z, u_tangents.w, uv.y ), -1.0 ) );
+	dir = dir * mat3( u_view );	// transposed rotation: view to world
+	return vec2( degrees( atan( dir.x, -dir.z ) ), degrees( asin( clamp( dir.y, -1.0, 1.0 ) ) ) ) + u_offset;
+}
+
+vec3 Sphere( vec2 a )
+{
+	float grid = Grid( a, 10.0, 2.0 );
+	vec2 lattice = floor( a + 0.5 );
+	float lattice_dot = Dot( a, lattice, 0.1 );
+	vec2 cell = floor( a / 5.0 );
+	float checker = mod( cell.x + cell.y, 2.0 ) < 0.5 ? 1.0 : 0.0;
+
+	if ( 1 == u_modifier )		// HIGHLIGHTING_ON
+		return mix( vec3( grid ), vec3( 1.0, 0.0, 0.0 ), max( Line( a.x, 360.0, 3.0 ), Line( a.y, 360.0, 3.0 ) ) );
+	if ( 2 == u_modifier )		// LINE_OF_CENTER_DOTS
+		return vec3( max( grid, lattice_dot * step( abs( a.y ), 0.5 ) ) );
+	if ( 3 == u_modifier )		// BOX_OF_CENTER_DOTS
+		return vec3( max( grid, lattice_dot * Box( a, vec2( -5.5 ), vec2( 5.5 ) ) ) );
+	if ( 4 == u_modifier )		// ONE_DEGREE_LINES
+		return vec3( Grid( a, 1.0, 1.0 ) );
+	if ( 5 == u_modifier )		// ONE_DEGREE_LINES_BLACK
+		return vec3( 1.0 - Grid( a, 1.0, 1.0 ) );
+	if ( 6 == u_modifier || 7 == u_modifier )	// ONE_DEGREE_ANGLED_LINES(_BLACK)
+	{
+		float lines = max( Line( a.x + a.y, 1.0, 1.0 ), Line( a.x - a.y, 1.0, 1.0 ) );
+		return vec3( 6 == u_modifier ? lines : 1.0 - lines );
+	}
+	if ( 8 == u_modifier )		// ONE_DEGREE_POINTS
+		return vec3( lattice_dot );
+	if ( 9 == u_modifier )		// ONE_DEGREE_POINTS_BLACK
+		return vec3( 1.0 - lattice_dot );
+	if ( 10 == u_modifier )		// CHECKERBOARD_WHITE_CENTER
+		return vec3( 1.0 - checker );
+	if ( 11 == u_modifier )		// CHECKERBOARD_WITH_DOTS
+		return vec3( abs( checker - Dot( a, ( cell + 0.5 ) * 5.0, 0.5 ) ) );
+	if ( 12 == u_modifier || 13 == u_modifier )	// SMEAR_TEST_THIN/THICK, a bar moving with the yaw rate
+	{
+		float half_width = 12 == u_modifier ? 0.05 : 0.5;
+		return vec3( step( abs( a.x - 360.0 * floor( a.x / 360.0 + 0.5 ) ), half_width ) );
+	}
+	return vec3( grid );		// HIGHLIGHTING_OFF
+}
+
+vec3 Cylinder( vec2 a )
+{
+	// vertical lines every 10 degrees, horizontal lines equally spaced on the cylinder wall
+	float lines = max( Line( a.x, 10.0, 2.0 ), Line( tan( radians( clamp( a.y, -80.0, 80.0 ) ) ), 0.1, 2.0 ) );
+	vec3 background = vec3( 1 == u_modifier ? 0.25 : 0.0 );	// CYLINDER_BACKGROUND_ON
+	return mix( background, vec3( 1.0 ), lines );
+}
+
+vec3 Resolution( vec2 p )
+{
+	vec2 center = vec2( 0.5 );
+	if ( 1 == u_modifier ) center = vec2( 0.15, 0.85 );			// RES_UPPER_LEFT
+	else if ( 2 == u_modifier ) center = vec2( 0.85, 0.85 );	// RES_UPPER_RIGHT
+	else if ( 3 == u_modifier ) center = vec2( 0.85, 0.15 );	// RES_LOWER_RIGHT
+	else if ( 4 == u_modifier ) center = vec2( 0.15, 0.15 );	// RES_LOWER_LEFT
+
+	// four quadrants: 1 and 2 pixel line pairs, horizontal and vertical
+	vec2 local = ( p - floor( center * u_size ) ) / u_res_size + 0.5;
+	if ( any( lessThan( local, vec2( 0.0 ) ) ) || any( greaterThanEqual( local, vec2( 1.0 ) ) ) )
+		return vec3( 0.5 );
+	vec2 quadrant = floor( local * 2.0 );
+	float period = quadrant.y < 0.5 ? 2.0 : 4.0;
+	float v = quadrant.x < 0.5 ? p.y : p.x;
+	return vec3( mod( floor( v / ( 0.5 * period ) ), 2.0 ) );
+}
+
+vec3 ColorBlock( vec2 uv )
+{
+	const vec3 bars[8] = vec3[8]( vec3( 1, 1, 1 ), vec3( 1, 1, 0 ), vec3( 0, 1, 1 ), vec3( 0, 1, 0 ),
+		vec3( 1, 0, 1 ), vec3( 1, 0, 0 ), vec3( 0, 0, 1 ), vec3( 0, 0, 0 ) );
+	return bars[ clamp( int( uv.x * 8.0 ), 0, 7 ) ];
+}
+
+void main()
+{
+	vec2 p = gl_FragCoord.xy;
+	vec2 uv = p / u_size;
+	vec3 color = vec3( 0.0 );
+
+	if ( 0 == u_page )			// GREYSCALE_FIELD, eleven steps
+		color = vec3( floor( uv.x * 11.0 ) / 10.0 );
+	else if ( 1 == u_page )		// UNIFORM_FIELD
+		color = vec3( 1 == u_modifier ? 0.7 : 1.0 );
+	else if ( 2 == u_page )		// SPHERE_PATTERN
+		color = Sphere( Angles( uv ) );
+	else if ( 3 == u_page )		// LINEAR_CROSSHATCH, 16 columns and square cells
+		color = vec3( max( Grid( p - 0.5, u_size.x / 16.0, 1.0 ), 1.0 - Box( p, vec2( 1.0 ), u_size - 1.0 ) ) );
+	else if ( 4 == u_page )		// GREYSCALE_PATTERN, black at the modifier's edge
+	{
+		float ramp[4] = float[4]( uv.y, uv.x, 1.0 - uv.y, 1.0 - uv.x );
+		color = vec3( ramp[ clamp( u_modifier, 0, 3 ) ] );
+	}
+	else if ( 5 == u_page )		// NINE_WHITE_SQUARES
+	{
+		vec2 cell = fract( uv * 3.0 );
+		color = vec3( Box( cell, vec2( 1.0 / 3.0 ), vec2( 2.0 / 3.0 ) ) );
+	}
+	else if ( 6 == u_page )		// WHITE_RECTANGLES along the edges
+		color = vec3( 1.0 - Box( uv, vec2( 0.1 ), vec2( 0.9 ) ) );
+	else if ( 7 == u_page )		// BLACK_SQUARE
+		color = vec3( 1.0 - Box( uv, vec2( 1.0 / 3.0 ), vec2( 2.0 / 3.0 ) ) );
+	else if ( 8 == u_page )		// PEAK_WHITE_RECTANGLE
+		color = vec3( Box( uv, vec2( 1.0 / 3.0 ), vec2( 2.0 / 3.0 ) ) );
+	else if ( 9 == u_page )		// CHECKERBOARD, 4 x 4
+	{
+		vec2 cell = floor( uv * 4.0 );
+		color = vec3( mod( cell.x + cell.y, 2.0 ) );
+	}
+	else if ( 10 == u_page )	// RESOLUTION
+		color = Resolution( p );
+	else if ( 11 == u_page )	// COLOR_BLOCK
+		color = ColorBlock( uv );
+	else if ( 12 == u_page )	// CYLINDRICAL_PATTERN
+		color = Cylinder( Angles( uv ) );
+	else if ( 13 == u_page )	// GRID_LINES_TEXTURE
+		color = mix( vec3( 0.5 ), vec3( 1.0 ), max( Grid( p - 0.5, 16.0, 1.0 ) * 0.5, Grid( p - 0.5, 128.0, 2.0 ) ) );
+
+	frag_color = vec4( color, 1.0 );
+}
+)";
+}
+
+TestPageRenderer::TestPageRenderer()
+	: yaw_offset_( 0.0f )
+	, pitch_offset_( 0.0f )
+	, vertex_array_( 0 )
+	, page_location_( -1 )
+	, modifier_location_( -1 )
+	, size_location_( -1 )
+	, tangents_location_( -1 )
+	, view_location_( -1 )
+	, offset_location_( -1 )
+	, res_size_location_( -1 )
+{
+}
+
+bool TestPageRenderer::Initialize( GlProgramCache& program_cache )
+{
+	program_.Request( program_cache, "VIOSO-Plugin test page", kVertexShader, kFragmentShader );
+	if ( !program_.IsValid() && !program_.IsPending() )
+		return false;
+
+	if ( program_.IsValid() )
+		LookUpUniforms();
+	glGenVertexArrays( 1, &vertex_array_ );
+	return true;
+}
+
+void TestPageRenderer::LookUpUniforms()
+{
+	page_location_ = program_.GetUniform( "u_page" );
+	modifier_location_ = program_.GetUniform( "u_modifier" );
+	size_location_ = program_.GetUniform( "u_size" );
+	tangents_location_ = program_.GetUniform( "u_tangents" );
+	view_location_ = program_.GetUniform( "u_view" );
+	offset_location_ = program_.GetUniform( "u_offset" );
+	res_size_location_ = program_.GetUniform( "u_res_size" );
+}
+
+void TestPageRenderer::Shutdown()
+{
+	program_.Release();
+	if ( vertex_array_ )
+		glDeleteVertexArrays( 1, &vertex_array_ );
+	vertex_array_ = 0;
+}
+
+void TestPageRenderer::SetPage( const TestPageMsg& page )
+{
+	const bool changed = page.test_page_active != page_.test_page_active
+		|| page.test_page_number != page_.test_page_number
+		|| page.test_channel != page_.test_channel;
+	if ( changed && ON == page.test_page_active )
+	{
+		std::cout << "Info: test page " << (int)page.test_page_number << " modifier " << page.pattern_modifier
+			<< " on channel " << page.test_channel << std::endl;
+		yaw_offset_ = 0.0f;
+		pitch_offset_ = 0.0f;
+	}
+	page_ = page;
+}
+
+void TestPageRenderer::Update( float frame_delta_time )
+{
+	if ( program_.TakeReady() )
+		LookUpUniforms();
+
+	if ( ON != page_.test_page_active )
+		return;
+
+	// for the resolution page the yaw rate field holds the target size
+	if ( RESOLUTION != page_.test_page_number )
+		yaw_offset_ = std::fmod( yaw_offset_ + page_.res_size_yaw_rate * frame_delta_time, 360.0f );
+	pitch_offset_ = std::fmod( pitch_offset_ + page_.pitch_rate * frame_delta_time, 360.0f );
+}
+
+bool TestPageRenderer::IsActiveFor( int window_id ) const
+{
+	return ON == page_.test_page_active && program_.IsValid()
+		&& ( ALL_CHANNELS == page_.test_channel || window_id == page_.test_channel );
+}
+
+void TestPageRenderer::Draw( int width, int height, const float frustum_tangents[4], const float view[16], GlStateCache& gl_state )
+{
+	gl_state.UseProgram( program_.GetId() );
+	gl_state.BindVertexArray( vertex_array_ );
+	gl_state.Viewport( 0, 0, width, height );
+	gl_state.Disable( GL_DEPTH_TEST );
+	gl_state.Disable( GL_BLEND );
+	gl_state.Disable( GL_CULL_FACE );
+	gl_state.Disable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
+
+	glUniform1i( page_location_, (GLint)page_.test_page_number );
+	glUniform1i( modifier_location_, page_.pattern_modifier );
+	glUniform2f( size_location_, (GLfloat)width, (GLfloat)height );
+	glUniform4fv( tangents_location_, 1, frustum_tangents );
+	glUniformMatrix4fv( view_location_, 1, GL_FALSE, view );
+	glUniform2f( offset_location_, yaw_offset_, pitch_offset_ );
+	glUniform1f( res_size_location_, page_.res_size_yaw_rate > 0.0f ? page_.res_size_yaw_rate : 256.0f );
+
+	glDrawArrays( GL_TRIANGLES, 0, 3 );
+}
@@ -0,0 +1,73 @@
+//==============================================================================
+// File:TestPageRenderer.h
+//==============================================================================
+//
+// Description: Draws the IG test pages of IgInterface::TestPageMsg procedurally
+//				with one fragment shader. Selecting a page only changes uniforms,
+//				so a switch takes effect the next frame without any upload.
+//				Angular patterns (sphere, cylinder) are computed from the channel
+//				frustum and view, so they line up across channels before the warp.
+//
+//==============================================================================
+
+#ifndef DVC_TEST_PAGE_RENDERER_H
+#define DVC_TEST_PAGE_RENDERER_H
+
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
+#include "gig/IgInterface.h"
+
+class TestPageRenderer
+{
+public:
+	TestPageRenderer();
+
+	/*!
+	 * Needs the IG context. The page stays off until the program is ready, which can take a
+	 * few frames when it is compiled in the background.
+	**/
+	bool Initialize( GlProgramCache& program_cache );
+	void Shutdown();
+
+	/*!
+	 * Takes over a test page message from the host. Inactive messages turn the page off.
+	**/
+	void SetPage( const dvc::IgInterface::TestPageMsg& page );
+
+	/*!
+	 * Advances the animated patterns and picks the program up once it is ready. Call once per frame.
+	**/
+	void Update( float frame_delta_time );
+
+	/*! True if a page is on for this window, either directly or through ALL_CHANNELS. **/
+	bool IsActiveFor( int window_id ) const;
+
+	/*!
+	 * Draws the active page into the bound framebuffer.
+	 *
+	 * @param[in] width, height : target size in pixels
+	 * @param[in] frustum_tangents : tangents of the left, right, bottom and top frustum angles
+	 * @param[in] view : world to view matrix of the channel, column-major
+	**/
+	void Draw( int width, int height, const float frustum_tangents[4], const float view[16], GlStateCache& gl_state );
+
+private:
+	void LookUpUniforms();
+
+	dvc::IgInterface::TestPageMsg page_;
+	float yaw_offset_;		/* degrees, animated by res_size_yaw_rate */
+	float pitch_offset_;	/* degrees, animated by pitch_rate */
+
+	GlProgram program_;
+	GLuint vertex_array_;
+	GLint page_location_;
+	GLint modifier_location_;
+	GLint size_location_;
+	GLint tangents_location_;
+	GLint view_location_;
+	GLint offset_location_;
+	GLint res_size_location_;
+};
+
+#endif // DVC_TEST_PAGE_RENDERER_H
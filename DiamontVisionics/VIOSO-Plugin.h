@@ -1,9 +1,26 @@
 #ifndef VIOSO_Plugin_H
 #define VIOSO_Plugin_H
 
+#include "CalibrationProfiles.h"
+#include "CalibrationReloader.h"
+#include "ChildProcessors.h"
+#include "CubeMapGroup.h"
+#include "ExposureControl.h"
 #include "ExternalFbo.h"
+#include "FrameLimiter.h"
+#include "GazeInput.h"
+#include "JobSystem.h"
+#include "MosaicGroup.h"
+#include "PostChain.h"
+#include "PreviewMosaic.h"
+#include "ResolutionController.h"
+#include "TestPageRenderer.h"
+#include "WarpThread.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
 #include <map>
 #include <string>
+#include <vector>
 
 class SimpleFBOImageProcessor : public IUserDefinedImageProcessor200
 {
@@ -91,8 +108,22 @@ public:
 	void postViewProcess();
 
 	virtual bool useClipPlanes() const;
+
+	/*!
+	 * The warper's frustum of the active window, shifted by a sub-pixel jitter in temporal anti-aliasing mode.
+	**/
 	virtual void getClipPlanes(FrustumParameters& frustum_params) const;
 
+	/*!
+	 * True when the scene may be rendered below the window resolution, see <render scale> and <dynamic_resolution>.
+	**/
+	virtual bool useViewport() const;
+
+	/*!
+	 * The active view's viewport scaled to the scene target of the active window.
+	**/
+	virtual void getViewport(int viewport[4]) const;
+
 	/*!
 	 * If a model view offset or a heading offset is to be used and adjusted in the plugin, this function must return true.
 	 *
@@ -109,6 +140,12 @@ public:
 	**/
 	const double* getModelViewOffsets() const;
 
+	/*!
+	 * Extra radiance the scene does not show, e.g. close lightning. Darkens the adapted exposure,
+	 * see <exposure radiance_scale>.
+	**/
+	virtual void setAdditionalRadiance(double additional_radiance);
+
 	// ======================================================
 	// Methods required by IUserDefinedImageProcessor103
 	// ======================================================
@@ -118,13 +155,80 @@ public:
 	bool GetRenderTargetTextureParameters(RenderTargetTextureParameters& texture_params) const;
 
 private:
+	/*!
+	 * Draws the active test page for the active window into the bound framebuffer.
+	 *
+	 * @param[in] in_scene : drawn before the warp, jittered like the scene
+	**/
+	void DrawTestPage(const ExternalFbo& fbo, unsigned int width, unsigned int height, bool in_scene);
+
+	/*! setActiveWindow for the plugin itself, creating the window's scene target the first time. **/
+	void ActivateWindow(int window_id, int window_extents[2]);
+
+	/*! A warper of the window from a VIOSO ini, null if that failed; the errors are logged. **/
+	VWB_Warper* CreateWarper(int window_id, const std::string& ini_path) const;
+
+	/*! Places the foveated inset of a window around the current gaze. **/
+	void UpdateFoveation(ExternalFbo& fbo);
+
+	/*! The active window's frustum as the warper reports it, without jitter. **/
+	void GetChannelFrustum(FrustumParameters& frustum_params) const;
+
+	/*! The mosaic group led by window_id, null if it leads none. **/
+	MosaicGroup* FindMosaicLeader(int window_id);
+	const MosaicGroup* FindMosaicLeader(int window_id) const;
+	CubeMapGroup* FindCubeMapLeader(int window_id);
+	const CubeMapGroup* FindCubeMapLeader(int window_id) const;
+
+	/*! Any of the windows belongs to a mosaic, a cube map or stereo already. **/
+	bool IsGrouped(const std::vector<int>& window_ids) const;
+
+	/*! warp_settings_ as a window loads them, a stereo window's without what it cannot warp. **/
+	WarpSettings GetWindowSettings(int window_id) const;
+
+	/*! The window's warp can run on the warp thread, a foveated, grouped, temporal or stereo one is warped in place. **/
+	bool CanPipeline(const ExternalFbo& fbo) const;
+
+	/*! See <antialiasing mode="taa">. **/
+	bool IsTemporal() const { return warp_settings_.temporal_feedback > 0.0f; }
+
 	int	active_window_;		/* Id of the active window */
+	int active_viewport_[4];	/* of the active view, in window pixels */
 
 	typedef std::map<int, ExternalFbo*> ExternalFboMap;
 	ExternalFboMap external_fbo_map_; /* ExternalFbo class, represents the buffer that will be rendered into */
 	std::string warper_bin_path_;
 	std::string warper_ini_path_;
 	std::string warper_log_path_;
+	VWB_uint vwb_statemask_;	/* state VWB_render saves itself, on top of what gl_state_ restores */
+	WarpSettings warp_settings_;	/* the plugin's own warp, see WarpRenderer */
+	std::string program_cache_dir_;
+	bool program_cache_background_;
+	GlProgramCache program_cache_;	/* binaries of the plugin's programs, shared by all windows */
+	unsigned int job_threads_;
+	JobSystem jobs_;			/* prepares the windows of the coming frame */
+	mutable GlStateCache gl_state_;	/* IG state changed by the warp, restored without VWB_STATEMASK_ALL */
+	FrameLimiter frame_limiter_;	/* bounds the frames queued ahead of the GPU */
+	bool frame_begun_;				/* the first window of the frame has been started */
+	bool hot_reload_;				/* rebuild warpers when the calibration changes */
+	unsigned int hot_reload_debounce_ms_;
+	CalibrationReloader calibration_reloader_;
+	CalibrationProfiles calibration_profiles_;	/* calibrations every window loads, see <profile> */
+	TestPageRenderer test_pages_;	/* IG test pages, selected by the host or the config */
+	bool test_page_before_warp_;	/* draw test pages into the scene, warped, instead of over the output */
+	PostChain post_chain_;			/* post effects, the last pass merged into the plugin's warp */
+	ResolutionController resolution_;	/* floats the scene scale to hold a GPU frame time */
+	unsigned int frame_index_;		/* selects the jitter of a temporally anti-aliased scene */
+	int active_view_;				/* id of the active view, the foveated inset view gets its own frustum */
+	GazeInput gaze_;				/* gaze for foveated rendering, from update() or shared memory */
+	ExposureControl exposure_;		/* adapts the exposure of all windows to the measured scene */
+	PreviewMosaic preview_;			/* thumbnails of the warped windows for an instructor station */
+	std::vector<MosaicGroup> mosaics_;	/* adjacent windows rendered as one scene, see <mosaic> */
+	std::vector<CubeMapGroup> cube_maps_;	/* windows sampled from one cube map, see <cube_map> */
+	std::vector<int> stereo_windows_;	/* windows showing both eyes, see <stereo> */
+	bool warp_thread_enabled_;		/* pipeline the warps on a thread of their own, see <warp_thread> */
+	WarpThread warp_thread_;
+	ChildProcessors children_;		/* other image processors, run on the scene before the warp, see <processor> */
 };
 
 #endif //def VIOSO-Plugin_H
\ No newline at end of file
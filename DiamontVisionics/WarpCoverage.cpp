@@ -0,0 +1,111 @@
+//==============================================================================
+// File:WarpCoverage.cpp
+//==============================================================================
+
+#include "WarpCoverage.h"
+
+#include <algorithm>
+#include <cmath>
+
+WarpCoverage::WarpCoverage()
+	: loaded_( false )
+	, is_3d_( false )
+{
+	std::fill( bounds_, bounds_ + 4, 0.0f );
+}
+
+void WarpCoverage::Clear()
+{
+	loaded_ = false;
+	outline_.clear();
+}
+
+bool WarpCoverage::Load( VWB_Warper* warper )
+{
+	Clear();
+	VWB_WarpBlend const* warp_blend = nullptr;
+	if ( nullptr == warper || nullptr == VWB_getWarpBlend || VWB_ERROR_NONE != VWB_getWarpBlend( warper, warp_blend )
+		|| nullptr == warp_blend || nullptr == warp_blend->pWarp || nullptr == warp_blend->pBlend )
+		return false;
+
+	const int width = warp_blend->header.width;
+	const int height = warp_blend->header.height;
+	is_3d_ = 0 != ( warp_blend->header.flags & FLAG_SP_WARPFILE_HEADER_3D );
+	std::vector<unsigned char> lit( width * height, 0 );
+	for ( int i = 0; i < width * height; ++i )
+	{
+		const VWB_WarpRecord& warp = warp_blend->pWarp[i];
+		const VWB_BlendRecord2& weight = warp_blend->pBlend[i];
+		const bool valid = ( is_3d_ ? warp.w : warp.z ) > 0.5f;
+		lit[i] = valid && ( 0.0f != weight.r || 0.0f != weight.g || 0.0f != weight.b ) ? 1 : 0;
+	}
+
+	float bounds[4] = { HUGE_VALF, -HUGE_VALF, HUGE_VALF, -HUGE_VALF };
+	for ( int y = 0; y < height; ++y )
+	{
+		for ( int x = 0; x < width; ++x )
+		{
+			const int i = y * width + x;
+			if ( !lit[i] )
+				continue;
+			const VWB_WarpRecord& warp = warp_blend->pWarp[i];
+			if ( !is_3d_ )
+			{
+				// source rows are stored top down like the map
+				bounds[0] = std::min( bounds[0], warp.x );
+				bounds[1] = std::max( bounds[1], warp.x );
+				bounds[2] = std::min( bounds[2], 1.0f - warp.y );
+				bounds[3] = std::max( bounds[3], 1.0f - warp.y );
+				continue;
+			}
+			// a smooth map reaches its extremes on the outline of the lit area
+			const bool inner = x > 0 && x < width - 1 && y > 0 && y < height - 1
+				&& lit[i - 1] && lit[i + 1] && lit[i - width] && lit[i + width];
+			if ( inner )
+				continue;
+			outline_.push_back( warp.x );
+			outline_.push_back( warp.y );
+			outline_.push_back( warp.z );
+		}
+	}
+
+	std::copy( bounds, bounds + 4, bounds_ );
+	loaded_ = is_3d_ ? !outline_.empty() : bounds[1] >= bounds[0];
+	return loaded_;
+}
+
+bool WarpCoverage::GetRegion( const VWB_float* view_proj, float region[4] ) const
+{
+	if ( !loaded_ )
+		return false;
+
+	float bounds[4] = { bounds_[0], bounds_[1], bounds_[2], bounds_[3] };
+	if ( is_3d_ )
+	{
+		if ( nullptr == view_proj )
+			return false;
+		bounds[0] = bounds[2] = HUGE_VALF;
+		bounds[1] = bounds[3] = -HUGE_VALF;
+		for ( size_t i = 0; i < outline_.size(); i += 3 )
+		{
+			const VWB_float* p = &outline_[i];
+			const float x = view_proj[0] * p[0] + view_proj[4] * p[1] + view_proj[8] * p[2] + view_proj[12];
+			const float y = view_proj[1] * p[0] + view_proj[5] * p[1] + view_proj[9] * p[2] + view_proj[13];
+			const float w = view_proj[3] * p[0] + view_proj[7] * p[1] + view_proj[11] * p[2] + view_proj[15];
+			if ( w <= 0.0f )
+				return false;
+			const float u = x / w * 0.5f + 0.5f;
+			const float v = y / w * 0.5f + 0.5f;
+			bounds[0] = std::min( bounds[0], u );
+			bounds[1] = std::max( bounds[1], u );
+			bounds[2] = std::min( bounds[2], v );
+			bounds[3] = std::max( bounds[3], v );
+		}
+	}
+
+	region[0] = bounds[0];
+	region[1] = bounds[2];
+	region[2] = bounds[1] - bounds[0];
+	region[3] = bounds[3] - bounds[2];
+	return true;
+}
@@ -0,0 +1,52 @@
+//==============================================================================
+// File:WarpCoverage.h
+//==============================================================================
+//
+// Description: The part of a channel its warp actually reads. Only texels that
+//				are valid and blended above zero count. The bounds of a 2D map's
+//				source coordinates are fixed, a 3D map's are found each frame by
+//				projecting the outline of its lit texels with the warper's
+//				current view and projection. ExternalFbo trims the frustum the
+//				IG renders to them.
+//
+//==============================================================================
+
+#ifndef DVC_WARP_COVERAGE_H
+#define DVC_WARP_COVERAGE_H
+
+#include "ExternalFbo.h"
+
+#include <vector>
+
+class WarpCoverage
+{
+public:
+	WarpCoverage();
+
+	/*!
+	 * Collects the lit texels of the warper's maps. CPU only.
+	 *
+	 * @return
+	 *  false if the warper does not expose its maps or lights nothing
+	**/
+	bool Load( VWB_Warper* warper );
+	void Clear();
+
+	/*!
+	 * The used part of the channel. CPU only, may run on a job thread.
+	 *
+	 * @param[in] view_proj : of the warper, column-major, needed by 3D maps
+	 * @param[out] region : x, y, width and height, 0-1 from the lower left of the channel
+	 * @return
+	 *  false if unknown, e.g. a 3D map without view_proj or reaching behind the eye
+	**/
+	bool GetRegion( const VWB_float* view_proj, float region[4] ) const;
+
+private:
+	bool loaded_;
+	bool is_3d_;
+	float bounds_[4];				/* 2D maps: left, right, bottom and top source coordinate */
+	std::vector<VWB_float> outline_;	/* 3D maps: positions of the lit texels next to an unlit one, xyz */
+};
+
+#endif // DVC_WARP_COVERAGE_H
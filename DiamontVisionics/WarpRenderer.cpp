@@ -0,0 +1,1195 @@
+//==============================================================================
+// File:WarpRenderer.cpp
+//==============================================================================
+
+#include "WarpRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	// tile corners in map coordinates, top row first like the VIOSO maps
+	const char* kVertexShader = R"(
+#version 330 core
+layout( location = 0 ) in vec2 a_position;
+void main()
+{
+	gl_Position = vec4( a_position.x * 2.0 - 1.0, 1.0 - a_position.y * 2.0, 0.0, 1.0 );
+}
+)";
+
+	// both eyes of a stereo window in one draw, an instance each
+	const char* kStereoVertexShader = R"(
+#version 330 core
+layout( location = 0 ) in vec2 a_position;
+uniform vec4 u_eye_rects[2];	// x, y, width and height of each eye in the window, 0-1 from the lower left
+flat out int v_layer;
+void main()
+{
+	vec4 rect = u_eye_rects[gl_InstanceID];
+	vec2 position = rect.xy + vec2( a_position.x, 1.0 - a_position.y ) * rect.zw;
+	gl_Position = vec4( position * 2.0 - 1.0, 0.0, 1.0 );
+	v_layer = gl_InstanceID;
+}
+)";
+
+	// preceded by the version and, for partial tiles, BLEND
+	const char* kFragmentDeclarations = R"(
+#ifdef STEREO
+uniform sampler2DArray u_source;	// a layer per eye
+uniform vec4 u_eye_rects[2];
+uniform mat4 u_view_proj_right;	// 3D maps only, u_view_proj is the left eye's
+flat in int v_layer;
+#else
+uniform sampler2D u_source;
+#endif
+uniform sampler2D u_warp;
+uniform sampler2D u_blend;
+uniform vec2 u_size;
+uniform mat4 u_view_proj;	// 3D maps only
+uniform float u_warp_scale;	// 2D maps: offset from the identity per unit stored
+uniform vec2 u_source_texel;	// of the part of u_source that holds the source
+uniform vec4 u_source_region;	// x, y, width and height of the channel the source covers
+uniform float u_post_seed;
+uniform float u_sharpness;	// UPSCALE only
+uniform vec4 u_inset;		// FOVEATED only: x, y, width and height of the inset in the channel
+uniform vec4 u_inset_source;	// and in u_source, in pixels
+uniform float u_inset_border;
+uniform float u_exposure;	// TONE only
+uniform samplerCube u_cube;	// CUBE only
+uniform float u_cube_enabled;	// the channel is looked up in u_cube instead of u_source
+uniform mat3 u_channel_to_eye;
+uniform vec4 u_channel_tangents;	// left, right, bottom, top
+uniform sampler2D u_source_mips;	// MIPS only: the levels below u_source
+uniform sampler2D u_footprint;	// and for 2D maps the extent of a map pixel in the channel
+uniform vec2 u_footprint_scale;	// to source pixels per output pixel
+uniform float u_max_lod;		// levels built below u_source
+uniform vec2 u_mips_scale;		// of the part of u_source_mips that holds the source
+#ifdef TEMPORAL
+layout( rgba8 ) uniform image2D u_history;	// earlier frames of the channel, in target pixels
+#endif
+uniform float u_temporal_enabled;	// TEMPORAL only: a history is bound
+uniform float u_feedback;		// its share in each pixel
+out vec4 frag_color;
+
+// of a stereo source the eye's layer
+vec2 SourceSize()
+{
+	return vec2( textureSize( u_source, 0 ).xy );
+}
+
+vec3 SourceAt( vec2 uv )
+{
+#ifdef STEREO
+	return texture( u_source, vec3( uv, float( v_layer ) ) ).rgb;
+#else
+	return texture( u_source, uv ).rgb;
+#endif
+}
+
+vec3 SourceTexel( ivec2 pixel )
+{
+#ifdef STEREO
+	return texelFetch( u_source, ivec3( pixel, v_layer ), 0 ).rgb;
+#else
+	return texelFetch( u_source, pixel, 0 ).rgb;
+#endif
+}
+
+// a dynamically scaled source fills only the lower left of its texture
+vec3 SourceTexture( vec2 uv )
+{
+	vec2 scale = 1.0 / ( u_source_texel * SourceSize() );
+	return SourceAt( clamp( uv, 0.5 * u_source_texel, 1.0 - 0.5 * u_source_texel ) * scale );
+}
+
+#ifdef UPSCALE
+// FSR1 style: an edge-directed Lanczos-2 over the 12 nearest source texels (EASU), then
+// sharpening against the source cross, limited so it can neither clip nor ring (RCAS)
+float UpscaleLuma( vec3 c )
+{
+	return c.g + 0.5 * ( c.r + c.b );
+}
+
+float UpscaleWeight( vec2 offset, float lobe, float clip )
+{
+	float d2 = min( dot( offset, offset ), clip );
+	float window = 0.4 * d2 - 1.0;
+	float base = lobe * d2 - 1.0;
+	return ( 25.0 / 16.0 * window * window - ( 25.0 / 16.0 - 1.0 ) ) * base * base;
+}
+
+vec3 Upscale( vec2 uv )
+{
+	vec2 position = uv / u_source_texel - 0.5;
+	vec2 f = position - floor( position );
+	ivec2 origin = ivec2( floor( position ) ) - 1;
+	ivec2 last = ivec2( 1.0 / u_source_texel + 0.5 ) - 1;
+
+	// 4x4 around the 2x2 the position falls into, the corners are never read
+	vec3 c[16];
+	float l[16];
+	for ( int y = 0; y < 4; ++y )
+	{
+		for ( int x = 0; x < 4; ++x )
+		{
+			c[y * 4 + x] = SourceTexel( clamp( origin + ivec2( x, y ), ivec2( 0 ), last ) );
+			l[y * 4 + x] = UpscaleLuma( c[y * 4 + x] );
+		}
+	}
+
+	// edge direction and how clean the edge is, from the inner 2x2 weighted bilinearly
+	vec2 direction = vec2( 0.0 );
+	float edge = 0.0;
+	for ( int y = 1; y < 3; ++y )
+	{
+		for ( int x = 1; x < 3; ++x )
+		{
+			int i = y * 4 + x;
+			float w = ( 1 == x ? 1.0 - f.x : f.x ) * ( 1 == y ? 1.0 - f.y : f.y );
+			vec2 gradient = vec2( l[i + 1] - l[i - 1], l[i + 4] - l[i - 4] );
+			vec2 range = vec2( max( abs( l[i + 1] - l[i] ), abs( l[i] - l[i - 1] ) ), max( abs( l[i + 4] - l[i] ), abs( l[i] - l[i - 4] ) ) );
+			vec2 clean = clamp( abs( gradient ) / max( range, vec2( 1.0 / 65536.0 ) ), 0.0, 1.0 );
+			direction += gradient * w;
+			edge += dot( clean * clean, vec2( w ) );
+		}
+	}
+	edge *= 0.5;
+	edge *= edge;
+	float length2 = dot( direction, direction );
+	direction = length2 < 1.0 / 32768.0 ? vec2( 1.0, 0.0 ) : direction * inversesqrt( length2 );
+
+	// stretched along the edge, up to sqrt(2) on diagonals, and squeezed across it
+	float stretch = 1.0 / max( abs( direction.x ), abs( direction.y ) );
+	vec2 scale = vec2( 1.0 + ( stretch - 1.0 ) * edge, 1.0 - 0.5 * edge );
+	float lobe = 0.5 + ( 0.25 - 0.04 - 0.5 ) * edge;
+	float clip = 1.0 / lobe;
+
+	vec3 sum = vec3( 0.0 );
+	float total = 0.0;
+	for ( int y = 0; y < 4; ++y )
+	{
+		for ( int x = 0; x < 4; ++x )
+		{
+			if ( ( 0 == x || 3 == x ) && ( 0 == y || 3 == y ) )
+				continue;
+			vec2 offset = vec2( x - 1, y - 1 ) - f;
+			vec2 rotated = vec2( dot( offset, direction ), dot( offset, vec2( -direction.y, direction.x ) ) ) * scale;
+			float w = UpscaleWeight( rotated, lobe, clip );
+			sum += c[y * 4 + x] * w;
+			total += w;
+		}
+	}
+	vec3 lo = min( min( c[5], c[6] ), min( c[9], c[10] ) );
+	vec3 hi = max( max( c[5], c[6] ), max( c[9], c[10] ) );
+	vec3 color = clamp( sum / total, lo, hi );
+
+	vec3 n0 = SourceTexture( uv + vec2( u_source_texel.x, 0.0 ) );
+	vec3 n1 = SourceTexture( uv - vec2( u_source_texel.x, 0.0 ) );
+	vec3 n2 = SourceTexture( uv + vec2( 0.0, u_source_texel.y ) );
+	vec3 n3 = SourceTexture( uv - vec2( 0.0, u_source_texel.y ) );
+	vec3 lo4 = min( min( n0, n1 ), min( n2, n3 ) );
+	vec3 hi4 = max( max( n0, n1 ), max( n2, n3 ) );
+	vec3 hit_lo = min( lo4, color ) / max( 4.0 * hi4, vec3( 1.0 / 65536.0 ) );
+	vec3 hit_hi = ( 1.0 - max( hi4, color ) ) / min( 4.0 * lo4 - 4.0, vec3( -1.0 / 65536.0 ) );
+	vec3 lobes = max( -hit_lo, hit_hi );
+	float sharpen = max( -0.1875, min( max( lobes.r, max( lobes.g, lobes.b ) ), 0.0 ) ) * u_sharpness;
+	return ( sharpen * ( n0 + n1 + n2 + n3 ) + color ) / ( 4.0 * sharpen + 1.0 );
+}
+#endif
+
+#ifdef MIPS
+// level of detail where the warp compresses the source, set by main
+float source_lod = 0.0;
+
+// trilinear between the source and the levels below it
+vec3 MippedSource( vec2 uv )
+{
+	// kept a texel of the coarser level inside the source, the chain holds stale texels beyond it
+	vec2 texel = u_source_texel * exp2( ceil( source_lod ) );
+	uv = clamp( uv, 0.5 * texel, 1.0 - 0.5 * texel );
+	vec3 below = textureLod( u_source_mips, uv * u_mips_scale, max( source_lod - 1.0, 0.0 ) ).rgb;
+	if ( source_lod >= 1.0 )
+		return below;
+	vec2 scale = 1.0 / ( u_source_texel * SourceSize() );
+	return mix( textureLod( u_source, uv * scale, 0.0 ).rgb, below, source_lod );
+}
+#endif
+
+// the whole channel
+vec3 PeripherySource( vec2 uv )
+{
+#ifdef CUBE
+	// the direction through uv, in the scene the group rendered once
+	if ( u_cube_enabled > 0.5 )
+		return texture( u_cube, u_channel_to_eye * vec3( mix( u_channel_tangents.xz, u_channel_tangents.yw, uv ), -1.0 ) ).rgb;
+#endif
+#ifdef MIPS
+	if ( source_lod > 0.0 )
+		return MippedSource( uv );
+#endif
+#ifdef UPSCALE
+	return Upscale( uv );
+#else
+	return SourceTexture( uv );
+#endif
+}
+
+// what the post effects and the warp read
+vec3 PostSource( vec2 uv )
+{
+#ifdef FOVEATED
+	// the gaze inset at full resolution, faded into the periphery over its border
+	vec2 inset = ( uv - u_inset.xy ) / u_inset.zw;
+	vec2 edge = min( inset, 1.0 - inset );
+	float weight = smoothstep( 0.0, u_inset_border, min( edge.x, edge.y ) );
+	vec3 color = weight < 1.0 ? PeripherySource( uv ) : vec3( 0.0 );
+	if ( weight > 0.0 )
+	{
+		vec2 pixel = u_inset_source.xy + clamp( inset * u_inset_source.zw, vec2( 0.5 ), u_inset_source.zw - 0.5 );
+		color = mix( color, SourceAt( pixel / SourceSize() ), weight );
+	}
+	return color;
+#else
+	return PeripherySource( uv );
+#endif
+}
+
+#ifdef TEMPORAL
+vec3 ToYCoCg( vec3 c )
+{
+	return vec3( 0.25 * c.r + 0.5 * c.g + 0.25 * c.b, 0.5 * c.r - 0.5 * c.b, -0.25 * c.r + 0.5 * c.g - 0.25 * c.b );
+}
+
+vec3 FromYCoCg( vec3 c )
+{
+	return vec3( c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z );
+}
+
+// the jittered scene where the warp samples it, blended into the history of this target pixel;
+// the history is clipped towards the mean of the 3x3 source texels around uv, like TemporalResolve
+vec3 Accumulate( vec2 uv, vec3 color )
+{
+	if ( u_temporal_enabled < 0.5 )
+		return color;
+
+	vec3 current = ToYCoCg( color );
+	vec3 lo = current;
+	vec3 hi = current;
+	ivec2 last = ivec2( 1.0 / u_source_texel + 0.5 ) - 1;
+	ivec2 center = ivec2( floor( clamp( uv, vec2( 0.0 ), vec2( 1.0 ) ) / u_source_texel ) );
+	for ( int y = -1; y <= 1; ++y )
+	{
+		for ( int x = -1; x <= 1; ++x )
+		{
+			vec3 c = ToYCoCg( SourceTexel( clamp( center + ivec2( x, y ), ivec2( 0 ), last ) ) );
+			lo = min( lo, c );
+			hi = max( hi, c );
+		}
+	}
+
+	ivec2 pixel = ivec2( gl_FragCoord.xy );
+	vec3 history = ToYCoCg( imageLoad( u_history, pixel ).rgb );
+	vec3 center_color = 0.5 * ( lo + hi );
+	vec3 extent = max( 0.5 * ( hi - lo ), vec3( 1.0 / 1024.0 ) );
+	vec3 offset = history - center_color;
+	vec3 units = abs( offset / extent );
+	float outside = max( units.x, max( units.y, units.z ) );
+	if ( outside > 1.0 )
+		history = center_color + offset / outside;
+
+	vec3 resolved = FromYCoCg( mix( current, history, u_feedback ) );
+	imageStore( u_history, pixel, vec4( resolved, 1.0 ) );
+	return resolved;
+}
+#endif
+
+#ifdef TONE
+// the identity up to a knee, then a shoulder that approaches white instead of clipping
+vec3 ToneCurve( vec3 c )
+{
+	const float knee = 0.8;
+	vec3 over = max( c - knee, 0.0 );
+	return min( c, vec3( knee ) ) + ( 1.0 - knee ) * ( 1.0 - exp( -over / ( 1.0 - knee ) ) );
+}
+#endif
+)";
+
+	// preceded by the last pass of the post effects, with POST
+	const char* kFragmentMain = R"(
+void main()
+{
+#ifdef STEREO
+	// each eye is warped into its own part of the window
+	vec4 rect = u_eye_rects[v_layer];
+	vec2 eye = ( gl_FragCoord.xy / u_size - rect.xy ) / rect.zw;
+	vec2 map = vec2( eye.x, 1.0 - eye.y );
+#else
+	vec2 map = vec2( gl_FragCoord.x / u_size.x, 1.0 - gl_FragCoord.y / u_size.y );
+#endif
+#ifdef WARP_3D
+#ifdef STEREO
+	mat4 view_proj = 0 == v_layer ? u_view_proj : u_view_proj_right;
+#else
+	mat4 view_proj = u_view_proj;
+#endif
+	vec4 clip = view_proj * vec4( texture( u_warp, map ).xyz, 1.0 );
+	vec2 uv = clip.xy / clip.w * 0.5 + 0.5;
+#else
+	vec2 warp = map + texture( u_warp, map ).xy * u_warp_scale;
+	vec2 uv = vec2( warp.x, 1.0 - warp.y );
+#endif
+	uv = ( uv - u_source_region.xy ) / u_source_region.zw;
+#ifdef MIPS
+#ifdef WARP_3D
+	// source pixels per output pixel, 3D maps depend on the view
+	vec2 footprint = max( abs( dFdx( uv ) ), abs( dFdy( uv ) ) ) / u_source_texel;
+#else
+	vec2 footprint = texture( u_footprint, map ).xy * u_footprint_scale;
+#endif
+	source_lod = min( log2( max( max( footprint.x, footprint.y ), 1.0 ) ), u_max_lod );
+#endif
+#ifdef POST
+	vec3 color = Post( uv );
+#else
+	vec3 color = PostSource( uv );
+#endif
+#ifdef TEMPORAL
+	color = Accumulate( uv, color );
+#endif
+#ifdef TONE
+	color = ToneCurve( color * u_exposure );
+#endif
+#ifdef BLEND
+	color *= texture( u_blend, map ).rgb;
+#endif
+	frag_color = vec4( color, 1.0 );
+}
+)";
+
+	// texture units, 0 is left to the IG
+	const GLint kSourceUnit = 1;
+	const GLint kWarpUnit = 2;
+	const GLint kBlendUnit = 3;
+	const GLint kCubeUnit = 4;
+	const GLint kMipsUnit = 5;
+	const GLint kFootprintUnit = 6;
+	// image unit of the temporal history, the IG's fixed function pipeline has no use for images
+	const GLuint kHistoryImageUnit = 0;
+
+	GLuint CreateTexture( GLenum internal_format, int width, int height, GLenum format, GLenum type, const void* data )
+	{
+		GLuint tex = 0;
+		glGenTextures( 1, &tex );
+
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S    , GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T    , GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR       );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR       );
+
+		glTextureImage2DEXT( tex, GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, data );
+
+		return tex;
+	}
+
+	// a stereo source is an array, MIPS reads it directly and is never stereo
+	bool RequestProgram( GlProgram& program, GlProgramCache& program_cache, bool blend, bool is_3d, bool upscale, bool foveated,
+		bool tone, bool cube, bool mips, bool stereo, bool temporal, const std::string& post_source )
+	{
+		std::string fragment_source = "#version 330 core\n";
+		if ( temporal )
+			fragment_source += "#extension GL_ARB_shader_image_load_store : require\n#define TEMPORAL\n";
+		if ( blend )
+			fragment_source += "#define BLEND\n";
+		if ( is_3d )
+			fragment_source += "#define WARP_3D\n";
+		if ( upscale )
+			fragment_source += "#define UPSCALE\n";
+		if ( foveated )
+			fragment_source += "#define FOVEATED\n";
+		if ( tone )
+			fragment_source += "#define TONE\n";
+		if ( cube )
+			fragment_source += "#define CUBE\n";
+		if ( mips )
+			fragment_source += "#define MIPS\n";
+		if ( stereo )
+			fragment_source += "#define STEREO\n";
+		if ( !post_source.empty() )
+			fragment_source += "#define POST\n";
+		fragment_source += kFragmentDeclarations;
+		fragment_source += post_source;
+		fragment_source += kFragmentMain;
+
+		program.Request( program_cache, blend ? "VIOSO-Plugin warp and blend" : "VIOSO-Plugin warp", stereo ? kStereoVertexShader : kVertexShader, fragment_source.c_str() );
+		return program.IsValid() || program.IsPending();
+	}
+
+
+	// round to nearest, the offsets are far from the half range limits
+	unsigned short FloatToHalf( float value )
+	{
+		unsigned int bits = 0;
+		memcpy( &bits, &value, sizeof( bits ) );
+		const unsigned int sign = ( bits >> 16 ) & 0x8000;
+		const int exponent = (int)( ( bits >> 23 ) & 0xff ) - 127 + 15;
+		unsigned int mantissa = bits & 0x7fffff;
+
+		if ( exponent <= 0 )
+		{
+			if ( exponent < -10 )
+				return (unsigned short)sign;
+			mantissa |= 0x800000;
+			const int shift = 14 - exponent;
+			unsigned int half = mantissa >> shift;
+			if ( ( mantissa >> ( shift - 1 ) ) & 1 )
+				++half;
+			return (unsigned short)( sign | half );
+		}
+		if ( exponent >= 31 )
+			return (unsigned short)( sign | 0x7c00 );
+
+		unsigned int half = sign | ( exponent << 10 ) | ( mantissa >> 13 );
+		if ( mantissa & 0x1000 )
+			++half;
+		return (unsigned short)half;
+	}
+
+	float HalfToFloat( unsigned short half )
+	{
+		const int exponent = ( half >> 10 ) & 0x1f;
+		const int mantissa = half & 0x3ff;
+		float value = 0.0f;
+		if ( 0 == exponent )
+			value = std::ldexp( (float)mantissa, -24 );
+		else if ( 31 == exponent )
+			value = HUGE_VALF;
+		else
+			value = std::ldexp( (float)( mantissa | 0x400 ), exponent - 25 );
+		return ( half & 0x8000 ) ? -value : value;
+	}
+
+	bool IsValid( const VWB_WarpBlend& warp_blend, int x, int y )
+	{
+		return x >= 0 && y >= 0 && x < (int)warp_blend.header.width && y < (int)warp_blend.header.height
+			&& warp_blend.pWarp[y * warp_blend.header.width + x].z > 0.5f;
+	}
+
+	// change of the source coordinates per map pixel in direction dx, dy of a valid 2D map pixel
+	void Difference( const VWB_WarpBlend& warp_blend, int x, int y, int dx, int dy, float change[2] )
+	{
+		const bool forward = IsValid( warp_blend, x + dx, y + dy );
+		const bool backward = IsValid( warp_blend, x - dx, y - dy );
+		if ( !forward && !backward )
+			return;
+		const VWB_WarpRecord& next = warp_blend.pWarp[forward ? ( y + dy ) * warp_blend.header.width + x + dx : y * warp_blend.header.width + x];
+		const VWB_WarpRecord& previous = warp_blend.pWarp[backward ? ( y - dy ) * warp_blend.header.width + x - dx : y * warp_blend.header.width + x];
+		const float steps = forward && backward ? 2.0f : 1.0f;
+		change[0] = ( next.x - previous.x ) / steps;
+		change[1] = ( next.y - previous.y ) / steps;
+	}
+
+	void AppendQuad( std::vector<GLfloat>& vertices, float left, float top, float right, float bottom )
+	{
+		const GLfloat quad[12] = { left, top,  left, bottom,  right, bottom,  left, top,  right, bottom,  right, top };
+		vertices.insert( vertices.end(), quad, quad + 12 );
+	}
+}
+
+WarpRenderer::WarpRenderer()
+	: is_3d_( false )
+	, map_width_( 0 )
+	, map_height_( 0 )
+	, warp_texture_( 0 )
+	, blend_texture_( 0 )
+	, copy_texture_( 0 )
+	, copy_framebuffer_( 0 )
+	, copy_width_( 0 )
+	, copy_height_( 0 )
+	, warp_scale_( 1.0f )
+	, programs_ready_( false )
+	, post_chain_( nullptr )
+	, upscale_( false )
+	, foveated_( false )
+	, foveated_layout_( nullptr )
+	, exposure_( nullptr )
+	, cube_( false )
+	, cube_source_( nullptr )
+	, source_region_( nullptr )
+	, stereo_( false )
+	, stereo_source_( nullptr )
+	, temporal_( false )
+	, temporal_source_( nullptr )
+	, mip_levels_( 0 )
+	, footprint_texture_( 0 )
+	, sharpness_( 0.0f )
+	, vertex_array_( 0 )
+	, vertex_buffer_( 0 )
+	, partial_vertices_( 0 )
+	, pass_through_vertices_( 0 )
+{
+	max_footprint_[0] = max_footprint_[1] = 0.0f;
+}
+
+WarpRenderer::WarpProgram::WarpProgram()
+	: size_location( -1 )
+	, view_proj_location( -1 )
+	, warp_scale_location( -1 )
+	, source_texel_location( -1 )
+	, source_region_location( -1 )
+	, post_seed_location( -1 )
+	, sharpness_location( -1 )
+	, inset_location( -1 )
+	, inset_source_location( -1 )
+	, inset_border_location( -1 )
+	, exposure_location( -1 )
+	, cube_enabled_location( -1 )
+	, channel_to_eye_location( -1 )
+	, channel_tangents_location( -1 )
+	, footprint_scale_location( -1 )
+	, max_lod_location( -1 )
+	, mips_scale_location( -1 )
+	, eye_rects_location( -1 )
+	, view_proj_right_location( -1 )
+	, temporal_enabled_location( -1 )
+	, feedback_location( -1 )
+{
+}
+
+void WarpRenderer::WarpProgram::LookUpUniforms()
+{
+	// samplers are fixed, so they are set once
+	glProgramUniform1iEXT( program.GetId(), program.GetUniform( "u_source" ), kSourceUnit );
+	glProgramUniform1iEXT( program.GetId(), program.GetUniform( "u_warp" ), kWarpUnit );
+	glProgramUniform1iEXT( program.GetId(), program.GetUniform( "u_blend" ), kBlendUnit );
+	glProgramUniform1iEXT( program.GetId(), program.GetUniform( "u_cube" ), kCubeUnit );
+	glProgramUniform1iEXT( program.GetId(), program.GetUniform( "u_source_mips" ), kMipsUnit );
+	glProgramUniform1iEXT( program.GetId(), program.GetUniform( "u_footprint" ), kFootprintUnit );
+	size_location = program.GetUniform( "u_size" );
+	view_proj_location = program.GetUniform( "u_view_proj" );
+	warp_scale_location = program.GetUniform( "u_warp_scale" );
+	source_texel_location = program.GetUniform( "u_source_texel" );
+	source_region_location = program.GetUniform( "u_source_region" );
+	post_seed_location = program.GetUniform( "u_post_seed" );
+	sharpness_location = program.GetUniform( "u_sharpness" );
+	inset_location = program.GetUniform( "u_inset" );
+	inset_source_location = program.GetUniform( "u_inset_source" );
+	inset_border_location = program.GetUniform( "u_inset_border" );
+	exposure_location = program.GetUniform( "u_exposure" );
+	cube_enabled_location = program.GetUniform( "u_cube_enabled" );
+	channel_to_eye_location = program.GetUniform( "u_channel_to_eye" );
+	channel_tangents_location = program.GetUniform( "u_channel_tangents" );
+	footprint_scale_location = program.GetUniform( "u_footprint_scale" );
+	max_lod_location = program.GetUniform( "u_max_lod" );
+	mips_scale_location = program.GetUniform( "u_mips_scale" );
+	eye_rects_location = program.GetUniform( "u_eye_rects" );
+	view_proj_right_location = program.GetUniform( "u_view_proj_right" );
+	temporal_enabled_location = program.GetUniform( "u_temporal_enabled" );
+	feedback_location = program.GetUniform( "u_feedback" );
+}
+
+bool WarpRenderer::Load( VWB_Warper* warper, const WarpSettings& settings )
+{
+	Unload();
+	if ( nullptr == warper || nullptr == VWB_getWarpBlend || nullptr == settings.program_cache || settings.tile_size <= 0 )
+		return false;
+	const int tile_size = settings.tile_size;
+
+	VWB_WarpBlend const* warp_blend = nullptr;
+	if ( VWB_ERROR_NONE != VWB_getWarpBlend( warper, warp_blend ) || nullptr == warp_blend
+		|| nullptr == warp_blend->pWarp || nullptr == warp_blend->pBlend )
+	{
+		std::cout << "Info: the warper does not expose its maps, warping with VWB_render." << std::endl;
+		return false;
+	}
+	if ( nullptr != warp_blend->pBlack || nullptr != warp_blend->pWhite )
+	{
+		std::cout << "Info: " << warp_blend->channel << " uses black level or white compensation, warping with VWB_render." << std::endl;
+		return false;
+	}
+
+	const bool is_3d = 0 != ( warp_blend->header.flags & FLAG_SP_WARPFILE_HEADER_3D );
+	foveated_ = settings.foveation.inset_view >= 0;
+	cube_ = settings.cube_map;
+	stereo_ = settings.stereo.left_view >= 0 && !foveated_ && !cube_;
+	// a jittered scene is resolved where the warp samples it; cube faces, eye layers and a
+	// foveated inset are resolved in their own pass, see TemporalResolve
+	temporal_ = settings.temporal_feedback > 0.0f && !foveated_ && !cube_ && !stereo_;
+	// the last pass of the post effects runs inside the warp, unless the warp resolves: the
+	// history is clipped to the source texels, which have to hold the effects' result then
+	post_chain_ = settings.post_chain && !settings.post_chain->IsEmpty() ? settings.post_chain : nullptr;
+	const std::string post_source = post_chain_ && !temporal_ ? post_chain_->GetFusedSource() : std::string();
+	upscale_ = std::min( settings.render_scale, settings.min_render_scale ) < 1.0f || foveated_;
+	sharpness_ = std::min( std::max( settings.sharpness, 0.0f ), 1.0f );
+	// without its measurements there is nothing to adapt to
+	exposure_ = settings.exposure && settings.exposure->IsEnabled() && histogram_.Load( *settings.program_cache ) ? settings.exposure : nullptr;
+	const bool tone = nullptr != exposure_;
+	// a foveated source is the periphery, rendered small enough already
+	mip_levels_ = settings.mip_levels > 0 && !foveated_ && !stereo_ && mips_.Load( *settings.program_cache ) ? std::min( settings.mip_levels, (int)SourceMips::kMaxLevels ) : 0;
+	const bool mips = mip_levels_ > 0;
+	if ( !RequestProgram( partial_.program, *settings.program_cache, true, is_3d, upscale_, foveated_, tone, cube_, mips, stereo_, temporal_, post_source )
+		|| !RequestProgram( pass_through_.program, *settings.program_cache, false, is_3d, upscale_, foveated_, tone, cube_, mips, stereo_, temporal_, post_source ) )
+	{
+		Unload();
+		return false;
+	}
+	programs_ready_ = false;
+
+	is_3d_ = is_3d;
+	map_width_ = warp_blend->header.width;
+	map_height_ = warp_blend->header.height;
+	const int pixels = map_width_ * map_height_;
+
+	// invalid pixels are blended to black, so the shaders never have to test for them
+	std::vector<GLfloat> blend( pixels * 3 );
+	for ( int i = 0; i < pixels; ++i )
+	{
+		const VWB_WarpRecord& warp = warp_blend->pWarp[i];
+		const VWB_BlendRecord2& weight = warp_blend->pBlend[i];
+		const bool valid = ( is_3d ? warp.w : warp.z ) > 0.5f;
+		blend[i * 3 + 0] = valid ? weight.r : 0.0f;
+		blend[i * 3 + 1] = valid ? weight.g : 0.0f;
+		blend[i * 3 + 2] = valid ? weight.b : 0.0f;
+	}
+	UploadWarp( *warp_blend, settings.max_error, settings.output_width, settings.output_height );
+	if ( mips && !is_3d )
+		UploadFootprint( *warp_blend );
+	blend_texture_ = CreateTexture( GL_RGB16F, map_width_, map_height_, GL_RGB, GL_FLOAT, &blend[0] );
+
+	std::vector<unsigned char> classes;
+	int columns = 0;
+	int rows = 0;
+	Classify( *warp_blend, is_3d, tile_size, classes, columns, rows );
+
+	std::vector<Run> partial_runs;
+	std::vector<Run> pass_through_runs;
+	MergeRuns( classes, columns, rows, TILE_PARTIAL, tile_size, map_width_, map_height_, partial_runs );
+	MergeRuns( classes, columns, rows, TILE_PASS_THROUGH, tile_size, map_width_, map_height_, pass_through_runs );
+	MergeRuns( classes, columns, rows, TILE_BLACK, tile_size, map_width_, map_height_, black_runs_ );
+
+	std::vector<GLfloat> vertices;
+	for ( size_t i = 0; i < partial_runs.size(); ++i )
+	{
+		const Run& run = partial_runs[i];
+		AppendQuad( vertices, (float)run.x / map_width_, (float)run.y / map_height_,
+			(float)( run.x + run.width ) / map_width_, (float)( run.y + run.height ) / map_height_ );
+	}
+	partial_vertices_ = (GLsizei)( vertices.size() / 2 );
+	for ( size_t i = 0; i < pass_through_runs.size(); ++i )
+	{
+		const Run& run = pass_through_runs[i];
+		AppendQuad( vertices, (float)run.x / map_width_, (float)run.y / map_height_,
+			(float)( run.x + run.width ) / map_width_, (float)( run.y + run.height ) / map_height_ );
+	}
+	pass_through_vertices_ = (GLsizei)( vertices.size() / 2 ) - partial_vertices_;
+
+	glGenBuffers( 1, &vertex_buffer_ );
+	if ( !vertices.empty() )
+		glNamedBufferDataEXT( vertex_buffer_, vertices.size() * sizeof( GLfloat ), &vertices[0], GL_STATIC_DRAW );
+
+	int counts[3] = { 0, 0, 0 };
+	for ( size_t i = 0; i < classes.size(); ++i )
+		++counts[classes[i]];
+	std::cout << "Info: " << warp_blend->channel << " warp tiles: " << counts[TILE_PASS_THROUGH] << " pass-through, "
+		<< counts[TILE_BLACK] << " black, " << counts[TILE_PARTIAL] << " partial, drawn as "
+		<< pass_through_runs.size() + black_runs_.size() + partial_runs.size() << " rectangles." << std::endl;
+	return true;
+}
+
+bool WarpRenderer::IsReady()
+{
+	if ( 0 == warp_texture_ || ( post_chain_ && !post_chain_->IsReady() ) || ( exposure_ && !histogram_.IsReady() )
+		|| ( mip_levels_ > 0 && !mips_.IsReady() ) )
+		return false;
+	if ( programs_ready_ )
+		return true;
+
+	partial_.program.TakeReady();
+	pass_through_.program.TakeReady();
+	if ( !partial_.program.IsValid() || !pass_through_.program.IsValid() )
+		return false;
+
+	partial_.LookUpUniforms();
+	pass_through_.LookUpUniforms();
+	programs_ready_ = true;
+	return true;
+}
+
+void WarpRenderer::Unload()
+{
+	partial_.program.Release();
+	pass_through_.program.Release();
+	histogram_.Unload();
+	mips_.Unload();
+	if ( warp_texture_ )		glDeleteTextures(     1, &warp_texture_     );
+	if ( blend_texture_ )		glDeleteTextures(     1, &blend_texture_    );
+	if ( footprint_texture_ )	glDeleteTextures(     1, &footprint_texture_ );
+	if ( copy_texture_ )		glDeleteTextures(     1, &copy_texture_     );
+	if ( copy_framebuffer_ )	glDeleteFramebuffers( 1, &copy_framebuffer_ );
+	if ( vertex_buffer_ )		glDeleteBuffers(      1, &vertex_buffer_    );
+	if ( vertex_array_ )		glDeleteVertexArrays( 1, &vertex_array_     );
+
+	warp_texture_ = blend_texture_ = footprint_texture_ = copy_texture_ = copy_framebuffer_ = vertex_buffer_ = vertex_array_ = 0;
+	copy_width_ = copy_height_ = 0;
+	partial_vertices_ = pass_through_vertices_ = 0;
+	black_runs_.clear();
+	programs_ready_ = false;
+	post_chain_ = nullptr;
+	exposure_ = nullptr;
+	cube_ = false;
+	stereo_ = false;
+	temporal_ = false;
+	mip_levels_ = 0;
+	max_footprint_[0] = max_footprint_[1] = 0.0f;
+}
+
+void WarpRenderer::Render( GLuint source_framebuffer, GLuint source_color, const int source_rect[4], GLuint target_framebuffer, int width, int height,
+	const GLfloat view_proj[16], GlStateCache& gl_state )
+{
+	const int source_width = source_rect[2];
+	const int source_height = source_rect[3];
+	// a cube map is looked up by direction, its group's scene is only measured; stereo eyes are read as they are
+	const GLuint source_texture = cube_source_ || stereo_source_ ? source_color : PrepareSource( source_framebuffer, source_color, source_rect, gl_state );
+	gl_state.Disable( GL_SCISSOR_TEST );
+	if ( exposure_ && !stereo_source_ )
+	{
+		// results of earlier frames, then this frame's channel, the periphery alone if foveated
+		float average_log = 0.0f;
+		while ( histogram_.TakeResult( average_log ) )
+			exposure_->AddSample( average_log );
+		const int rect[4] = { 0, 0, foveated_layout_ ? foveated_layout_->periphery[0] : source_width, foveated_layout_ ? foveated_layout_->periphery[1] : source_height };
+		if ( source_texture )
+			histogram_.Analyze( source_texture, rect, gl_state );
+	}
+	// only the levels the compressed parts of the channel read, none where the warp never minifies
+	int mip_levels = 0;
+	GLuint mips_texture = 0;
+	if ( mip_levels_ > 0 && !cube_source_ && source_texture )
+	{
+		mip_levels = CountMipLevels( width, height, source_width, source_height );
+		if ( mip_levels > 0 )
+			mips_texture = mips_.Build( source_texture, source_width, source_height, mip_levels, gl_state );
+	}
+	gl_state.BindFramebuffer( target_framebuffer );
+	gl_state.Viewport( 0, 0, width, height );
+
+	// black tiles, rounded outwards: the tiles drawn next overwrite any overlap; of a stereo window in each eye's part
+	const int eyes = stereo_source_ ? 2 : 1;
+	if ( !black_runs_.empty() )
+	{
+		gl_state.ClearColor( 0.0f, 0.0f, 0.0f, 1.0f );
+		gl_state.Enable( GL_SCISSOR_TEST );
+		for ( int eye = 0; eye < eyes; ++eye )
+		{
+			const float* rect = stereo_source_ ? stereo_source_->eye_rects[eye] : nullptr;
+			const int eye_x = rect ? (int)( rect[0] * width ) : 0;
+			const int eye_y = rect ? (int)( rect[1] * height ) : 0;
+			const int eye_width = rect ? (int)( rect[2] * width ) : width;
+			const int eye_height = rect ? (int)( rect[3] * height ) : height;
+			for ( size_t i = 0; i < black_runs_.size(); ++i )
+			{
+				const Run& run = black_runs_[i];
+				const int left = run.x * eye_width / map_width_;
+				const int right = ( ( run.x + run.width ) * eye_width + map_width_ - 1 ) / map_width_;
+				const int top = run.y * eye_height / map_height_;
+				const int bottom = ( ( run.y + run.height ) * eye_height + map_height_ - 1 ) / map_height_;
+				gl_state.Scissor( eye_x + left, eye_y + eye_height - bottom, right - left, bottom - top );
+				glClear( GL_COLOR_BUFFER_BIT );
+			}
+		}
+		gl_state.Disable( GL_SCISSOR_TEST );
+	}
+
+	if ( 0 == partial_vertices_ && 0 == pass_through_vertices_ )
+		return;
+
+	gl_state.Disable( GL_DEPTH_TEST );
+	gl_state.Disable( GL_BLEND );
+	gl_state.Disable( GL_CULL_FACE );
+	gl_state.Disable( GL_SAMPLE_ALPHA_TO_COVERAGE_ARB );
+	if ( 0 == vertex_array_ )
+	{
+		// contexts do not share vertex arrays, so it is made by the one that draws
+		glGenVertexArrays( 1, &vertex_array_ );
+		glVertexArrayVertexAttribOffsetEXT( vertex_array_, vertex_buffer_, 0, 2, GL_FLOAT, GL_FALSE, 0, 0 );
+		glEnableVertexArrayAttribEXT( vertex_array_, 0 );
+	}
+	gl_state.BindVertexArray( vertex_array_ );
+	if ( stereo_source_ )
+		gl_state.BindMultiTexture2DArray( source_texture );
+	else
+		gl_state.BindMultiTexture2D( kSourceUnit, source_texture );
+	gl_state.BindMultiTexture2D( kWarpUnit, warp_texture_ );
+	gl_state.BindMultiTexture2D( kBlendUnit, blend_texture_ );
+	if ( cube_ )
+		gl_state.BindMultiTextureCube( cube_source_ ? cube_source_->texture : 0 );
+	if ( mip_levels_ > 0 )
+	{
+		gl_state.BindMultiTexture2D( kMipsUnit, mips_texture );
+		gl_state.BindMultiTexture2D( kFootprintUnit, footprint_texture_ );
+	}
+	if ( temporal_source_ )
+		glBindImageTexture( kHistoryImageUnit, temporal_source_->history, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA8 );
+
+	if ( partial_vertices_ )
+	{
+		SetUniforms( partial_, width, height, source_width, source_height, mip_levels, view_proj, gl_state );
+		glDrawArraysInstanced( GL_TRIANGLES, 0, partial_vertices_, eyes );
+	}
+	if ( pass_through_vertices_ )
+	{
+		SetUniforms( pass_through_, width, height, source_width, source_height, mip_levels, view_proj, gl_state );
+		glDrawArraysInstanced( GL_TRIANGLES, partial_vertices_, pass_through_vertices_, eyes );
+	}
+	// the next frame's warp reads what this one stored
+	if ( temporal_source_ )
+		glMemoryBarrier( GL_SHADER_IMAGE_ACCESS_BARRIER_BIT );
+}
+
+GLuint WarpRenderer::PrepareSource( GLuint source_framebuffer, GLuint source_color, const int source_rect[4], GlStateCache& gl_state )
+{
+	const int source_width = source_rect[2];
+	const int source_height = source_rect[3];
+	gl_state.Disable( GL_SCISSOR_TEST );
+	if ( 0 != source_rect[0] || 0 != source_rect[1] )
+	{
+		// a part of a larger scene, moved to the lower left of the copy that everything else reads
+		UpdateCopy( source_width, source_height );
+		gl_state.BindFramebuffer( source_framebuffer );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, copy_framebuffer_ );
+		glBlitFramebuffer( source_rect[0], source_rect[1], source_rect[0] + source_width, source_rect[1] + source_height,
+			0, 0, source_width, source_height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+		source_framebuffer = copy_framebuffer_;
+		source_color = copy_texture_;
+	}
+
+	// the leading post passes leave their result in a texture the warp can read directly, all of
+	// them write it back into the source if the warp resolves
+	GLuint source_texture = post_chain_ ? post_chain_->Apply( source_framebuffer, source_color, source_width, source_height, !temporal_, gl_state ) : 0;
+	if ( 0 == source_texture )
+		source_texture = source_color;
+	gl_state.Disable( GL_SCISSOR_TEST );
+	if ( 0 == source_texture )
+	{
+		// the blit also resolves a multisampled source
+		UpdateCopy( source_width, source_height );
+		gl_state.BindFramebuffer( source_framebuffer );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, copy_framebuffer_ );
+		glBlitFramebuffer( 0, 0, source_width, source_height, 0, 0, source_width, source_height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+		gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+		source_texture = copy_texture_;
+	}
+	return source_texture;
+}
+
+void WarpRenderer::SetUniforms( const WarpProgram& warp_program, int width, int height, int source_width, int source_height, int mip_levels,
+	const GLfloat view_proj[16], GlStateCache& gl_state ) const
+{
+	gl_state.UseProgram( warp_program.program.GetId() );
+	glUniform2f( warp_program.size_location, (GLfloat)width, (GLfloat)height );
+	glUniformMatrix4fv( warp_program.view_proj_location, 1, GL_FALSE, view_proj );
+	glUniform1f( warp_program.warp_scale_location, warp_scale_ );
+	if ( source_region_ )
+		glUniform4fv( warp_program.source_region_location, 1, source_region_ );
+	else
+		glUniform4f( warp_program.source_region_location, 0.0f, 0.0f, 1.0f, 1.0f );
+	if ( cube_ )
+		glUniform1f( warp_program.cube_enabled_location, cube_source_ ? 1.0f : 0.0f );
+	if ( stereo_source_ )
+	{
+		// each eye sees the map from its own position
+		glUniform4fv( warp_program.eye_rects_location, 2, &stereo_source_->eye_rects[0][0] );
+		glUniformMatrix4fv( warp_program.view_proj_location, 1, GL_FALSE, stereo_source_->view_proj[0] );
+		glUniformMatrix4fv( warp_program.view_proj_right_location, 1, GL_FALSE, stereo_source_->view_proj[1] );
+	}
+	if ( cube_source_ )
+	{
+		// post effects step by output pixels
+		glUniformMatrix3fv( warp_program.channel_to_eye_location, 1, GL_FALSE, cube_source_->channel_to_eye );
+		glUniform4fv( warp_program.channel_tangents_location, 1, cube_source_->tangents );
+		glUniform2f( warp_program.source_texel_location, 1.0f / width, 1.0f / height );
+	}
+	else if ( foveated_layout_ )
+	{
+		// the source is the periphery, the inset lies next to it
+		const FoveatedLayout& layout = *foveated_layout_;
+		glUniform2f( warp_program.source_texel_location, 1.0f / layout.periphery[0], 1.0f / layout.periphery[1] );
+		glUniform4f( warp_program.inset_location, layout.inset_channel[0], layout.inset_channel[1], layout.inset_channel[2], layout.inset_channel[3] );
+		glUniform4f( warp_program.inset_source_location, (GLfloat)layout.inset[0], (GLfloat)layout.inset[1], (GLfloat)layout.inset[2], (GLfloat)layout.inset[3] );
+		glUniform1f( warp_program.inset_border_location, std::max( layout.border, 1.0f / 1024.0f ) );
+	}
+	else
+	{
+		// a foveated program without a layout keeps its inset outside the channel
+		glUniform2f( warp_program.source_texel_location, 1.0f / source_width, 1.0f / source_height );
+		if ( foveated_ )
+			glUniform4f( warp_program.inset_location, 2.0f, 2.0f, 1.0f, 1.0f );
+	}
+	if ( post_chain_ && !temporal_ )
+		glUniform1f( warp_program.post_seed_location, post_chain_->GetSeed() );
+	if ( temporal_ )
+	{
+		glUniform1f( warp_program.temporal_enabled_location, temporal_source_ ? 1.0f : 0.0f );
+		glUniform1f( warp_program.feedback_location, temporal_source_ ? temporal_source_->feedback : 0.0f );
+	}
+	if ( upscale_ )
+		glUniform1f( warp_program.sharpness_location, sharpness_ );
+	if ( exposure_ )
+		glUniform1f( warp_program.exposure_location, exposure_->GetExposure() );
+	if ( mip_levels_ > 0 )
+	{
+		// map pixels per output pixel, and the source covers only its region of the channel
+		const float map_per_pixel = std::max( (float)map_width_ / width, (float)map_height_ / height );
+		const float region_width = source_region_ ? source_region_[2] : 1.0f;
+		const float region_height = source_region_ ? source_region_[3] : 1.0f;
+		glUniform2f( warp_program.footprint_scale_location, source_width / region_width * map_per_pixel, source_height / region_height * map_per_pixel );
+		glUniform1f( warp_program.max_lod_location, (GLfloat)mip_levels );
+		if ( mip_levels > 0 )
+			glUniform2f( warp_program.mips_scale_location, 0.5f * source_width / mips_.GetWidth(), 0.5f * source_height / mips_.GetHeight() );
+	}
+}
+
+int WarpRenderer::CountMipLevels( int width, int height, int source_width, int source_height ) const
+{
+	// 3D maps are minified depending on the view, they get every level
+	if ( is_3d_ )
+		return mip_levels_;
+
+	const float map_per_pixel = std::max( (float)map_width_ / width, (float)map_height_ / height );
+	const float region_width = source_region_ ? source_region_[2] : 1.0f;
+	const float region_height = source_region_ ? source_region_[3] : 1.0f;
+	const float footprint = std::max( max_footprint_[0] * source_width / region_width, max_footprint_[1] * source_height / region_height ) * map_per_pixel;
+	if ( footprint <= 1.0f )
+		return 0;
+	return std::min( (int)std::ceil( std::log2( footprint ) ), mip_levels_ );
+}
+
+void WarpRenderer::UploadWarp( const VWB_WarpBlend& warp_blend, float max_warp_error, int output_width, int output_height )
+{
+	const int pixels = map_width_ * map_height_;
+	if ( is_3d_ )
+	{
+		// world positions have no identity to be relative to, drop only the validity
+		std::vector<GLfloat> positions( pixels * 3 );
+		for ( int i = 0; i < pixels; ++i )
+		{
+			positions[i * 3 + 0] = warp_blend.pWarp[i].x;
+			positions[i * 3 + 1] = warp_blend.pWarp[i].y;
+			positions[i * 3 + 2] = warp_blend.pWarp[i].z;
+		}
+		warp_texture_ = CreateTexture( GL_RGB32F, map_width_, map_height_, GL_RGB, GL_FLOAT, &positions[0] );
+		warp_scale_ = 1.0f;
+		std::cout << "Info: " << warp_blend.channel << " warp map: 3D positions, 12 bytes per pixel." << std::endl;
+		return;
+	}
+
+	// offsets from the identity grid, invalid pixels are blended to black and get none
+	std::vector<GLfloat> offsets( pixels * 2, 0.0f );
+	float max_offset = 0.0f;
+	for ( int y = 0; y < map_height_; ++y )
+	{
+		for ( int x = 0; x < map_width_; ++x )
+		{
+			const int i = y * map_width_ + x;
+			const VWB_WarpRecord& warp = warp_blend.pWarp[i];
+			if ( warp.z <= 0.5f )
+				continue;
+			offsets[i * 2 + 0] = warp.x - ( x + 0.5f ) / map_width_;
+			offsets[i * 2 + 1] = warp.y - ( y + 0.5f ) / map_height_;
+			max_offset = std::max( max_offset, std::max( std::fabs( offsets[i * 2 + 0] ), std::fabs( offsets[i * 2 + 1] ) ) );
+		}
+	}
+
+	// worst case error of both 16 bit encodings, in output pixels: the map spans the window, so
+	// an offset error of one map pixel is output / map pixels there
+	const float output_size[2] = {
+		(float)( output_width > 0 ? output_width : map_width_ ),
+		(float)( output_height > 0 ? output_height : map_height_ ) };
+	const float fixed_scale = max_offset > 0.0f ? max_offset : 1.0f;
+	std::vector<GLshort> fixed( pixels * 2 );
+	std::vector<GLushort> halves( pixels * 2 );
+	float fixed_error = 0.0f;
+	float half_error = 0.0f;
+	for ( int i = 0; i < pixels * 2; ++i )
+	{
+		const float pixel_size = output_size[i & 1];
+		fixed[i] = (GLshort)std::floor( offsets[i] / fixed_scale * 32767.0f + 0.5f );
+		halves[i] = FloatToHalf( offsets[i] );
+		fixed_error = std::max( fixed_error, std::fabs( fixed[i] / 32767.0f * fixed_scale - offsets[i] ) * pixel_size );
+		half_error = std::max( half_error, std::fabs( HalfToFloat( halves[i] ) - offsets[i] ) * pixel_size );
+	}
+
+	if ( fixed_error <= max_warp_error && fixed_error <= half_error )
+	{
+		warp_texture_ = CreateTexture( GL_RG16_SNORM, map_width_, map_height_, GL_RG, GL_SHORT, &fixed[0] );
+		warp_scale_ = fixed_scale;
+		std::cout << "Info: " << warp_blend.channel << " warp map: RG16 fixed point offsets, 4 bytes per pixel, worst error "
+			<< fixed_error << " output px (bound " << max_warp_error << " px)." << std::endl;
+	}
+	else if ( half_error <= max_warp_error )
+	{
+		warp_texture_ = CreateTexture( GL_RG16F, map_width_, map_height_, GL_RG, GL_HALF_FLOAT, &halves[0] );
+		warp_scale_ = 1.0f;
+		std::cout << "Info: " << warp_blend.channel << " warp map: RG16F offsets, 4 bytes per pixel, worst error "
+			<< half_error << " output px (bound " << max_warp_error << " px)." << std::endl;
+	}
+	else
+	{
+		// the offsets as computed, nothing is lost to the encoding
+		warp_texture_ = CreateTexture( GL_RG32F, map_width_, map_height_, GL_RG, GL_FLOAT, &offsets[0] );
+		warp_scale_ = 1.0f;
+		std::cout << "Info: " << warp_blend.channel << " warp map: RG32F offsets, 8 bytes per pixel, exact. The 16 bit encodings err by "
+			<< std::min( fixed_error, half_error ) << " output px (bound " << max_warp_error << " px)." << std::endl;
+	}
+}
+
+void WarpRenderer::UploadFootprint( const VWB_WarpBlend& warp_blend )
+{
+	// central differences of the source coordinates, one-sided next to invalid pixels
+	const int pixels = map_width_ * map_height_;
+	std::vector<GLushort> footprint( pixels * 2, 0 );
+	max_footprint_[0] = max_footprint_[1] = 0.0f;
+	for ( int y = 0; y < map_height_; ++y )
+	{
+		for ( int x = 0; x < map_width_; ++x )
+		{
+			const int i = y * map_width_ + x;
+			if ( warp_blend.pWarp[i].z <= 0.5f )
+				continue;
+
+			float along_x[2] = { 0.0f, 0.0f };
+			float along_y[2] = { 0.0f, 0.0f };
+			Difference( warp_blend, x, y, 1, 0, along_x );
+			Difference( warp_blend, x, y, 0, 1, along_y );
+			const float extent[2] = { std::max( std::fabs( along_x[0] ), std::fabs( along_y[0] ) ), std::max( std::fabs( along_x[1] ), std::fabs( along_y[1] ) ) };
+			footprint[i * 2 + 0] = FloatToHalf( extent[0] );
+			footprint[i * 2 + 1] = FloatToHalf( extent[1] );
+			max_footprint_[0] = std::max( max_footprint_[0], extent[0] );
+			max_footprint_[1] = std::max( max_footprint_[1], extent[1] );
+		}
+	}
+	footprint_texture_ = CreateTexture( GL_RG16F, map_width_, map_height_, GL_RG, GL_HALF_FLOAT, &footprint[0] );
+	std::cout << "Info: " << warp_blend.channel << " warp compresses a source at map resolution up to "
+		<< std::max( max_footprint_[0] * map_width_, max_footprint_[1] * map_height_ ) << " times." << std::endl;
+}
+
+void WarpRenderer::UpdateCopy( int width, int height )
+{
+	// only grows: a dynamically scaled source is copied into the lower left
+	if ( copy_texture_ && copy_width_ >= width && copy_height_ >= height )
+		return;
+
+	width = std::max( width, copy_width_ );
+	height = std::max( height, copy_height_ );
+
+	if ( 0 == copy_texture_ )
+	{
+		copy_texture_ = CreateTexture( GL_RGBA8, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+		glGenFramebuffers( 1, &copy_framebuffer_ );
+		glNamedFramebufferTextureEXT( copy_framebuffer_, GL_COLOR_ATTACHMENT0, copy_texture_, 0 );
+	}
+	else
+	{
+		glTextureImage2DEXT( copy_texture_, GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+	}
+	copy_width_ = width;
+	copy_height_ = height;
+}
+
+void WarpRenderer::Classify( const VWB_WarpBlend& warp_blend, bool is_3d, int tile_size, std::vector<unsigned char>& classes, int& columns, int& rows )
+{
+	const int width = warp_blend.header.width;
+	const int height = warp_blend.header.height;
+	columns = ( width + tile_size - 1 ) / tile_size;
+	rows = ( height + tile_size - 1 ) / tile_size;
+	classes.assign( columns * rows, TILE_PARTIAL );
+
+	for ( int row = 0; row < rows; ++row )
+	{
+		for ( int column = 0; column < columns; ++column )
+		{
+			// one pixel beyond the tile, for the filtering when the window size differs from the map
+			const int x0 = std::max( column * tile_size - 1, 0 );
+			const int x1 = std::min( ( column + 1 ) * tile_size + 1, width );
+			const int y0 = std::max( row * tile_size - 1, 0 );
+			const int y1 = std::min( ( row + 1 ) * tile_size + 1, height );
+
+			bool any_light = false;
+			bool all_full = true;
+			for ( int y = y0; y < y1 && ( all_full || !any_light ); ++y )
+			{
+				for ( int x = x0; x < x1; ++x )
+				{
+					const VWB_WarpRecord& warp = warp_blend.pWarp[y * width + x];
+					const VWB_BlendRecord2& weight = warp_blend.pBlend[y * width + x];
+					const bool valid = ( is_3d ? warp.w : warp.z ) > 0.5f;
+					if ( valid && ( 0.0f != weight.r || 0.0f != weight.g || 0.0f != weight.b ) )
+						any_light = true;
+					if ( !valid || 1.0f != weight.r || 1.0f != weight.g || 1.0f != weight.b )
+						all_full = false;
+				}
+			}
+			classes[row * columns + column] = (unsigned char)( !any_light ? TILE_BLACK : all_full ? TILE_PASS_THROUGH : TILE_PARTIAL );
+		}
+	}
+}
+
+void WarpRenderer::MergeRuns( const std::vector<unsigned char>& classes, int columns, int rows, TileClass tile_class, int tile_size,
+	int map_width, int map_height, std::vector<Run>& runs )
+{
+	// spans along each tile row, grown downwards while the row below has the same span
+	std::vector<Run> tiles;
+	std::vector<size_t> open;
+	std::vector<size_t> next_open;
+	for ( int row = 0; row < rows; ++row )
+	{
+		next_open.clear();
+		for ( int column = 0; column < columns; )
+		{
+			if ( tile_class != classes[row * columns + column] )
+			{
+				++column;
+				continue;
+			}
+			const int first = column;
+			while ( column < columns && tile_class == classes[row * columns + column] )
+				++column;
+
+			size_t match = tiles.size();
+			for ( size_t i = 0; i < open.size(); ++i )
+			{
+				if ( first == tiles[open[i]].x && column - first == tiles[open[i]].width )
+				{
+					match = open[i];
+					break;
+				}
+			}
+			if ( tiles.size() == match )
+			{
+				const Run run = { first, row, column - first, 1 };
+				tiles.push_back( run );
+			}
+			else
+			{
+				++tiles[match].height;
+			}
+			next_open.push_back( match );
+		}
+		open.swap( next_open );
+	}
+
+	runs.clear();
+	for ( size_t i = 0; i < tiles.size(); ++i )
+	{
+		const Run& tile = tiles[i];
+		const int x = tile.x * tile_size;
+		const int y = tile.y * tile_size;
+		const Run run = { x, y, std::min( ( tile.x + tile.width ) * tile_size, map_width ) - x, std::min( ( tile.y + tile.height ) * tile_size, map_height ) - y };
+		runs.push_back( run );
+	}
+}
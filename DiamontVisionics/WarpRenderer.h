@@ -0,0 +1,230 @@
+//==============================================================================
+// File:WarpRenderer.h
+//==============================================================================
+//
+// Description: Warps and blends a channel with the maps of its VIOSO warper,
+//				instead of VWB_render. At load time the output is classified
+//				into tiles: black tiles (outside the used area or blended to
+//				zero) are cleared, pass-through tiles (blend exactly 1.0) only
+//				warp, and the full warp and blend runs on the partial tiles of
+//				the overlap strips alone. The last pass of the post effects runs
+//				in the same shaders, and so does the upscale of a scene rendered
+//				below the window resolution, the adapted exposure, the lookup of a
+//				channel in its group's cube map, and the temporal resolve of a
+//				jittered scene. Where the warp compresses the source, it reads the
+//				levels of a mip chain built for it.
+//
+//==============================================================================
+
+#ifndef DVC_WARP_RENDERER_H
+#define DVC_WARP_RENDERER_H
+
+#include "ExposureControl.h"
+#include "ExternalFbo.h"
+#include "GlProgram.h"
+#include "GlProgramCache.h"
+#include "GlStateCache.h"
+#include "LuminanceHistogram.h"
+#include "PostChain.h"
+#include "SourceMips.h"
+
+#include <vector>
+
+class WarpRenderer
+{
+public:
+	WarpRenderer();
+
+	/*!
+	 * Reads the warper's warp and blend maps, classifies the tiles and uploads everything.
+	 * Needs a current context, any sharing objects with the one that renders.
+	 *
+	 * @return
+	 *  false if the maps cannot be used here (not exposed, black level or white
+	 *  compensation), VWB_render has to warp this channel then.
+	**/
+	bool Load( VWB_Warper* warper, const WarpSettings& settings );
+
+	/*! Needs the context that rendered, if any. **/
+	void Unload();
+
+	/*!
+	 * True once the maps are loaded and all programs, the post effects' too, are ready. They can
+	 * be compiling in the background for a while after Load, VWB_render has to warp this channel
+	 * until then.
+	**/
+	bool IsReady();
+
+	/*!
+	 * Runs the post effects and warps the color of source_framebuffer into target_framebuffer.
+	 * Both may be the same. A smaller source is upscaled if the settings had a render scale.
+	 *
+	 * @param[in] source_color : the color of source_framebuffer if it is a single-sampled texture
+	 *  other than the target's, read in place. 0 copies it first.
+	 * @param[in] source_rect : x, y, width and height in pixels of the source in source_framebuffer.
+	 *  A source away from the lower left is copied first.
+	 * @param[in] width, height : size of target_framebuffer in pixels
+	 * @param[in] view_proj : projection * view of the warper, column-major, used by 3D maps
+	**/
+	void Render( GLuint source_framebuffer, GLuint source_color, const int source_rect[4], GLuint target_framebuffer, int width, int height,
+		const GLfloat view_proj[16], GlStateCache& gl_state );
+
+	/*!
+	 * Makes the next renders composite a foveated source, see FoveationSettings. The layout must
+	 * stay valid until then, null renders the source as one image.
+	**/
+	void SetFoveatedLayout( const FoveatedLayout* layout ) { foveated_layout_ = layout; }
+
+	/*!
+	 * Makes the next renders look the channel up in a cube map, see CubeMapSource. The source
+	 * passed to Render is then only measured for the exposure, source_color may be 0. The source
+	 * must stay valid until then, null renders from the source again.
+	**/
+	void SetCubeMapSource( const CubeMapSource* cube ) { cube_source_ = cube; }
+
+	/*!
+	 * Makes the next renders read a source that covers only part of the channel: x, y, width and
+	 * height, 0-1 from the lower left. The region must stay valid until then, null is the whole
+	 * channel.
+	**/
+	void SetSourceRegion( const float* region ) { source_region_ = region; }
+
+	/*!
+	 * Makes the next renders warp both eyes of a stereo window, see StereoSource, if the settings
+	 * had a stereo layout. source_color passed to Render is then its texture, read as it is. The
+	 * source must stay valid until then, null renders mono again.
+	**/
+	void SetStereoSource( const StereoSource* stereo ) { stereo_source_ = stereo; }
+
+	/*!
+	 * True if the settings had a temporal feedback and the programs resolve the scene as they
+	 * warp it, instead of a pass of TemporalResolve before.
+	**/
+	bool IsTemporal() const { return temporal_; }
+
+	/*!
+	 * Makes the next renders blend the source into a history, see TemporalSource. The source
+	 * must stay valid until then, null warps the source as it is.
+	**/
+	void SetTemporalSource( const TemporalSource* temporal ) { temporal_source_ = temporal; }
+
+private:
+	WarpRenderer( const WarpRenderer& );
+	WarpRenderer& operator=( const WarpRenderer& );
+
+	enum TileClass
+	{
+		TILE_BLACK = 0,
+		TILE_PASS_THROUGH,
+		TILE_PARTIAL
+	};
+
+	/*! A rectangle of tiles of one class, in map pixels, top row first. **/
+	struct Run
+	{
+		int x, y, width, height;
+	};
+
+	struct WarpProgram
+	{
+		WarpProgram();
+		void LookUpUniforms();
+
+		GlProgram program;
+		GLint size_location;
+		GLint view_proj_location;
+		GLint warp_scale_location;
+		GLint source_texel_location;
+		GLint source_region_location;
+		GLint post_seed_location;
+		GLint sharpness_location;
+		GLint inset_location;
+		GLint inset_source_location;
+		GLint inset_border_location;
+		GLint exposure_location;
+		GLint cube_enabled_location;
+		GLint channel_to_eye_location;
+		GLint channel_tangents_location;
+		GLint footprint_scale_location;
+		GLint max_lod_location;
+		GLint mips_scale_location;
+		GLint eye_rects_location;
+		GLint view_proj_right_location;
+		GLint temporal_enabled_location;
+		GLint feedback_location;
+	};
+
+	/*!
+	 * Moves the source to the lower left of a texture and runs the leading post passes on it.
+	 *
+	 * @return
+	 *  the texture the warp reads
+	**/
+	GLuint PrepareSource( GLuint source_framebuffer, GLuint source_color, const int source_rect[4], GlStateCache& gl_state );
+
+	/*!
+	 * @param[in] mip_levels : levels built below the source for this render
+	**/
+	void SetUniforms( const WarpProgram& warp_program, int width, int height, int source_width, int source_height, int mip_levels,
+		const GLfloat view_proj[16], GlStateCache& gl_state ) const;
+
+	/*!
+	 * The levels below the source the warp reads at this output and source size, 0 if it never
+	 * minifies.
+	**/
+	int CountMipLevels( int width, int height, int source_width, int source_height ) const;
+
+	/*!
+	 * Uploads the 2D maps in the smallest encoding whose worst error stays within max_warp_error
+	 * pixels of an output_width by output_height window, 0 measures it in map pixels.
+	**/
+	void UploadWarp( const VWB_WarpBlend& warp_blend, float max_warp_error, int output_width, int output_height );
+	void UploadFootprint( const VWB_WarpBlend& warp_blend );
+	void UpdateCopy( int width, int height );
+
+	static void Classify( const VWB_WarpBlend& warp_blend, bool is_3d, int tile_size, std::vector<unsigned char>& classes, int& columns, int& rows );
+	static void MergeRuns( const std::vector<unsigned char>& classes, int columns, int rows, TileClass tile_class, int tile_size,
+		int map_width, int map_height, std::vector<Run>& runs );
+
+	bool is_3d_;					/* the warp map holds world positions, not source coordinates */
+	int map_width_;
+	int map_height_;
+
+	GLuint warp_texture_;			/* 2D maps as offsets from the identity, in the smallest encoding within the error bound */
+	GLuint blend_texture_;
+	GLfloat warp_scale_;			/* decodes fixed point offsets */
+	bool programs_ready_;			/* samplers set and uniforms looked up */
+	PostChain* post_chain_;			/* runs its last pass in the warp programs, null without effects */
+	bool upscale_;					/* the source is rendered below the window resolution */
+	bool foveated_;					/* the programs composite a gaze inset, see SetFoveatedLayout */
+	const FoveatedLayout* foveated_layout_;
+	ExposureControl* exposure_;		/* the programs tone map, null without exposure adaptation */
+	LuminanceHistogram histogram_;	/* measures the source for exposure_ */
+	bool cube_;						/* the programs can look the channel up in a cube map */
+	const CubeMapSource* cube_source_;
+	const float* source_region_;	/* see SetSourceRegion */
+	bool stereo_;					/* the programs read a layer per eye and draw an instance each */
+	const StereoSource* stereo_source_;
+	bool temporal_;					/* the programs resolve a jittered scene, see SetTemporalSource */
+	const TemporalSource* temporal_source_;
+	int mip_levels_;				/* most levels the programs read below the source, 0 without a chain */
+	SourceMips mips_;
+	GLuint footprint_texture_;		/* 2D maps: extent of each map pixel in the channel, x and y */
+	float max_footprint_[2];
+	GLfloat sharpness_;
+	GLuint copy_texture_;			/* the unwarped channel, the target is usually the same framebuffer */
+	GLuint copy_framebuffer_;
+	int copy_width_;
+	int copy_height_;
+
+	GLuint vertex_array_;			/* of the rendering context, made by the first Render */
+	GLuint vertex_buffer_;			/* partial tiles first, then the pass-through tiles */
+	GLsizei partial_vertices_;
+	GLsizei pass_through_vertices_;
+	std::vector<Run> black_runs_;
+
+	WarpProgram partial_;
+	WarpProgram pass_through_;
+};
+
+#endif // DVC_WARP_RENDERER_H
@@ -0,0 +1,427 @@
+//==============================================================================
+// File:WarpThread.cpp
+//==============================================================================
+
+#include "WarpThread.h"
+#include "WarpRenderer.h"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined( _WIN32 )
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#endif
+
+namespace
+{
+	GLuint CreateTexture( int width, int height )
+	{
+		GLuint tex = 0;
+		glGenTextures( 1, &tex );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
+		glTextureParameteriEXT( tex, GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+		glTextureImage2DEXT( tex, GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr );
+		return tex;
+	}
+}
+
+WarpThread::WarpThread()
+	: dc_( nullptr )
+	, context_( nullptr )
+	, stopping_( false )
+{
+}
+
+WarpThread::~WarpThread()
+{
+	// no context guaranteed here, Stop() is the owner's job
+}
+
+bool WarpThread::Start( const WarpSettings& settings )
+{
+	Stop();
+
+	// what needs the render thread's state or a scene layout of its own stays there
+	settings_ = settings;
+	settings_.post_chain = nullptr;
+	settings_.exposure = nullptr;
+	settings_.cube_map = false;
+	settings_.foveation.inset_view = -1;
+
+#if defined( _WIN32 )
+	// a fresh context, so sharing with the caller's is always allowed
+	HDC dc = wglGetCurrentDC();
+	HGLRC context = wglGetCurrentContext();
+	HGLRC warp_context = dc && context ? wglCreateContext( dc ) : nullptr;
+	if ( nullptr == warp_context || !wglShareLists( context, warp_context ) )
+	{
+		std::cout << "Warning: could not create a shared GL context, windows are warped on the render thread." << std::endl;
+		if ( warp_context )
+			wglDeleteContext( warp_context );
+		return false;
+	}
+	dc_ = dc;
+	context_ = warp_context;
+	stopping_ = false;
+	thread_ = std::thread( &WarpThread::Run, this );
+	std::cout << "Info: windows are warped on a thread, one frame behind the render thread." << std::endl;
+	return true;
+#else
+	return false;
+#endif
+}
+
+void WarpThread::Stop()
+{
+	if ( thread_.joinable() )
+	{
+		{
+			std::lock_guard<std::mutex> lock( mutex_ );
+			stopping_ = true;
+		}
+		wake_.notify_all();
+		thread_.join();
+	}
+	queue_.clear();
+
+	// the thread has released its own objects, the textures and fences belong to this context
+	for ( std::map<int, Channel>::iterator it = channels_.begin(); it != channels_.end(); ++it )
+	{
+		for ( int i = 0; i < kSlots; ++i )
+			ReleaseSlot( it->second.slots[i] );
+	}
+	channels_.clear();
+
+#if defined( _WIN32 )
+	if ( context_ )
+		wglDeleteContext( (HGLRC)context_ );
+#endif
+	dc_ = nullptr;
+	context_ = nullptr;
+}
+
+WarpThread::Channel& WarpThread::GetChannel( int window_id )
+{
+	std::map<int, Channel>::iterator found = channels_.find( window_id );
+	if ( channels_.end() != found )
+		return found->second;
+
+	Channel& channel = channels_[window_id];
+	channel.width = channel.height = 0;
+	for ( int i = 0; i < kSlots; ++i )
+	{
+		Slot& slot = channel.slots[i];
+		slot.scene_texture = slot.output_texture = 0;
+		glGenFramebuffers( 1, &slot.scene_framebuffer );
+		glGenFramebuffers( 1, &slot.present_framebuffer );
+		slot.scene_width = slot.scene_height = 0;
+		slot.ready = slot.done = 0;
+		slot.warper = nullptr;
+		slot.trimmed = slot.queued = slot.warped = false;
+		slot.frame_index = 0;
+	}
+	channel.next_slot = 0;
+	channel.pending_width = channel.pending_height = 0;
+	channel.loading = false;
+	channel.output_framebuffer = 0;
+	return channel;
+}
+
+bool WarpThread::Submit( int window_id, unsigned int frame_index, const ExternalFbo& fbo, GLuint source_framebuffer, GlStateCache& gl_state )
+{
+	if ( !IsRunning() )
+		return false;
+
+	// a new window size waits for the frames on their way
+	Channel& channel = GetChannel( window_id );
+	if ( channel.width != (int)fbo.GetWidth() || channel.height != (int)fbo.GetHeight() )
+	{
+		Drain( channel );
+		UpdateOutput( channel, fbo.GetWidth(), fbo.GetHeight() );
+	}
+
+	// this frame's scene into the free slot, the copy also resolves a multisampled one
+	Slot& slot = channel.slots[channel.next_slot];
+	Slot& previous = channel.slots[( channel.next_slot + 1 ) % kSlots];
+	channel.next_slot = ( channel.next_slot + 1 ) % kSlots;
+	WaitIdle( slot );
+	const int width = (int)fbo.GetRenderWidth();
+	const int height = (int)fbo.GetRenderHeight();
+	UpdateScene( slot, width, height );
+	gl_state.Disable( GL_SCISSOR_TEST );
+	gl_state.BindFramebuffer( source_framebuffer );
+	glBindFramebuffer( GL_DRAW_FRAMEBUFFER, slot.scene_framebuffer );
+	glBlitFramebuffer( 0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	gl_state.Touch( GlStateCache::GROUP_FRAMEBUFFER );
+
+	const int rect[4] = { 0, 0, width, height };
+	std::copy( rect, rect + 4, slot.source_rect );
+	std::copy( fbo.GetFrameSetup().view_proj, fbo.GetFrameSetup().view_proj + 16, slot.view_proj );
+	slot.warper = fbo.GetWarper();
+	slot.trimmed = fbo.IsTrimmed();
+	std::copy( fbo.GetTrimRegion(), fbo.GetTrimRegion() + 4, slot.source_region );
+	slot.frame_index = frame_index;
+	slot.warped = false;
+	slot.ready = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	glFlush();
+	bool stopped = false;
+	{
+		// a thread that could not activate its context takes nothing
+		std::lock_guard<std::mutex> lock( mutex_ );
+		stopped = stopping_;
+		if ( !stopped )
+		{
+			slot.queued = true;
+			const Job job = { &channel, &slot };
+			queue_.push_back( job );
+		}
+	}
+	if ( stopped )
+	{
+		glDeleteSync( slot.ready );
+		slot.ready = 0;
+		gl_state.BindFramebuffer( gl_state.GetFramebuffer() );
+		return false;
+	}
+	wake_.notify_one();
+
+	// the previous frame's warp, waited for on the GPU only
+	WaitIdle( previous );
+	const bool present = previous.warped && previous.frame_index + 1 == frame_index;
+	if ( previous.done )
+	{
+		if ( present )
+			glWaitSync( previous.done, 0, GL_TIMEOUT_IGNORED );
+		glDeleteSync( previous.done );
+		previous.done = 0;
+	}
+	previous.warped = false;
+	if ( present )
+	{
+		glBindFramebuffer( GL_READ_FRAMEBUFFER, previous.present_framebuffer );
+		glBindFramebuffer( GL_DRAW_FRAMEBUFFER, gl_state.GetFramebuffer() );
+		glBlitFramebuffer( 0, 0, channel.width, channel.height, 0, 0, channel.width, channel.height, GL_COLOR_BUFFER_BIT, GL_NEAREST );
+	}
+	gl_state.BindFramebuffer( gl_state.GetFramebuffer() );
+	return present;
+}
+
+void WarpThread::Preload( int window_id, const ExternalFbo& fbo )
+{
+	if ( !IsRunning() )
+		return;
+
+	// the renderers loaded before may belong to warpers about to be destroyed
+	Channel& channel = GetChannel( window_id );
+	Drain( channel );
+	std::vector<VWB_Warper*> warpers;
+	for ( size_t i = 0; i < fbo.GetProfiles().size(); ++i )
+	{
+		if ( fbo.GetProfiles()[i].warper )
+			warpers.push_back( fbo.GetProfiles()[i].warper );
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		if ( stopping_ )
+			return;
+		channel.pending.swap( warpers );
+		channel.pending_width = (int)fbo.GetWidth();
+		channel.pending_height = (int)fbo.GetHeight();
+		channel.loading = true;
+		const Job job = { &channel, nullptr };
+		queue_.push_back( job );
+	}
+	wake_.notify_one();
+
+	// the thread reads the warpers while the render thread waits, never both at once
+	std::unique_lock<std::mutex> lock( mutex_ );
+	finished_.wait( lock, [&channel]() { return !channel.loading; } );
+}
+
+void WarpThread::WaitIdle( const Slot& slot )
+{
+	std::unique_lock<std::mutex> lock( mutex_ );
+	finished_.wait( lock, [&slot]() { return !slot.queued; } );
+}
+
+void WarpThread::Drain( Channel& channel )
+{
+	for ( int i = 0; i < kSlots; ++i )
+	{
+		Slot& slot = channel.slots[i];
+		WaitIdle( slot );
+		if ( slot.done )
+			glDeleteSync( slot.done );
+		slot.done = 0;
+		slot.warped = false;
+	}
+}
+
+void WarpThread::UpdateScene( Slot& slot, int width, int height )
+{
+	if ( width <= slot.scene_width && height <= slot.scene_height )
+		return;
+
+	if ( slot.scene_texture )
+		glDeleteTextures( 1, &slot.scene_texture );
+	slot.scene_width = std::max( width, slot.scene_width );
+	slot.scene_height = std::max( height, slot.scene_height );
+	slot.scene_texture = CreateTexture( slot.scene_width, slot.scene_height );
+	glNamedFramebufferTextureEXT( slot.scene_framebuffer, GL_COLOR_ATTACHMENT0, slot.scene_texture, 0 );
+}
+
+void WarpThread::UpdateOutput( Channel& channel, int width, int height )
+{
+	if ( channel.width == width && channel.height == height )
+		return;
+
+	channel.width = width;
+	channel.height = height;
+	for ( int i = 0; i < kSlots; ++i )
+	{
+		Slot& slot = channel.slots[i];
+		if ( slot.output_texture )
+			glDeleteTextures( 1, &slot.output_texture );
+		slot.output_texture = CreateTexture( width, height );
+		glNamedFramebufferTextureEXT( slot.present_framebuffer, GL_COLOR_ATTACHMENT0, slot.output_texture, 0 );
+	}
+}
+
+void WarpThread::ReleaseSlot( Slot& slot )
+{
+	if ( slot.ready )				glDeleteSync( slot.ready );
+	if ( slot.done )				glDeleteSync( slot.done );
+	if ( slot.scene_framebuffer )	glDeleteFramebuffers( 1, &slot.scene_framebuffer );
+	if ( slot.present_framebuffer )	glDeleteFramebuffers( 1, &slot.present_framebuffer );
+	if ( slot.scene_texture )		glDeleteTextures( 1, &slot.scene_texture );
+	if ( slot.output_texture )		glDeleteTextures( 1, &slot.output_texture );
+	slot = Slot();
+}
+
+void WarpThread::ReleaseRenderers( Channel& channel )
+{
+	for ( std::map<VWB_Warper*, WarpRenderer*>::iterator it = channel.renderers.begin(); it != channel.renderers.end(); ++it )
+	{
+		it->second->Unload();
+		delete it->second;
+	}
+	channel.renderers.clear();
+}
+
+void WarpThread::LoadRenderers( Channel& channel )
+{
+	std::vector<VWB_Warper*> warpers;
+	WarpSettings settings = settings_;
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		warpers.swap( channel.pending );
+		settings.output_width = channel.pending_width;
+		settings.output_height = channel.pending_height;
+	}
+
+	ReleaseRenderers( channel );
+	for ( size_t i = 0; i < warpers.size(); ++i )
+	{
+		WarpRenderer* renderer = new WarpRenderer;
+		renderer->Load( warpers[i], settings );
+		channel.renderers[warpers[i]] = renderer;
+	}
+	if ( 0 == channel.output_framebuffer )
+		glGenFramebuffers( 1, &channel.output_framebuffer );
+
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		channel.loading = false;
+	}
+	finished_.notify_all();
+}
+
+void WarpThread::Warp( Channel& channel, Slot& slot )
+{
+	glWaitSync( slot.ready, 0, GL_TIMEOUT_IGNORED );
+	std::map<VWB_Warper*, WarpRenderer*>::const_iterator found = channel.renderers.find( slot.warper );
+	WarpRenderer* renderer = channel.renderers.end() != found ? found->second : nullptr;
+
+	// attached and bound again, so this context sees what the render thread's wrote
+	GLsync done = 0;
+	if ( renderer && renderer->IsReady() )
+	{
+		glNamedFramebufferTextureEXT( channel.output_framebuffer, GL_COLOR_ATTACHMENT0, slot.output_texture, 0 );
+		state_.BindMultiTexture2D( 1, 0 );
+		renderer->SetSourceRegion( slot.trimmed ? slot.source_region : nullptr );
+		renderer->Render( 0, slot.scene_texture, slot.source_rect, channel.output_framebuffer, channel.width, channel.height, slot.view_proj, state_ );
+		renderer->SetSourceRegion( nullptr );
+		done = glFenceSync( GL_SYNC_GPU_COMMANDS_COMPLETE, 0 );
+	}
+	glFlush();
+	glDeleteSync( slot.ready );
+
+	{
+		std::lock_guard<std::mutex> lock( mutex_ );
+		slot.ready = 0;
+		slot.done = done;
+		slot.warped = 0 != done;
+		slot.queued = false;
+	}
+	finished_.notify_all();
+}
+
+void WarpThread::Run()
+{
+#if defined( _WIN32 )
+	if ( !wglMakeCurrent( (HDC)dc_, (HGLRC)context_ ) )
+	{
+		std::cout << "Warning: could not activate the shared GL context, windows are warped on the render thread." << std::endl;
+		std::lock_guard<std::mutex> lock( mutex_ );
+		stopping_ = true;
+	}
+#endif
+	state_.Invalidate();
+
+	for ( ;; )
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock( mutex_ );
+			wake_.wait( lock, [this]() { return stopping_ || !queue_.empty(); } );
+			if ( stopping_ )
+			{
+				// frames on their way are dropped, nobody waits for them any more
+				for ( std::deque<Job>::iterator it = queue_.begin(); it != queue_.end(); ++it )
+				{
+					if ( it->slot )
+						it->slot->queued = false;
+					else
+						it->channel->loading = false;
+				}
+				queue_.clear();
+				break;
+			}
+			job = queue_.front();
+			queue_.pop_front();
+		}
+		if ( job.slot )
+			Warp( *job.channel, *job.slot );
+		else
+			LoadRenderers( *job.channel );
+	}
+	finished_.notify_all();
+
+	// the renderers' objects belong to this context
+	for ( std::map<int, Channel>::iterator it = channels_.begin(); it != channels_.end(); ++it )
+	{
+		Channel& channel = it->second;
+		ReleaseRenderers( channel );
+		if ( channel.output_framebuffer )
+			glDeleteFramebuffers( 1, &channel.output_framebuffer );
+		channel.output_framebuffer = 0;
+	}
+#if defined( _WIN32 )
+	glFinish();
+	wglMakeCurrent( nullptr, nullptr );
+#endif
+}
@@ -0,0 +1,145 @@
+//==============================================================================
+// File:WarpThread.h
+//==============================================================================
+//
+// Description: Warps the windows on a thread with its own context sharing
+//				objects with the IG's, pipelined one frame behind the render
+//				thread. After the IG has rendered a window, the render thread
+//				copies its scene into one of two textures of the window and
+//				fences the copy, and the warp thread warps it into an output
+//				texture while the IG renders the next frame. That output is
+//				presented in the window's next postWindowProcess, after the
+//				render thread's context has waited for the warp's fence on the
+//				GPU. Only the copy and the present stay on the render thread.
+//
+//==============================================================================
+
+#ifndef DVC_WARP_THREAD_H
+#define DVC_WARP_THREAD_H
+
+#include "ExternalFbo.h"
+#include "GlStateCache.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WarpThread
+{
+public:
+	WarpThread();
+	~WarpThread();
+
+	/*!
+	 * Creates the shared context and starts the thread. The thread's warps leave out the post
+	 * effects, the exposure, foveation and cube maps. Needs the IG context.
+	 *
+	 * @return
+	 *  false if no shared context could be made, windows are warped in place then.
+	**/
+	bool Start( const WarpSettings& settings );
+
+	/*!
+	 * Stops the thread, frames still on their way are dropped. Needs the context Start had.
+	**/
+	void Stop();
+
+	bool IsRunning() const { return thread_.joinable(); }
+
+	/*!
+	 * Hands the window's scene over to the warp thread, then presents the previous frame's warp
+	 * into the framebuffer the IG had bound. Needs the IG context, in postWindowProcess.
+	 *
+	 * @param[in] frame_index : an output is only presented in the frame right after its own
+	 * @param[in] source_framebuffer : holds the scene at its render size in the lower left
+	 * @return
+	 *  false if there was no warp of the previous frame to present, the caller warps in place.
+	**/
+	bool Submit( int window_id, unsigned int frame_index, const ExternalFbo& fbo, GLuint source_framebuffer, GlStateCache& gl_state );
+
+	/*!
+	 * Has the thread load its renderers for every calibration profile of the window and waits
+	 * for them, so Submit never waits for a load. Frames on their way are dropped and renderers
+	 * loaded before are released. Call when the window is created and again once a profile's
+	 * warper was replaced. Needs the IG context.
+	**/
+	void Preload( int window_id, const ExternalFbo& fbo );
+
+private:
+	WarpThread( const WarpThread& );
+	WarpThread& operator=( const WarpThread& );
+
+	enum { kSlots = 2 };
+
+	/*! One frame of a window, alternating with the other slot. **/
+	struct Slot
+	{
+		GLuint scene_texture;		/* the copied scene, read by the warp thread */
+		GLuint output_texture;		/* the warped window, presented a frame later */
+		GLuint scene_framebuffer;	/* render thread's, writes scene_texture */
+		GLuint present_framebuffer;	/* render thread's, reads output_texture */
+		int scene_width;			/* of scene_texture, grows only */
+		int scene_height;
+		GLsync ready;				/* the copy, waited for by the warp thread */
+		GLsync done;				/* the warp, waited for by the render thread */
+		VWB_Warper* warper;			/* the calibration active for the frame */
+		int source_rect[4];
+		GLfloat view_proj[16];
+		float source_region[4];
+		bool trimmed;
+		bool queued;				/* handed over and not finished yet, guarded by mutex_ */
+		bool warped;				/* output_texture holds the slot's frame */
+		unsigned int frame_index;
+	};
+
+	struct Channel
+	{
+		int width;					/* of the window and the output textures */
+		int height;
+		Slot slots[kSlots];
+		unsigned int next_slot;
+		std::vector<VWB_Warper*> pending;	/* the profiles' warpers for the thread to load, guarded by mutex_ */
+		int pending_width;			/* of the window when they were handed over */
+		int pending_height;
+		bool loading;				/* pending is handed over and not loaded yet, guarded by mutex_ */
+
+		// warp thread only, a renderer per calibration profile
+		std::map<VWB_Warper*, WarpRenderer*> renderers;
+		GLuint output_framebuffer;
+	};
+
+	struct Job
+	{
+		Channel* channel;
+		Slot* slot;					/* null loads the channel's pending warpers */
+	};
+
+	Channel& GetChannel( int window_id );
+	void WaitIdle( const Slot& slot );
+	void Drain( Channel& channel );
+	static void UpdateScene( Slot& slot, int width, int height );
+	static void UpdateOutput( Channel& channel, int width, int height );
+	static void ReleaseSlot( Slot& slot );
+	static void ReleaseRenderers( Channel& channel );
+	void LoadRenderers( Channel& channel );
+	void Warp( Channel& channel, Slot& slot );
+	void Run();
+
+	WarpSettings settings_;			/* for the thread's renderers */
+	GlStateCache state_;			/* of the thread's context */
+	void* dc_;						/* HDC and HGLRC of the warp thread, Windows only */
+	void* context_;
+	std::thread thread_;
+
+	std::map<int, Channel> channels_;
+	std::mutex mutex_;				/* guards queue_, stopping_, the slots' queued and the channels' loads */
+	std::condition_variable wake_;
+	std::condition_variable finished_;
+	std::deque<Job> queue_;
+	bool stopping_;
+};
+
+#endif // DVC_WARP_THREAD_H
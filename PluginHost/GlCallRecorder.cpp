@@ -0,0 +1,624 @@
+//==============================================================================
+// File:GlCallRecorder.cpp
+//==============================================================================
+//
+// Description: Import-table based GL call interception for PluginHost.
+//
+//==============================================================================
+
+#include "GlCallRecorder.h"
+
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <Psapi.h>
+
+#include "GL/glew.h"
+#include "tinyxml2.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+
+// Every entry point the plugins (and the VIOSO library underneath VIOSO-Plugin) are known to use.
+// Functions that are not listed are counted by name only and fail the report, so extend these
+// tables whenever a plugin starts using a new entry point. The name argument is only ever pasted
+// or stringized, which keeps GLEW's function-name macros from expanding. The category may depend
+// on the arguments, which are in scope as a, b, c, ...
+#define DVC_GL11_FUNCTIONS( X ) \
+	X( GL_CALL_STATE,		void,		glEnable,					( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glDisable,					( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glBlendFunc,				( GLenum a, GLenum b ),											( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glDepthMask,				( GLboolean a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glDepthFunc,				( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glColorMask,				( GLboolean a, GLboolean b, GLboolean c, GLboolean d ),			( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glCullFace,					( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glViewport,					( GLint a, GLint b, GLsizei c, GLsizei d ),						( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glScissor,					( GLint a, GLint b, GLsizei c, GLsizei d ),						( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glMatrixMode,				( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glLoadIdentity,				( void ),														( ) ) \
+	X( GL_CALL_STATE,		void,		glLoadMatrixf,				( const GLfloat* a ),											( a ) ) \
+	X( GL_CALL_STATE,		void,		glLoadMatrixd,				( const GLdouble* a ),											( a ) ) \
+	X( GL_CALL_STATE,		void,		glMultMatrixf,				( const GLfloat* a ),											( a ) ) \
+	X( GL_CALL_STATE,		void,		glPushMatrix,				( void ),														( ) ) \
+	X( GL_CALL_STATE,		void,		glPopMatrix,				( void ),														( ) ) \
+	X( GL_CALL_STATE,		void,		glOrtho,					( GLdouble a, GLdouble b, GLdouble c, GLdouble d, GLdouble e, GLdouble f ), ( a, b, c, d, e, f ) ) \
+	X( GL_CALL_STATE,		void,		glFrustum,					( GLdouble a, GLdouble b, GLdouble c, GLdouble d, GLdouble e, GLdouble f ), ( a, b, c, d, e, f ) ) \
+	X( GL_CALL_STATE,		void,		glPushAttrib,				( GLbitfield a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glPopAttrib,				( void ),														( ) ) \
+	X( GL_CALL_STATE,		void,		glPushClientAttrib,			( GLbitfield a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glPopClientAttrib,			( void ),														( ) ) \
+	X( GL_CALL_STATE,		void,		glBindTexture,				( GLenum a, GLuint b ),											( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glTexParameteri,			( GLenum a, GLenum b, GLint c ),								( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glTexParameterf,			( GLenum a, GLenum b, GLfloat c ),								( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glTexEnvi,					( GLenum a, GLenum b, GLint c ),								( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glColor4f,					( GLfloat a, GLfloat b, GLfloat c, GLfloat d ),					( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glColor4fv,					( const GLfloat* a ),											( a ) ) \
+	X( GL_CALL_STATE,		void,		glClearColor,				( GLclampf a, GLclampf b, GLclampf c, GLclampf d ),				( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glDrawBuffer,				( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glReadBuffer,				( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glPixelStorei,				( GLenum a, GLint b ),											( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glPolygonMode,				( GLenum a, GLenum b ),											( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glEnableClientState,		( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glDisableClientState,		( GLenum a ),													( a ) ) \
+	X( GL_CALL_STATE,		void,		glVertexPointer,			( GLint a, GLenum b, GLsizei c, const void* d ),				( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glTexCoordPointer,			( GLint a, GLenum b, GLsizei c, const void* d ),				( a, b, c, d ) ) \
+	X( GL_CALL_DRAW,		void,		glBegin,					( GLenum a ),													( a ) ) \
+	X( GL_CALL_DRAW,		void,		glEnd,						( void ),														( ) ) \
+	X( GL_CALL_DRAW,		void,		glVertex2f,					( GLfloat a, GLfloat b ),										( a, b ) ) \
+	X( GL_CALL_DRAW,		void,		glVertex3f,					( GLfloat a, GLfloat b, GLfloat c ),							( a, b, c ) ) \
+	X( GL_CALL_DRAW,		void,		glTexCoord2f,				( GLfloat a, GLfloat b ),										( a, b ) ) \
+	X( GL_CALL_DRAW,		void,		glClear,					( GLbitfield a ),												( a ) ) \
+	X( GL_CALL_DRAW,		void,		glDrawArrays,				( GLenum a, GLint b, GLsizei c ),								( a, b, c ) ) \
+	X( GL_CALL_DRAW,		void,		glDrawElements,				( GLenum a, GLsizei b, GLenum c, const void* d ),				( a, b, c, d ) ) \
+	X( GL_CALL_DRAW,		void,		glFlush,					( void ),														( ) ) \
+	X( GL_CALL_QUERY,		void,		glGetIntegerv,				( GLenum a, GLint* b ),											( a, b ) ) \
+	X( GL_CALL_QUERY,		void,		glGetFloatv,				( GLenum a, GLfloat* b ),										( a, b ) ) \
+	X( GL_CALL_QUERY,		void,		glGetDoublev,				( GLenum a, GLdouble* b ),										( a, b ) ) \
+	X( GL_CALL_QUERY,		void,		glGetBooleanv,				( GLenum a, GLboolean* b ),										( a, b ) ) \
+	X( GL_CALL_QUERY,		GLboolean,	glIsEnabled,				( GLenum a ),													( a ) ) \
+	X( GL_CALL_QUERY,		GLenum,		glGetError,					( void ),														( ) ) \
+	X( GL_CALL_QUERY,		const GLubyte*, glGetString,			( GLenum a ),													( a ) ) \
+	X( GL_CALL_QUERY,		void,		glGetTexImage,				( GLenum a, GLint b, GLenum c, GLenum d, void* e ),				( a, b, c, d, e ) ) \
+	X( GL_CALL_QUERY,		void,		glGetTexLevelParameteriv,	( GLenum a, GLint b, GLenum c, GLint* d ),						( a, b, c, d ) ) \
+	X( GL_CALL_QUERY,		void,		glReadPixels,				( GLint a, GLint b, GLsizei c, GLsizei d, GLenum e, GLenum f, void* g ), ( a, b, c, d, e, f, g ) ) \
+	X( GL_CALL_QUERY,		void,		glFinish,					( void ),														( ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glGenTextures,				( GLsizei a, GLuint* b ),										( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteTextures,			( GLsizei a, const GLuint* b ),									( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTexImage2D,				( GLenum a, GLint b, GLint c, GLsizei d, GLsizei e, GLint f, GLenum g, GLenum h, const void* i ), ( a, b, c, d, e, f, g, h, i ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTexSubImage2D,			( GLenum a, GLint b, GLint c, GLint d, GLsizei e, GLsizei f, GLenum g, GLenum h, const void* i ), ( a, b, c, d, e, f, g, h, i ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glCopyTexImage2D,			( GLenum a, GLint b, GLenum c, GLint d, GLint e, GLsizei f, GLsizei g, GLint h ), ( a, b, c, d, e, f, g, h ) )
+
+#define DVC_GL_EXTENSION_FUNCTIONS( X ) \
+	X( GL_CALL_STATE,		void,		glBindFramebuffer,					( GLenum a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glUseProgram,						( GLuint a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glActiveTexture,					( GLenum a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glBindMultiTextureEXT,				( GLenum a, GLenum b, GLuint c ),							( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glTextureParameteriEXT,				( GLuint a, GLenum b, GLenum c, GLint d ),					( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glTextureParameteri,				( GLuint a, GLenum b, GLint c ),							( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glNamedFramebufferTextureEXT,		( GLuint a, GLenum b, GLuint c, GLint d ),					( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glNamedFramebufferTexture2DEXT,		( GLuint a, GLenum b, GLenum c, GLuint d, GLint e ),		( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glNamedFramebufferTextureLayerEXT,	( GLuint a, GLenum b, GLuint c, GLint d, GLint e ),			( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glFramebufferTexture,				( GLenum a, GLenum b, GLuint c, GLint d ),					( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glFramebufferTexture2D,				( GLenum a, GLenum b, GLenum c, GLuint d, GLint e ),		( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glFramebufferTextureLayer,			( GLenum a, GLenum b, GLuint c, GLint d, GLint e ),			( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glBindVertexArray,					( GLuint a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glBindBuffer,						( GLenum a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glBindBufferBase,					( GLenum a, GLuint b, GLuint c ),							( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glBindBufferRange,					( GLenum a, GLuint b, GLuint c, GLintptr d, GLsizeiptr e ),	( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glBindImageTexture,					( GLuint a, GLuint b, GLint c, GLboolean d, GLint e, GLenum f, GLenum g ), ( a, b, c, d, e, f, g ) ) \
+	X( GL_CALL_STATE,		void,		glBindSampler,						( GLuint a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glDrawBuffers,						( GLsizei a, const GLenum* b ),								( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glBlendFuncSeparate,				( GLenum a, GLenum b, GLenum c, GLenum d ),					( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glEnableVertexAttribArray,			( GLuint a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glVertexAttribPointer,				( GLuint a, GLint b, GLenum c, GLboolean d, GLsizei e, const void* f ), ( a, b, c, d, e, f ) ) \
+	X( GL_CALL_STATE,		void,		glEnableVertexArrayAttribEXT,		( GLuint a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glVertexArrayVertexAttribOffsetEXT,	( GLuint a, GLuint b, GLuint c, GLint d, GLenum e, GLboolean f, GLsizei g, GLintptr h ), ( a, b, c, d, e, f, g, h ) ) \
+	X( GL_CALL_STATE,		void,		glUniform1i,						( GLint a, GLint b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glUniform1f,						( GLint a, GLfloat b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glUniform2f,						( GLint a, GLfloat b, GLfloat c ),							( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glUniform2i,						( GLint a, GLint b, GLint c ),								( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glUniform4i,						( GLint a, GLint b, GLint c, GLint d, GLint e ),			( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glUniform4f,						( GLint a, GLfloat b, GLfloat c, GLfloat d, GLfloat e ),	( a, b, c, d, e ) ) \
+	X( GL_CALL_STATE,		void,		glUniform4fv,						( GLint a, GLsizei b, const GLfloat* c ),					( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glUniformMatrix3fv,					( GLint a, GLsizei b, GLboolean c, const GLfloat* d ),		( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glUniformMatrix4fv,					( GLint a, GLsizei b, GLboolean c, const GLfloat* d ),		( a, b, c, d ) ) \
+	X( GL_CALL_STATE,		void,		glProgramUniform1iEXT,				( GLuint a, GLint b, GLint c ),								( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glProgramParameteri,				( GLuint a, GLenum b, GLint c ),							( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glMemoryBarrier,					( GLbitfield a ),											( a ) ) \
+	X( GL_CALL_STATE,		GLsync,		glFenceSync,						( GLenum a, GLbitfield b ),									( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glDeleteSync,						( GLsync a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glWaitSync,							( GLsync a, GLbitfield b, GLuint64 c ),						( a, b, c ) ) \
+	X( GL_CALL_STATE,		void,		glBeginQuery,						( GLenum a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_STATE,		void,		glEndQuery,							( GLenum a ),												( a ) ) \
+	X( GL_CALL_STATE,		void,		glQueryCounter,						( GLuint a, GLenum b ),										( a, b ) ) \
+	X( GL_CALL_DRAW,		void,		glBlitFramebuffer,					( GLint a, GLint b, GLint c, GLint d, GLint e, GLint f, GLint g, GLint h, GLbitfield i, GLenum j ), ( a, b, c, d, e, f, g, h, i, j ) ) \
+	X( GL_CALL_DRAW,		void,		glDispatchCompute,					( GLuint a, GLuint b, GLuint c ),							( a, b, c ) ) \
+	X( GL_CALL_DRAW,		void,		glDrawArraysInstanced,				( GLenum a, GLint b, GLsizei c, GLsizei d ),				( a, b, c, d ) ) \
+	X( GL_CALL_DRAW,		void,		glDrawElementsInstanced,			( GLenum a, GLsizei b, GLenum c, const void* d, GLsizei e ), ( a, b, c, d, e ) ) \
+	X( GL_CALL_DRAW,		void,		glGenerateMipmap,					( GLenum a ),												( a ) ) \
+	X( GL_CALL_DRAW,		void,		glCopyImageSubData,					( GLuint a, GLenum b, GLint c, GLint d, GLint e, GLint f, GLuint g, GLenum h, GLint i, GLint j, GLint k, GLint l, GLsizei m, GLsizei n, GLsizei o ), ( a, b, c, d, e, f, g, h, i, j, k, l, m, n, o ) ) \
+	X( GL_CALL_QUERY,		GLenum,		glCheckFramebufferStatus,			( GLenum a ),												( a ) ) \
+	X( GL_CALL_QUERY,		GLenum,		glCheckNamedFramebufferStatusEXT,	( GLuint a, GLenum b ),										( a, b ) ) \
+	X( 0 == c ? GL_CALL_POLL : GL_CALL_QUERY, GLenum, glClientWaitSync,	( GLsync a, GLbitfield b, GLuint64 c ),						( a, b, c ) ) \
+	X( GL_QUERY_RESULT_AVAILABLE == b ? GL_CALL_POLL : GL_CALL_QUERY, void, glGetQueryObjectiv, ( GLuint a, GLenum b, GLint* c ), ( a, b, c ) ) \
+	X( GL_QUERY_RESULT_AVAILABLE == b ? GL_CALL_POLL : GL_CALL_QUERY, void, glGetQueryObjectui64v, ( GLuint a, GLenum b, GLuint64* c ), ( a, b, c ) ) \
+	X( GL_CALL_QUERY,		void,		glGetIntegerIndexedvEXT,			( GLenum a, GLuint b, GLint* c ),							( a, b, c ) ) \
+	X( GL_CALL_QUERY,		void,		glGetProgramiv,						( GLuint a, GLenum b, GLint* c ),							( a, b, c ) ) \
+	X( GL_CALL_QUERY,		void,		glGetShaderiv,						( GLuint a, GLenum b, GLint* c ),							( a, b, c ) ) \
+	X( GL_CALL_QUERY,		void,		glGetProgramInfoLog,				( GLuint a, GLsizei b, GLsizei* c, GLchar* d ),				( a, b, c, d ) ) \
+	X( GL_CALL_QUERY,		void,		glGetShaderInfoLog,					( GLuint a, GLsizei b, GLsizei* c, GLchar* d ),				( a, b, c, d ) ) \
+	X( GL_CALL_QUERY,		void,		glGetProgramBinary,					( GLuint a, GLsizei b, GLsizei* c, GLenum* d, void* e ),	( a, b, c, d, e ) ) \
+	X( GL_CALL_QUERY,		GLint,		glGetUniformLocation,				( GLuint a, const GLchar* b ),								( a, b ) ) \
+	X( GL_CALL_QUERY,		void,		glGetBufferSubData,					( GLenum a, GLintptr b, GLsizeiptr c, void* d ),			( a, b, c, d ) ) \
+	X( GL_CALL_QUERY,		void,		glGetNamedBufferSubDataEXT,			( GLuint a, GLintptr b, GLsizeiptr c, void* d ),			( a, b, c, d ) ) \
+	X( GL_CALL_QUERY,		void*,		glMapBufferRange,					( GLenum a, GLintptr b, GLsizeiptr c, GLbitfield d ),		( a, b, c, d ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glGenFramebuffers,					( GLsizei a, GLuint* b ),									( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteFramebuffers,				( GLsizei a, const GLuint* b ),								( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glCreateTextures,					( GLenum a, GLsizei b, GLuint* c ),							( a, b, c ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTextureImage2DEXT,				( GLuint a, GLenum b, GLint c, GLint d, GLsizei e, GLsizei f, GLint g, GLenum h, GLenum i, const void* j ), ( a, b, c, d, e, f, g, h, i, j ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTexImage2DMultisample,			( GLenum a, GLsizei b, GLenum c, GLsizei d, GLsizei e, GLboolean f ), ( a, b, c, d, e, f ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTexStorage2D,						( GLenum a, GLsizei b, GLenum c, GLsizei d, GLsizei e ),	( a, b, c, d, e ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTextureStorage3DEXT,				( GLuint a, GLenum b, GLsizei c, GLenum d, GLsizei e, GLsizei f, GLsizei g ), ( a, b, c, d, e, f, g ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTextureStorage3DMultisampleEXT,	( GLuint a, GLenum b, GLsizei c, GLenum d, GLsizei e, GLsizei f, GLsizei g, GLboolean h ), ( a, b, c, d, e, f, g, h ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glTextureView,						( GLuint a, GLenum b, GLuint c, GLenum d, GLuint e, GLuint f, GLuint g, GLuint h ), ( a, b, c, d, e, f, g, h ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glGenBuffers,						( GLsizei a, GLuint* b ),									( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteBuffers,					( GLsizei a, const GLuint* b ),								( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glBufferData,						( GLenum a, GLsizeiptr b, const void* c, GLenum d ),		( a, b, c, d ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glNamedBufferDataEXT,				( GLuint a, GLsizeiptr b, const void* c, GLenum d ),		( a, b, c, d ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glGenVertexArrays,					( GLsizei a, GLuint* b ),									( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteVertexArrays,				( GLsizei a, const GLuint* b ),								( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glGenQueries,						( GLsizei a, GLuint* b ),									( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteQueries,					( GLsizei a, const GLuint* b ),								( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	GLuint,		glCreateShader,						( GLenum a ),												( a ) ) \
+	X( GL_CALL_ALLOCATION,	GLuint,		glCreateProgram,					( void ),													( ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteShader,						( GLuint a ),												( a ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDeleteProgram,					( GLuint a ),												( a ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glShaderSource,						( GLuint a, GLsizei b, const GLchar* const* c, const GLint* d ), ( a, b, c, d ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glCompileShader,					( GLuint a ),												( a ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glAttachShader,						( GLuint a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glDetachShader,						( GLuint a, GLuint b ),										( a, b ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glLinkProgram,						( GLuint a ),												( a ) ) \
+	X( GL_CALL_ALLOCATION,	void,		glProgramBinary,					( GLuint a, GLenum b, const void* c, GLsizei d ),			( a, b, c, d ) )
+
+namespace
+{
+	enum GlFunctionId
+	{
+#define DVC_GL_ENUM( category, ret, name, params, args ) FN_##name,
+		DVC_GL11_FUNCTIONS( DVC_GL_ENUM )
+		DVC_GL_EXTENSION_FUNCTIONS( DVC_GL_ENUM )
+#undef DVC_GL_ENUM
+		FN_COUNT
+	};
+
+	const char* const kFunctionNames[FN_COUNT] =
+	{
+#define DVC_GL_NAME( category, ret, name, params, args ) #name,
+		DVC_GL11_FUNCTIONS( DVC_GL_NAME )
+		DVC_GL_EXTENSION_FUNCTIONS( DVC_GL_NAME )
+#undef DVC_GL_NAME
+	};
+
+	const char* const kCategoryNames[GL_CALL_CATEGORY_COUNT] = { "state", "draw", "query", "allocation", "poll" };
+	const char* const kScopeNames[GL_SCOPE_COUNT] = { "image_processor", "overlay" };
+
+	// the wrappers are free functions, so the counters they feed are too. Only the render thread
+	// counts, the calls the plugins' own threads (warp, reloader, program cache) make on their
+	// contexts do not belong to the callback the render thread is in, and the counters stay unshared.
+	int g_scope = GL_SCOPE_NONE;
+	DWORD g_render_thread = 0;
+	unsigned int g_frame_counts[GL_SCOPE_COUNT][GL_CALL_CATEGORY_COUNT];
+	unsigned long long g_function_counts[GL_SCOPE_COUNT][FN_COUNT];
+
+	inline void Record( GlCallCategory category, GlFunctionId id )
+	{
+		if ( g_scope < 0 || GetCurrentThreadId() != g_render_thread )
+			return;
+		++g_frame_counts[g_scope][category];
+		++g_function_counts[g_scope][id];
+	}
+
+#define DVC_GL_WRAPPER( category, ret, name, params, args ) \
+	typedef ret ( GLAPIENTRY * PFN_REAL_##name ) params; \
+	PFN_REAL_##name real_##name = 0; \
+	ret GLAPIENTRY wrap_##name params { Record( category, FN_##name ); return real_##name args; }
+
+	DVC_GL11_FUNCTIONS( DVC_GL_WRAPPER )
+	DVC_GL_EXTENSION_FUNCTIONS( DVC_GL_WRAPPER )
+#undef DVC_GL_WRAPPER
+
+	// Entry points without a wrapper get a generated thunk that counts the call for the current
+	// scope, if made on the render thread, and jumps to the real function. It only uses rax, r10
+	// and r11, which the x64 calling convention leaves free on entry, so the arguments pass
+	// through whatever the signature.
+	const int kMaxUnlisted = 4096;
+	const size_t kThunkSize = 80;
+
+	struct Unlisted
+	{
+		std::string name;
+		void* real;
+	};
+
+	std::mutex g_unlisted_mutex;
+	std::vector<Unlisted> g_unlisted;
+	unsigned long long g_unlisted_counts[kMaxUnlisted][GL_SCOPE_COUNT];
+	BYTE* g_thunks = 0;
+
+	void Emit( BYTE*& code, const BYTE* bytes, size_t count )
+	{
+		memcpy( code, bytes, count );
+		code += count;
+	}
+
+	void EmitAddress( BYTE*& code, const void* address )
+	{
+		memcpy( code, &address, sizeof( address ) );
+		code += sizeof( address );
+	}
+
+	bool IsThunk( const void* function )
+	{
+		return g_thunks && (const BYTE*)function >= g_thunks && (const BYTE*)function < g_thunks + kMaxUnlisted * kThunkSize;
+	}
+
+	/*!
+	 * Returns a counting thunk for a GL entry point the tables do not list, 0 for anything else.
+	**/
+	void* WrapUnlisted( const char* name, void* real )
+	{
+#if defined( _M_X64 )
+		if ( 0 != strncmp( name, "gl", 2 ) || IsThunk( real ) )
+			return 0;
+
+		std::lock_guard<std::mutex> lock( g_unlisted_mutex );
+		for ( size_t i = 0; i < g_unlisted.size(); ++i )
+		{
+			if ( g_unlisted[i].real == real && g_unlisted[i].name == name )
+				return g_thunks + i * kThunkSize;
+		}
+		if ( !g_thunks )
+			g_thunks = (BYTE*)VirtualAlloc( 0, kMaxUnlisted * kThunkSize, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE );
+		if ( !g_thunks || g_unlisted.size() >= (size_t)kMaxUnlisted )
+		{
+			std::cout << "PluginHost: Warning: " << name << " is not listed and passes through uncounted." << std::endl;
+			return 0;
+		}
+
+		const size_t index = g_unlisted.size();
+		BYTE* const thunk = g_thunks + index * kThunkSize;
+		BYTE* code = thunk;
+		const BYTE load_thread_address[] = { 0x49, 0xBA };						// mov r10, &g_render_thread
+		const BYTE check_thread[] = { 0x65, 0x8B, 0x04, 0x25, 0x48, 0x00, 0x00, 0x00, 0x41, 0x3B, 0x02, 0x75, 0x20 };	// mov eax, gs:[0x48] (TEB thread id); cmp eax, [r10]; jne +32
+		const BYTE load_scope_address[] = { 0x49, 0xBA };						// mov r10, &g_scope
+		const BYTE load_scope[] = { 0x4D, 0x63, 0x1A, 0x4D, 0x85, 0xDB, 0x78, 0x0E };	// movsxd r11, [r10]; test r11, r11; js +14
+		const BYTE load_counts_address[] = { 0x49, 0xBA };						// mov r10, g_unlisted_counts[index]
+		const BYTE count[] = { 0x4B, 0xFF, 0x04, 0xDA };						// inc qword [r10 + r11 * 8]
+		const BYTE load_real[] = { 0x48, 0xB8 };								// mov rax, real
+		const BYTE jump[] = { 0xFF, 0xE0 };									// jmp rax
+		Emit( code, load_thread_address, sizeof( load_thread_address ) );
+		EmitAddress( code, &g_render_thread );
+		Emit( code, check_thread, sizeof( check_thread ) );
+		Emit( code, load_scope_address, sizeof( load_scope_address ) );
+		EmitAddress( code, &g_scope );
+		Emit( code, load_scope, sizeof( load_scope ) );
+		Emit( code, load_counts_address, sizeof( load_counts_address ) );
+		EmitAddress( code, g_unlisted_counts[index] );
+		Emit( code, count, sizeof( count ) );
+		Emit( code, load_real, sizeof( load_real ) );
+		EmitAddress( code, real );
+		Emit( code, jump, sizeof( jump ) );
+		FlushInstructionCache( GetCurrentProcess(), thunk, kThunkSize );
+
+		const Unlisted unlisted = { name, real };
+		g_unlisted.push_back( unlisted );
+		return thunk;
+#else
+		return 0;
+#endif
+	}
+
+	/*!
+	 * Returns the wrapper for a GL 1.1 import and remembers the real entry point, 0 if not recorded.
+	**/
+	void* WrapGl11( const char* name, void* real )
+	{
+#define DVC_GL_MATCH( category, ret, name_, params, args ) \
+		if ( 0 == strcmp( name, #name_ ) ) { if ( !real_##name_ ) real_##name_ = (PFN_REAL_##name_)real; return (void*)&wrap_##name_; }
+		DVC_GL11_FUNCTIONS( DVC_GL_MATCH )
+#undef DVC_GL_MATCH
+		return 0;
+	}
+
+	void* WrapExtension( const char* name, void* real )
+	{
+#define DVC_GL_MATCH( category, ret, name_, params, args ) \
+		if ( 0 == strcmp( name, #name_ ) ) { if ( !real_##name_ ) real_##name_ = (PFN_REAL_##name_)real; return (void*)&wrap_##name_; }
+		DVC_GL_EXTENSION_FUNCTIONS( DVC_GL_MATCH )
+#undef DVC_GL_MATCH
+		return 0;
+	}
+
+	typedef PROC ( WINAPI * PFN_WGLGETPROCADDRESS )( LPCSTR );
+	PFN_WGLGETPROCADDRESS real_wglGetProcAddress = 0;
+
+	PROC WINAPI HookedWglGetProcAddress( LPCSTR name )
+	{
+		PROC real = real_wglGetProcAddress( name );
+		if ( !real || !name )
+			return real;
+		void* wrapper = WrapExtension( name, (void*)real );
+		if ( !wrapper )
+			wrapper = WrapUnlisted( name, (void*)real );
+		return wrapper ? (PROC)wrapper : real;
+	}
+
+	void PatchImport( ULONG_PTR* slot, void* replacement )
+	{
+		DWORD old_protect = 0;
+		VirtualProtect( slot, sizeof( ULONG_PTR ), PAGE_READWRITE, &old_protect );
+		*slot = (ULONG_PTR)replacement;
+		VirtualProtect( slot, sizeof( ULONG_PTR ), old_protect, &old_protect );
+	}
+
+	void PatchModule( HMODULE module )
+	{
+		BYTE* base = (BYTE*)module;
+		const IMAGE_DOS_HEADER* dos = (const IMAGE_DOS_HEADER*)base;
+		const IMAGE_NT_HEADERS* nt = (const IMAGE_NT_HEADERS*)( base + dos->e_lfanew );
+		const IMAGE_DATA_DIRECTORY& imports = nt->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_IMPORT];
+		if ( !imports.VirtualAddress )
+			return;
+
+		for ( const IMAGE_IMPORT_DESCRIPTOR* desc = (const IMAGE_IMPORT_DESCRIPTOR*)( base + imports.VirtualAddress ); desc->Name; ++desc )
+		{
+			if ( 0 != _stricmp( (const char*)( base + desc->Name ), "opengl32.dll" ) || !desc->OriginalFirstThunk )
+				continue;
+
+			const IMAGE_THUNK_DATA* names = (const IMAGE_THUNK_DATA*)( base + desc->OriginalFirstThunk );
+			IMAGE_THUNK_DATA* slots = (IMAGE_THUNK_DATA*)( base + desc->FirstThunk );
+			for ( ; names->u1.AddressOfData; ++names, ++slots )
+			{
+				if ( IMAGE_SNAP_BY_ORDINAL( names->u1.Ordinal ) )
+					continue;
+
+				const char* name = ( (const IMAGE_IMPORT_BY_NAME*)( base + names->u1.AddressOfData ) )->Name;
+				void* current = (void*)slots->u1.Function;
+				if ( 0 == strcmp( name, "wglGetProcAddress" ) )
+				{
+					if ( current == (void*)&HookedWglGetProcAddress )
+						continue;
+					if ( !real_wglGetProcAddress )
+						real_wglGetProcAddress = (PFN_WGLGETPROCADDRESS)current;
+					PatchImport( &slots->u1.Function, (void*)&HookedWglGetProcAddress );
+					continue;
+				}
+
+				void* wrapper = WrapGl11( name, current );
+				if ( !wrapper )
+					wrapper = WrapUnlisted( name, current );
+				if ( wrapper && wrapper != current )
+					PatchImport( &slots->u1.Function, wrapper );
+			}
+		}
+	}
+
+	int ReadBudget( const tinyxml2::XMLElement* element, const char* name )
+	{
+		int value = -1;
+		element->QueryIntAttribute( name, &value );
+		return value;
+	}
+}
+
+GlCallRecorder::GlCallRecorder()
+	: recording_( false )
+	, has_budgets_( false )
+	, frame_( 0 )
+	, recorded_frames_( 0 )
+	, num_windows_( 1 )
+{
+	memset( totals_, 0, sizeof( totals_ ) );
+	memset( max_per_frame_, 0, sizeof( max_per_frame_ ) );
+	memset( g_frame_counts, 0, sizeof( g_frame_counts ) );
+	memset( g_function_counts, 0, sizeof( g_function_counts ) );
+	memset( g_unlisted_counts, 0, sizeof( g_unlisted_counts ) );
+}
+
+bool GlCallRecorder::LoadBudgets( const char* filename )
+{
+	using namespace tinyxml2;
+
+	XMLDocument doc;
+	if ( XML_SUCCESS != doc.LoadFile( filename ) )
+	{
+		std::cout << "PluginHost: Error: GL budget file " << filename << " not found." << std::endl;
+		return false;
+	}
+	const XMLElement* root = doc.FirstChildElement( "gl_budgets" );
+	if ( !root )
+	{
+		std::cout << "PluginHost: Error: " << filename << " missing the root <gl_budgets> tag." << std::endl;
+		return false;
+	}
+
+	for ( const XMLElement* element = root->FirstChildElement( "plugin" ); element; element = element->NextSiblingElement( "plugin" ) )
+	{
+		const char* name = element->Attribute( "name" );
+		for ( int scope = 0; scope < GL_SCOPE_COUNT; ++scope )
+		{
+			if ( !name || 0 != strcmp( name, kScopeNames[scope] ) )
+				continue;
+			for ( int category = 0; category < GL_CALL_CATEGORY_COUNT; ++category )
+				budgets_[scope].max_calls[category] = ReadBudget( element, kCategoryNames[category] );
+			has_budgets_ = true;
+		}
+	}
+	return true;
+}
+
+bool GlCallRecorder::WriteBudgets( const char* filename ) const
+{
+	std::ofstream file( filename );
+	if ( !file )
+	{
+		std::cout << "PluginHost: Error: could not write the GL budget file " << filename << "." << std::endl;
+		return false;
+	}
+
+	file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>" << std::endl;
+	file << "<!-- GL calls per window and frame, the most any of " << recorded_frames_ << " recorded frames made with "
+		<< num_windows_ << " window(s), as PluginHost measured them. -->" << std::endl;
+	file << "<gl_budgets>" << std::endl;
+	for ( int scope = 0; scope < GL_SCOPE_COUNT; ++scope )
+	{
+		file << "\t<plugin name=\"" << kScopeNames[scope] << "\"";
+		for ( int category = 0; category < GL_CALL_CATEGORY_COUNT; ++category )
+		{
+			// rounded up, so the run that wrote them meets them
+			const unsigned int per_window = ( max_per_frame_[scope][category] + num_windows_ - 1 ) / num_windows_;
+			file << " " << kCategoryNames[category] << "=\"" << per_window << "\"";
+		}
+		file << "/>" << std::endl;
+	}
+	file << "</gl_budgets>" << std::endl;
+	std::cout << "PluginHost: measured GL call budgets written to " << filename << "." << std::endl;
+	return true;
+}
+
+void GlCallRecorder::Install()
+{
+	HMODULE modules[1024];
+	DWORD needed = 0;
+	if ( !EnumProcessModules( GetCurrentProcess(), modules, sizeof( modules ), &needed ) )
+		return;
+
+	const HMODULE opengl32 = GetModuleHandleA( "opengl32.dll" );
+	const DWORD count = std::min<DWORD>( needed / sizeof( HMODULE ), sizeof( modules ) / sizeof( HMODULE ) );
+	for ( DWORD i = 0; i < count; ++i )
+	{
+		if ( modules[i] != opengl32 )
+			PatchModule( modules[i] );
+	}
+}
+
+void GlCallRecorder::SetScope( GlCallScope scope )
+{
+	// the host calls the plugins on its render thread only
+	g_render_thread = GetCurrentThreadId();
+	g_scope = recording_ ? scope : GL_SCOPE_NONE;
+}
+
+void GlCallRecorder::BeginFrame( int num_windows )
+{
+	num_windows_ = std::max( 1, num_windows );
+	memset( g_frame_counts, 0, sizeof( g_frame_counts ) );
+}
+
+void GlCallRecorder::EndFrame()
+{
+	g_scope = GL_SCOPE_NONE;
+	if ( recording_ )
+	{
+		++recorded_frames_;
+		for ( int scope = 0; scope < GL_SCOPE_COUNT; ++scope )
+		{
+			for ( int category = 0; category < GL_CALL_CATEGORY_COUNT; ++category )
+			{
+				const unsigned int calls = g_frame_counts[scope][category];
+				totals_[scope][category] += calls;
+				max_per_frame_[scope][category] = std::max( max_per_frame_[scope][category], calls );
+
+				const int budget = budgets_[scope].max_calls[category];
+				if ( budget >= 0 && calls > (unsigned int)budget * (unsigned int)num_windows_ )
+				{
+					Violation violation = { frame_, scope, category, calls, (unsigned int)budget * (unsigned int)num_windows_ };
+					violations_.push_back( violation );
+				}
+			}
+		}
+	}
+	++frame_;
+}
+
+bool GlCallRecorder::Report( std::ostream& out ) const
+{
+	if ( 0 == recorded_frames_ )
+		return violations_.empty();
+
+	out << std::fixed << std::setprecision( 1 );
+	for ( int scope = 0; scope < GL_SCOPE_COUNT; ++scope )
+	{
+		unsigned long long scope_total = 0;
+		for ( int category = 0; category < GL_CALL_CATEGORY_COUNT; ++category )
+			scope_total += totals_[scope][category];
+		if ( 0 == scope_total )
+			continue;
+
+		out << "PluginHost: GL calls per frame, " << kScopeNames[scope] << " (" << num_windows_ << " window(s))" << std::endl;
+		for ( int category = 0; category < GL_CALL_CATEGORY_COUNT; ++category )
+		{
+			out << "  " << std::left << std::setw( 12 ) << kCategoryNames[category] << std::right
+				<< " avg " << std::setw( 8 ) << (double)totals_[scope][category] / (double)recorded_frames_
+				<< "  max " << std::setw( 6 ) << max_per_frame_[scope][category];
+			if ( budgets_[scope].max_calls[category] >= 0 )
+				out << "  budget " << budgets_[scope].max_calls[category] * num_windows_;
+			out << std::endl;
+		}
+
+		std::vector<std::pair<unsigned long long, int> > ranked;
+		for ( int fn = 0; fn < FN_COUNT; ++fn )
+		{
+			if ( g_function_counts[scope][fn] )
+				ranked.push_back( std::make_pair( g_function_counts[scope][fn], fn ) );
+		}
+		std::sort( ranked.rbegin(), ranked.rend() );
+		for ( size_t i = 0; i < ranked.size() && i < 10; ++i )
+		{
+			out << "    " << std::left << std::setw( 36 ) << kFunctionNames[ranked[i].second] << std::right
+				<< std::setw( 10 ) << (double)ranked[i].first / (double)recorded_frames_ << " /frame" << std::endl;
+		}
+	}
+
+	// calls the categories cannot account for make any budget meaningless
+	bool unlisted_called = false;
+	for ( int scope = 0; scope < GL_SCOPE_COUNT; ++scope )
+	{
+		for ( size_t i = 0; i < g_unlisted.size(); ++i )
+		{
+			if ( 0 == g_unlisted_counts[i][scope] )
+				continue;
+			if ( !unlisted_called )
+				out << "PluginHost: Error: GL entry points the recorder does not list, add them to GlCallRecorder.cpp" << std::endl;
+			unlisted_called = true;
+			out << "    " << std::left << std::setw( 16 ) << kScopeNames[scope] << std::setw( 36 ) << g_unlisted[i].name << std::right
+				<< std::setw( 10 ) << (double)g_unlisted_counts[i][scope] / (double)recorded_frames_ << " /frame" << std::endl;
+		}
+	}
+
+	if ( !has_budgets_ )
+		return !unlisted_called;
+
+	if ( violations_.empty() && !unlisted_called )
+	{
+		out << "PluginHost: all GL call budgets met." << std::endl;
+		return true;
+	}
+
+	if ( violations_.empty() )
+		return false;
+
+	out << "PluginHost: Error: " << violations_.size() << " GL call budget violation(s)" << std::endl;
+	for ( size_t i = 0; i < violations_.size() && i < 20; ++i )
+	{
+		const Violation& v = violations_[i];
+		out << "  frame " << v.frame << ": " << kScopeNames[v.scope] << " made " << v.calls << " " << kCategoryNames[v.category]
+			<< " calls, budget " << v.budget << std::endl;
+	}
+	return false;
+}
@@ -0,0 +1,122 @@
+//==============================================================================
+// File:GlCallRecorder.h
+//==============================================================================
+//
+// Description: Counts the GL calls a plugin makes per frame. The recorder patches
+//				the opengl32.dll imports of every loaded module and hands out
+//				counting wrappers from wglGetProcAddress, so both the fixed-function
+//				entry points and the GLEW-resolved ones are seen. Calls are only
+//				attributed while the host has a plugin callback in flight. Entry
+//				points the recorder has no wrapper for are counted by name and
+//				fail the report, so none goes uncounted.
+//
+//==============================================================================
+
+#ifndef DVC_GL_CALL_RECORDER_H
+#define DVC_GL_CALL_RECORDER_H
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+enum GlCallCategory
+{
+	GL_CALL_STATE = 0,	// binds, enables, matrix stack, uniforms
+	GL_CALL_DRAW,		// draws, clears, blits, dispatches, immediate-mode vertices
+	GL_CALL_QUERY,		// glGet*, status checks, waits: anything that may sync with the driver
+	GL_CALL_ALLOCATION,	// object creation/deletion and storage (re)specification
+	GL_CALL_POLL,		// queries that never wait: fence polls with a zero timeout, query availability
+	GL_CALL_CATEGORY_COUNT
+};
+
+enum GlCallScope
+{
+	GL_SCOPE_NONE = -1,
+	GL_SCOPE_IMAGE_PROCESSOR = 0,
+	GL_SCOPE_OVERLAY,
+	GL_SCOPE_COUNT
+};
+
+/*!
+ * Per-window, per-frame call budgets of one plugin. A negative value means unlimited.
+**/
+struct GlCallBudget
+{
+	int max_calls[GL_CALL_CATEGORY_COUNT];
+
+	GlCallBudget() { for ( int i = 0; i < GL_CALL_CATEGORY_COUNT; ++i ) max_calls[i] = -1; }
+};
+
+class GlCallRecorder
+{
+public:
+	GlCallRecorder();
+
+	/*!
+	 * Loads per-plugin budgets from an XML file:
+	 *   <gl_budgets>
+	 *     <plugin name="image_processor" state="40" draw="8" query="2" allocation="0" poll="2"/>
+	 *     <plugin name="overlay" state="60" draw="20" query="1" allocation="0"/>
+	 *   </gl_budgets>
+	 *
+	 * @return
+	 *  false if the file could not be read.
+	**/
+	bool LoadBudgets( const char* filename );
+
+	/*!
+	 * Writes the most calls any recorded frame made per window, by plugin and category, in the
+	 * format LoadBudgets reads.
+	 *
+	 * @return
+	 *  false if the file could not be written.
+	**/
+	bool WriteBudgets( const char* filename ) const;
+
+	/*!
+	 * Patches the GL imports of all modules currently loaded in the process. Call again after
+	 * loading further modules; already patched imports are left alone.
+	**/
+	void Install();
+
+	void SetRecording( bool recording ) { recording_ = recording; }
+
+	/*!
+	 * Attributes the following GL calls to a plugin. Only calls made on the thread that sets the
+	 * scope are counted, the GL work of the plugins' own threads is not part of a callback.
+	**/
+	void SetScope( GlCallScope scope );
+	void BeginFrame( int num_windows );
+	void EndFrame();
+
+	/*!
+	 * Prints per-frame averages by category and the most frequent calls per plugin, then every
+	 * entry point the recorder does not list and every budget violation.
+	 *
+	 * @return
+	 *  true if no recorded frame exceeded a budget and no plugin called an unlisted entry point.
+	**/
+	bool Report( std::ostream& out ) const;
+
+private:
+	struct Violation
+	{
+		int frame;
+		int scope;
+		int category;
+		unsigned int calls;
+		unsigned int budget;
+	};
+
+	bool recording_;
+	bool has_budgets_;
+	int frame_;
+	int recorded_frames_;
+	int num_windows_;
+	GlCallBudget budgets_[GL_SCOPE_COUNT];
+	unsigned long long totals_[GL_SCOPE_COUNT][GL_CALL_CATEGORY_COUNT];
+	unsigned int max_per_frame_[GL_SCOPE_COUNT][GL_CALL_CATEGORY_COUNT];
+	std::vector<Violation> violations_;
+};
+
+#endif // DVC_GL_CALL_RECORDER_H
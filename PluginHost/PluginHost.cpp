@@ -0,0 +1,613 @@
+//==============================================================================
+// File:PluginHost.cpp
+//==============================================================================
+//
+// Description: Stand-in for the GenesisIG render loop. Loads an image processor
+//				and/or an overlay plugin through their exported factories, replays
+//				the IG's callback sequence for N windows and views on a hidden,
+//				vsync-free GL context and reports the CPU time spent inside the
+//				plugins only (host-side GL work is excluded from the numbers).
+//
+//==============================================================================
+
+#include <SDKDDKVer.h>
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+
+#include "GL/glew.h"
+#include "GL/wglew.h"
+
+#include "GlCallRecorder.h"
+
+#include "gig/GenesisIG_UserDefined_ImageProcessor200.h"
+#include "gig/GenesisIG_UserDefined_Overlay200.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	typedef IUserDefinedImageProcessor200* ( *CreateImageProcessorFn )();
+	typedef void ( *DeleteImageProcessorFn )( IUserDefinedImageProcessor200* );
+	typedef IUserDefinedOverlay200* ( *CreateOverlayFn )();
+	typedef void ( *DeleteOverlayFn )( IUserDefinedOverlay200* );
+
+	enum HostCallback
+	{
+		CB_IP_UPDATE = 0,
+		CB_IP_SET_ACTIVE_WINDOW,
+		CB_IP_SET_ACTIVE_VIEW,
+		CB_IP_PRE_WINDOW_PROCESS,
+		CB_IP_PRE_VIEW_PROCESS,
+		CB_IP_GET_CLIP_PLANES,
+		CB_IP_GET_VIEWPORT,
+		CB_IP_GET_MODEL_VIEW_OFFSETS,
+		CB_IP_POST_VIEW_PROCESS,
+		CB_IP_POST_WINDOW_PROCESS,
+		CB_OV_UPDATE,
+		CB_OV_SET_ACTIVE_WINDOW,
+		CB_OV_SET_ACTIVE_VIEW,
+		CB_OV_DRAW,
+		CB_OV_POST_FRAME_DRAW,
+		CB_COUNT
+	};
+
+	const char* const kCallbackNames[CB_COUNT] =
+	{
+		"ip::update",
+		"ip::setActiveWindow",
+		"ip::setActiveView",
+		"ip::preWindowProcess",
+		"ip::preViewProcess",
+		"ip::getClipPlanes",
+		"ip::getViewport",
+		"ip::getModelViewOffsets",
+		"ip::postViewProcess",
+		"ip::postWindowProcess",
+		"ov::update",
+		"ov::setActiveWindow",
+		"ov::setActiveView",
+		"ov::draw",
+		"ov::PostFrameDraw",
+	};
+
+	struct HostOptions
+	{
+		std::string image_processor_bin;
+		std::string image_processor_config;
+		std::string overlay_bin;
+		std::string overlay_config;
+		std::string gl_budget_file;
+		std::string gl_budget_output;
+		bool gl_record;
+		int num_windows;
+		int num_views;
+		int width;
+		int height;
+		int frames;
+		int warmup_frames;
+
+		HostOptions()
+			: gl_record( false )
+			, num_windows( 1 )
+			, num_views( 1 )
+			, width( 1920 )
+			, height( 1080 )
+			, frames( 1000 )
+			, warmup_frames( 60 )
+		{}
+	};
+
+	struct CallbackStats
+	{
+		unsigned long long calls;
+		double total_ms;
+		double max_ms;
+
+		CallbackStats() : calls( 0 ), total_ms( 0.0 ), max_ms( 0.0 ) {}
+	};
+
+	/*!
+	 * Accumulates plugin-only CPU time. Each callback is bracketed by Begin/End, everything the
+	 * host does between callbacks (clears, FBO binds, swaps) is not counted. With a GL call
+	 * recorder attached, the calls made inside the bracket are attributed to the calling plugin.
+	**/
+	class PluginClock
+	{
+	public:
+		PluginClock()
+			: recording_( false )
+			, frame_ms_( 0.0 )
+			, current_( CB_COUNT )
+			, recorder_( 0 )
+		{
+			LARGE_INTEGER freq;
+			QueryPerformanceFrequency( &freq );
+			ms_per_tick_ = 1000.0 / (double)freq.QuadPart;
+		}
+
+		void SetRecording( bool recording ) { recording_ = recording; }
+		void SetRecorder( GlCallRecorder* recorder ) { recorder_ = recorder; }
+
+		void Begin( HostCallback callback )
+		{
+			current_ = callback;
+			if ( recorder_ )
+				recorder_->SetScope( callback < CB_OV_UPDATE ? GL_SCOPE_IMAGE_PROCESSOR : GL_SCOPE_OVERLAY );
+			QueryPerformanceCounter( &start_ );
+		}
+
+		void End()
+		{
+			LARGE_INTEGER stop;
+			QueryPerformanceCounter( &stop );
+			if ( recorder_ )
+				recorder_->SetScope( GL_SCOPE_NONE );
+			if ( !recording_ )
+				return;
+
+			const double ms = (double)( stop.QuadPart - start_.QuadPart ) * ms_per_tick_;
+			CallbackStats& stats = stats_[current_];
+			++stats.calls;
+			stats.total_ms += ms;
+			stats.max_ms = std::max( stats.max_ms, ms );
+			frame_ms_ += ms;
+		}
+
+		void EndFrame()
+		{
+			if ( recording_ )
+				frame_times_ms_.push_back( frame_ms_ );
+			frame_ms_ = 0.0;
+		}
+
+		void Report( std::ostream& out ) const;
+
+	private:
+		bool recording_;
+		double ms_per_tick_;
+		double frame_ms_;
+		HostCallback current_;
+		GlCallRecorder* recorder_;
+		LARGE_INTEGER start_;
+		CallbackStats stats_[CB_COUNT];
+		std::vector<double> frame_times_ms_;
+	};
+
+	void PluginClock::Report( std::ostream& out ) const
+	{
+		out << std::fixed << std::setprecision( 3 );
+		out << "PluginHost: plugin CPU time per callback" << std::endl;
+		out << "  " << std::left << std::setw( 28 ) << "callback" << std::right
+			<< std::setw( 10 ) << "calls" << std::setw( 12 ) << "avg [us]" << std::setw( 12 ) << "max [us]" << std::setw( 12 ) << "ms/frame" << std::endl;
+
+		const double frames = frame_times_ms_.empty() ? 1.0 : (double)frame_times_ms_.size();
+		for ( int i = 0; i < CB_COUNT; ++i )
+		{
+			const CallbackStats& stats = stats_[i];
+			if ( 0 == stats.calls )
+				continue;
+			out << "  " << std::left << std::setw( 28 ) << kCallbackNames[i] << std::right
+				<< std::setw( 10 ) << stats.calls
+				<< std::setw( 12 ) << stats.total_ms * 1000.0 / (double)stats.calls
+				<< std::setw( 12 ) << stats.max_ms * 1000.0
+				<< std::setw( 12 ) << stats.total_ms / frames << std::endl;
+		}
+
+		if ( frame_times_ms_.empty() )
+			return;
+
+		std::vector<double> sorted( frame_times_ms_ );
+		std::sort( sorted.begin(), sorted.end() );
+		double sum = 0.0;
+		for ( size_t i = 0; i < sorted.size(); ++i )
+			sum += sorted[i];
+
+		out << "PluginHost: plugin CPU time per frame over " << sorted.size() << " frames" << std::endl;
+		out << "  avg " << sum / (double)sorted.size() << " ms"
+			<< ", median " << sorted[sorted.size() / 2] << " ms"
+			<< ", p99 " << sorted[std::min( sorted.size() - 1, sorted.size() * 99 / 100 )] << " ms"
+			<< ", max " << sorted.back() << " ms" << std::endl;
+	}
+
+	/*!
+	 * Hidden window with a compatibility GL context. Nothing is ever shown; the plugins render into
+	 * host-owned FBOs that stand in for the IG's window back buffers.
+	**/
+	class HeadlessContext
+	{
+	public:
+		HeadlessContext() : hwnd_( 0 ), hdc_( 0 ), hglrc_( 0 ) {}
+		~HeadlessContext() { Destroy(); }
+
+		bool Create();
+		void Destroy();
+
+	private:
+		static LRESULT CALLBACK WndProc( HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam ) { return DefWindowProcA( hwnd, msg, wparam, lparam ); }
+
+		HWND hwnd_;
+		HDC hdc_;
+		HGLRC hglrc_;
+	};
+
+	bool HeadlessContext::Create()
+	{
+		WNDCLASSA wc = { 0 };
+		wc.style = CS_OWNDC;
+		wc.lpfnWndProc = &HeadlessContext::WndProc;
+		wc.hInstance = GetModuleHandleA( NULL );
+		wc.lpszClassName = "DVC_PluginHost";
+		RegisterClassA( &wc );
+
+		hwnd_ = CreateWindowExA( 0, wc.lpszClassName, "PluginHost", WS_OVERLAPPEDWINDOW | WS_CLIPSIBLINGS | WS_CLIPCHILDREN, 0, 0, 64, 64, NULL, NULL, wc.hInstance, NULL );
+		if ( !hwnd_ )
+			return false;
+		hdc_ = GetDC( hwnd_ );
+
+		PIXELFORMATDESCRIPTOR pfd = { 0 };
+		pfd.nSize = sizeof( pfd );
+		pfd.nVersion = 1;
+		pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL | PFD_DOUBLEBUFFER;
+		pfd.iPixelType = PFD_TYPE_RGBA;
+		pfd.cColorBits = 32;
+		pfd.cDepthBits = 24;
+		pfd.cStencilBits = 8;
+		pfd.iLayerType = PFD_MAIN_PLANE;
+		const int format = ChoosePixelFormat( hdc_, &pfd );
+		if ( !format || !SetPixelFormat( hdc_, format, &pfd ) )
+			return false;
+
+		// legacy context on purpose: both plugins still use the fixed-function pipeline
+		hglrc_ = wglCreateContext( hdc_ );
+		if ( !hglrc_ || !wglMakeCurrent( hdc_, hglrc_ ) )
+			return false;
+
+		glewExperimental = GL_TRUE;
+		if ( GLEW_OK != glewInit() )
+			return false;
+
+		if ( WGLEW_EXT_swap_control )
+			wglSwapIntervalEXT( 0 );
+
+		std::cout << "PluginHost: GL " << glGetString( GL_VERSION ) << " on " << glGetString( GL_RENDERER ) << std::endl;
+		return true;
+	}
+
+	void HeadlessContext::Destroy()
+	{
+		if ( hglrc_ )
+		{
+			wglMakeCurrent( NULL, NULL );
+			wglDeleteContext( hglrc_ );
+			hglrc_ = 0;
+		}
+		if ( hdc_ )
+		{
+			ReleaseDC( hwnd_, hdc_ );
+			hdc_ = 0;
+		}
+		if ( hwnd_ )
+		{
+			DestroyWindow( hwnd_ );
+			hwnd_ = 0;
+		}
+	}
+
+	/*!
+	 * Per-window GL objects the IG would own: the window back buffer (here an offscreen FBO the
+	 * warp renders into) and the scene FBO wrapping the image processor's render target textures.
+	**/
+	struct HostWindow
+	{
+		int id;
+		int extents[2];
+		GLuint output_fbo;
+		GLuint output_color;
+		GLuint scene_fbo;
+
+		HostWindow() : id( 0 ), output_fbo( 0 ), output_color( 0 ), scene_fbo( 0 ) { extents[0] = extents[1] = 0; }
+	};
+
+	void CreateOutput( HostWindow& window )
+	{
+		glGenTextures( 1, &window.output_color );
+		glBindTexture( GL_TEXTURE_2D, window.output_color );
+		glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA8, window.extents[0], window.extents[1], 0, GL_RGBA, GL_UNSIGNED_BYTE, 0 );
+		glBindTexture( GL_TEXTURE_2D, 0 );
+
+		glGenFramebuffers( 1, &window.output_fbo );
+		glBindFramebuffer( GL_FRAMEBUFFER, window.output_fbo );
+		glFramebufferTexture2D( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, window.output_color, 0 );
+		glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	}
+
+	void AttachSceneTarget( HostWindow& window, const RenderTargetTextureParameters& texture_params )
+	{
+		if ( !window.scene_fbo )
+			glGenFramebuffers( 1, &window.scene_fbo );
+		glBindFramebuffer( GL_FRAMEBUFFER, window.scene_fbo );
+		glFramebufferTexture( GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, texture_params.color_texture_id, 0 );
+		glFramebufferTexture( GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_params.depth_texture_id, 0 );
+		glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+	}
+
+	void DestroyWindowObjects( HostWindow& window )
+	{
+		if ( window.scene_fbo )		glDeleteFramebuffers( 1, &window.scene_fbo );
+		if ( window.output_fbo )	glDeleteFramebuffers( 1, &window.output_fbo );
+		if ( window.output_color )	glDeleteTextures( 1, &window.output_color );
+	}
+
+	template <typename T>
+	T LoadExport( HMODULE module, const char* name )
+	{
+		return reinterpret_cast<T>( GetProcAddress( module, name ) );
+	}
+
+	void PrintUsage()
+	{
+		std::cout <<
+			"usage: PluginHost [options]\n"
+			"  --image-processor <dll> [config.xml]  image processor plugin, e.g. VIOSO-Plugin.dll\n"
+			"  --overlay <dll> [config.xml]          overlay plugin, e.g. 3D_Overlay.dll\n"
+			"  --windows <n>                         number of windows (ids 1..n), default 1\n"
+			"  --views <n>                           views per window, default 1\n"
+			"  --size <width> <height>               window extents, default 1920 1080\n"
+			"  --frames <n>                          measured frames, default 1000\n"
+			"  --warmup <n>                          unmeasured frames first, default 60\n"
+			"  --gl-record                           count GL calls per plugin and category\n"
+			"  --gl-budget <budgets.xml>             as --gl-record, exit with code 2 if a budget is exceeded\n"
+			"  --gl-budget-write <budgets.xml>       as --gl-record, write the measured calls per window as budgets\n";
+	}
+
+	bool IsOption( const char* arg ) { return 0 == strncmp( arg, "--", 2 ); }
+
+	bool ParseArguments( int argc, char** argv, HostOptions& options )
+	{
+		for ( int i = 1; i < argc; ++i )
+		{
+			const std::string arg = argv[i];
+			const bool has_value = i + 1 < argc && !IsOption( argv[i + 1] );
+			if ( "--image-processor" == arg && has_value )
+			{
+				options.image_processor_bin = argv[++i];
+				if ( i + 1 < argc && !IsOption( argv[i + 1] ) )
+					options.image_processor_config = argv[++i];
+			}
+			else if ( "--overlay" == arg && has_value )
+			{
+				options.overlay_bin = argv[++i];
+				if ( i + 1 < argc && !IsOption( argv[i + 1] ) )
+					options.overlay_config = argv[++i];
+			}
+			else if ( "--windows" == arg && has_value )	options.num_windows = std::max( 1, atoi( argv[++i] ) );
+			else if ( "--views" == arg && has_value )	options.num_views = std::max( 1, atoi( argv[++i] ) );
+			else if ( "--frames" == arg && has_value )	options.frames = std::max( 1, atoi( argv[++i] ) );
+			else if ( "--warmup" == arg && has_value )	options.warmup_frames = std::max( 0, atoi( argv[++i] ) );
+			else if ( "--gl-record" == arg )				options.gl_record = true;
+			else if ( "--gl-budget" == arg && has_value )
+			{
+				options.gl_budget_file = argv[++i];
+				options.gl_record = true;
+			}
+			else if ( "--gl-budget-write" == arg && has_value )
+			{
+				options.gl_budget_output = argv[++i];
+				options.gl_record = true;
+			}
+			else if ( "--size" == arg && i + 2 < argc )
+			{
+				options.width = std::max( 1, atoi( argv[++i] ) );
+				options.height = std::max( 1, atoi( argv[++i] ) );
+			}
+			else
+			{
+				std::cout << "PluginHost: Error: unknown or incomplete option " << arg << std::endl;
+				return false;
+			}
+		}
+
+		if ( options.image_processor_bin.empty() && options.overlay_bin.empty() )
+		{
+			std::cout << "PluginHost: Error: nothing to run, specify --image-processor and/or --overlay" << std::endl;
+			return false;
+		}
+		return true;
+	}
+}
+
+int main( int argc, char** argv )
+{
+	HostOptions options;
+	if ( !ParseArguments( argc, argv, options ) )
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	HMODULE ip_module = 0;
+	HMODULE ov_module = 0;
+	IUserDefinedImageProcessor200* ip = 0;
+	IUserDefinedOverlay200* ov = 0;
+	DeleteImageProcessorFn delete_ip = 0;
+	DeleteOverlayFn delete_ov = 0;
+
+	if ( !options.image_processor_bin.empty() )
+	{
+		ip_module = LoadLibraryA( options.image_processor_bin.c_str() );
+		CreateImageProcessorFn create_ip = ip_module ? LoadExport<CreateImageProcessorFn>( ip_module, GIG_CREATE_IMAGEPROCESSOR_PLUGIN ) : 0;
+		delete_ip = ip_module ? LoadExport<DeleteImageProcessorFn>( ip_module, GIG_DELETE_IMAGEPROCESSOR_PLUGIN ) : 0;
+		if ( !create_ip || !delete_ip || !( ip = create_ip() ) )
+		{
+			std::cout << "PluginHost: Error: could not load image processor " << options.image_processor_bin << " (error " << GetLastError() << ")" << std::endl;
+			return 1;
+		}
+	}
+
+	if ( !options.overlay_bin.empty() )
+	{
+		ov_module = LoadLibraryA( options.overlay_bin.c_str() );
+		CreateOverlayFn create_ov = ov_module ? LoadExport<CreateOverlayFn>( ov_module, GIG_CREATE_OVERLAY_PLUGIN ) : 0;
+		delete_ov = ov_module ? LoadExport<DeleteOverlayFn>( ov_module, GIG_DELETE_OVERLAY_PLUGIN ) : 0;
+		if ( !create_ov || !delete_ov || !( ov = create_ov() ) )
+		{
+			std::cout << "PluginHost: Error: could not load overlay " << options.overlay_bin << " (error " << GetLastError() << ")" << std::endl;
+			return 1;
+		}
+	}
+
+	GlCallRecorder recorder;
+	if ( !options.gl_budget_file.empty() && !recorder.LoadBudgets( options.gl_budget_file.c_str() ) )
+		return 1;
+
+	// the IG initializes plugins before it has a GL context
+	if ( ip && ip->initialize( options.image_processor_config.empty() ? 0 : options.image_processor_config.c_str() ) <= 0 )
+	{
+		std::cout << "PluginHost: Error: image processor initialize failed" << std::endl;
+		return 1;
+	}
+	if ( ov && ov->initialize( options.overlay_config.empty() ? 0 : options.overlay_config.c_str() ) <= 0 )
+	{
+		std::cout << "PluginHost: Error: overlay initialize failed" << std::endl;
+		return 1;
+	}
+
+	// after initialize, so libraries the plugins load themselves (VIOSOWarpBlend) are patched too,
+	// and before any context exists, so every GLEW instance resolves to the recording wrappers
+	if ( options.gl_record )
+		recorder.Install();
+
+	HeadlessContext context;
+	if ( !context.Create() )
+	{
+		std::cout << "PluginHost: Error: could not create a GL context" << std::endl;
+		return 1;
+	}
+
+	if ( ( ip && ip->initializeGraphics() <= 0 ) || ( ov && ov->initializeGraphics() <= 0 ) )
+	{
+		std::cout << "PluginHost: Error: initializeGraphics failed" << std::endl;
+		return 1;
+	}
+
+	std::vector<HostWindow> windows( options.num_windows );
+	for ( int w = 0; w < options.num_windows; ++w )
+	{
+		windows[w].id = w + 1;
+		windows[w].extents[0] = options.width;
+		windows[w].extents[1] = options.height;
+		CreateOutput( windows[w] );
+	}
+
+	std::cout << "PluginHost: running " << options.warmup_frames << " + " << options.frames << " frames, "
+		<< options.num_windows << " window(s) x " << options.num_views << " view(s) at " << options.width << "x" << options.height << std::endl;
+
+	PluginClock clock;
+	if ( options.gl_record )
+	{
+		clock.SetRecorder( &recorder );
+		std::cout << "PluginHost: GL call recording enabled, CPU times include the recording overhead." << std::endl;
+	}
+	const float frame_delta_time = 1.0f / 60.0f;
+	const bool ip_binds_target = ip && ip->PluginBindsRenderTarget();
+
+	for ( int frame = 0; frame < options.warmup_frames + options.frames; ++frame )
+	{
+		clock.SetRecording( frame >= options.warmup_frames );
+		recorder.SetRecording( frame >= options.warmup_frames );
+		recorder.BeginFrame( options.num_windows );
+
+		if ( ip ) { clock.Begin( CB_IP_UPDATE ); ip->update( frame_delta_time ); clock.End(); }
+		if ( ov ) { clock.Begin( CB_OV_UPDATE ); ov->update( frame_delta_time ); clock.End(); }
+
+		for ( size_t w = 0; w < windows.size(); ++w )
+		{
+			HostWindow& window = windows[w];
+			glBindFramebuffer( GL_FRAMEBUFFER, window.output_fbo );
+
+			if ( ip ) { clock.Begin( CB_IP_SET_ACTIVE_WINDOW ); ip->setActiveWindow( window.id, window.extents ); clock.End(); }
+			if ( ov ) { clock.Begin( CB_OV_SET_ACTIVE_WINDOW ); ov->setActiveWindow( window.id, window.extents ); clock.End(); }
+
+			if ( ip_binds_target )
+			{
+				RenderTargetTextureParameters texture_params = { 0, 0, 0 };
+				if ( ip->GetRenderTargetTextureParameters( texture_params ) )
+					AttachSceneTarget( window, texture_params );
+			}
+
+			if ( ip ) { clock.Begin( CB_IP_PRE_WINDOW_PROCESS ); ip->preWindowProcess(); clock.End(); }
+
+			for ( int v = 0; v < options.num_views; ++v )
+			{
+				const int view_width = window.extents[0] / options.num_views;
+				int viewport[4] = { v * view_width, 0, view_width, window.extents[1] };
+
+				if ( ip ) { clock.Begin( CB_IP_SET_ACTIVE_VIEW ); ip->setActiveView( v, viewport ); clock.End(); }
+				if ( ov ) { clock.Begin( CB_OV_SET_ACTIVE_VIEW ); ov->setActiveView( v, viewport ); clock.End(); }
+
+				if ( ip ) { clock.Begin( CB_IP_PRE_VIEW_PROCESS ); ip->preViewProcess(); clock.End(); }
+
+				if ( ip && ip->useClipPlanes() )
+				{
+					FrustumParameters frustum_params;
+					clock.Begin( CB_IP_GET_CLIP_PLANES ); ip->getClipPlanes( frustum_params ); clock.End();
+				}
+				if ( ip && ip->useViewport() )
+				{
+					clock.Begin( CB_IP_GET_VIEWPORT ); ip->getViewport( viewport ); clock.End();
+				}
+				if ( ip && ip->useModelViewOffsets() )
+				{
+					clock.Begin( CB_IP_GET_MODEL_VIEW_OFFSETS ); ip->getModelViewOffsets(); clock.End();
+				}
+
+				// stand-in for the IG's scene pass
+				if ( window.scene_fbo )
+					glBindFramebuffer( GL_FRAMEBUFFER, window.scene_fbo );
+				glViewport( viewport[0], viewport[1], viewport[2], viewport[3] );
+				glClearColor( 0.2f, 0.3f, 0.5f, 1.0f );
+				glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
+
+				if ( ov ) { clock.Begin( CB_OV_DRAW ); ov->draw(); clock.End(); }
+
+				if ( ip ) { clock.Begin( CB_IP_POST_VIEW_PROCESS ); ip->postViewProcess(); clock.End(); }
+			}
+
+			glBindFramebuffer( GL_FRAMEBUFFER, window.output_fbo );
+			if ( ip ) { clock.Begin( CB_IP_POST_WINDOW_PROCESS ); ip->postWindowProcess(); clock.End(); }
+			if ( ov ) { clock.Begin( CB_OV_POST_FRAME_DRAW ); ov->PostFrameDraw(); clock.End(); }
+		}
+
+		glBindFramebuffer( GL_FRAMEBUFFER, 0 );
+		glFlush();
+		clock.EndFrame();
+		recorder.EndFrame();
+	}
+
+	glFinish();
+	clock.Report( std::cout );
+	const bool budgets_met = !options.gl_record || recorder.Report( std::cout );
+	if ( !options.gl_budget_output.empty() )
+		recorder.WriteBudgets( options.gl_budget_output.c_str() );
+
+	if ( ip ) ip->shutdown();
+	if ( ov ) ov->shutdown();
+
+	for ( size_t w = 0; w < windows.size(); ++w )
+		DestroyWindowObjects( windows[w] );
+
+	if ( ip ) delete_ip( ip );
+	if ( ov ) delete_ov( ov );
+	context.Destroy();
+
+	if ( ov_module ) FreeLibrary( ov_module );
+	if ( ip_module ) FreeLibrary( ip_module );
+
+	return budgets_met ? 0 : 2;
+}